@@ -0,0 +1,198 @@
+#! /usr/bin/env python3
+"""/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+Runs libunicode_benchmark and detects throughput regressions against a stored JSON baseline.
+
+    benchmark-regression.py baseline --benchmark BIN --dir DIR   # runs and stores DIR/baseline.json
+    benchmark-regression.py check --benchmark BIN --dir DIR      # runs, stores DIR/current.json and compares
+    benchmark-regression.py compare BASELINE.json CURRENT.json   # compares two stored runs
+
+A benchmark regresses if its median throughput dropped by more than the threshold and the
+drop is significant (two-sided Mann-Whitney U test over the repetitions, p < alpha).
+Exits with 1 on regressions, without requiring anything but Python's standard library.
+"""
+
+import argparse
+import json
+import math
+import os
+import statistics
+import subprocess
+import sys
+
+TIME_UNITS = {'ns': 1e-9, 'us': 1e-6, 'ms': 1e-3, 's': 1.0}
+
+
+def run_benchmark(args, output_file):
+    """Runs the benchmark binary with repetitions, pinned to a single CPU, writing JSON to output_file."""
+    os.makedirs(os.path.dirname(os.path.abspath(output_file)), exist_ok=True)
+    command = [
+        args.benchmark,
+        f'--benchmark_filter={args.filter}',
+        f'--benchmark_repetitions={args.repetitions}',
+        f'--benchmark_min_time={args.min_time}',
+        '--benchmark_enable_random_interleaving=true',
+        f'--benchmark_out={output_file}',
+        '--benchmark_out_format=json',
+    ]
+
+    def pin():
+        if args.cpu is not None and hasattr(os, 'sched_setaffinity'):
+            os.sched_setaffinity(0, {args.cpu})
+
+    if args.cpu is not None and not hasattr(os, 'sched_setaffinity'):
+        print('CPU pinning is not supported on this platform, running unpinned.', file=sys.stderr)
+    subprocess.run(command, check=True, preexec_fn=pin if os.name == 'posix' else None)
+
+
+def load_throughputs(file_name):
+    """Returns the throughput of each repetition, per benchmark name, and the run's context."""
+    with open(file_name, encoding='utf-8') as file:
+        report = json.load(file)
+    throughputs = {}
+    for run in report['benchmarks']:
+        if run.get('run_type', 'iteration') != 'iteration' or run.get('error_occurred'):
+            continue
+        if 'bytes_per_second' in run:
+            value = run['bytes_per_second']
+        elif 'items_per_second' in run:
+            value = run['items_per_second']
+        else:
+            value = 1.0 / (run['real_time'] * TIME_UNITS[run.get('time_unit', 'ns')])
+        throughputs.setdefault(run.get('run_name', run['name']), []).append(value)
+    return throughputs, report.get('context', {})
+
+
+def mann_whitney_u(a, b):
+    """Returns the two-sided p-value of the Mann-Whitney U test (normal approximation, tie corrected)."""
+    n1, n2 = len(a), len(b)
+    values = sorted([(value, 0) for value in a] + [(value, 1) for value in b])
+    n = n1 + n2
+    rank_sum = 0.0
+    tie_term = 0.0
+    i = 0
+    while i < n:
+        j = i
+        while j + 1 < n and values[j + 1][0] == values[i][0]:
+            j += 1
+        rank = (i + j) / 2.0 + 1.0
+        rank_sum += rank * sum(1 for k in range(i, j + 1) if values[k][1] == 0)
+        ties = j - i + 1
+        tie_term += ties ** 3 - ties
+        i = j + 1
+    u1 = rank_sum - n1 * (n1 + 1) / 2.0
+    variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u1 - n1 * n2 / 2.0) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2.0))
+
+
+def format_throughput(value):
+    """Formats a throughput in the units Google Benchmark uses."""
+    for unit, scale in (('G', 1024.0 ** 3), ('M', 1024.0 ** 2), ('k', 1024.0)):
+        if value >= scale:
+            return f'{value / scale:.2f}{unit}/s'
+    return f'{value:.2f}/s'
+
+
+def compare(baseline_file, current_file, threshold, alpha):
+    """Prints a comparison report and returns whether any benchmark regressed."""
+    baseline, baseline_context = load_throughputs(baseline_file)
+    current, current_context = load_throughputs(current_file)
+    for key in ('host_name', 'library_build_type'):
+        if baseline_context.get(key) != current_context.get(key):
+            print(f'note: {key} differs: {baseline_context.get(key)} (baseline) vs. {current_context.get(key)}')
+
+    name_width = max((len(name) for name in baseline), default=9)
+    print(f'{"Benchmark":<{name_width}}  {"Baseline":>12}  {"Current":>12}  {"Change":>8}  {"p":>7}  Status')
+    regressions = []
+    for name, before in baseline.items():
+        after = current.get(name)
+        if not after:
+            print(f'{name:<{name_width}}  {"":>12}  {"":>12}  {"":>8}  {"":>7}  missing')
+            continue
+        before_median = statistics.median(before)
+        after_median = statistics.median(after)
+        change = (after_median - before_median) / before_median * 100.0
+        p_value = mann_whitney_u(before, after)
+        if p_value >= alpha:
+            status = 'ok' if abs(change) <= threshold else 'noise'
+        elif change < -threshold:
+            status = 'REGRESSION'
+            regressions.append(name)
+        elif change > threshold:
+            status = 'faster'
+        else:
+            status = 'ok'
+        print(f'{name:<{name_width}}  {format_throughput(before_median):>12}  {format_throughput(after_median):>12}  '
+              f'{change:>+7.1f}%  {p_value:>7.4f}  {status}')
+    for name in current:
+        if name not in baseline:
+            print(f'{name:<{name_width}}  {"":>12}  {"":>12}  {"":>8}  {"":>7}  new')
+
+    if min(map(len, baseline.values()), default=0) < 4 or min(map(len, current.values()), default=0) < 4:
+        print('note: fewer than 4 repetitions per benchmark cannot show significant changes.')
+    if regressions:
+        print(f'\n{len(regressions)} benchmark(s) regressed by more than {threshold}% (p < {alpha}):')
+        for name in regressions:
+            print(f'  {name}')
+    else:
+        print(f'\nNo throughput regressed by more than {threshold}% (p < {alpha}).')
+    return bool(regressions)
+
+
+def main():
+    """Parses the command line and runs the requested command."""
+    parser = argparse.ArgumentParser(description='Detects libunicode benchmark throughput regressions.')
+    commands = parser.add_subparsers(dest='command', required=True)
+    for command in ('baseline', 'check'):
+        sub = commands.add_parser(command)
+        sub.add_argument('--benchmark', required=True, help='path to libunicode_benchmark')
+        sub.add_argument('--dir', required=True, help='directory for baseline.json and current.json')
+        sub.add_argument('--filter', default='^corpus', help='benchmarks to run (regular expression)')
+        sub.add_argument('--repetitions', type=int, default=10)
+        sub.add_argument('--min-time', default='0.1', help='minimum time per repetition, in seconds')
+        sub.add_argument('--cpu', type=int, help='CPU to pin the benchmark to (default: first allowed CPU)')
+        sub.add_argument('--threshold', type=float, default=5.0, help='regression threshold in percent')
+        sub.add_argument('--alpha', type=float, default=0.05, help='significance level')
+    sub = commands.add_parser('compare')
+    sub.add_argument('baseline')
+    sub.add_argument('current')
+    sub.add_argument('--threshold', type=float, default=5.0, help='regression threshold in percent')
+    sub.add_argument('--alpha', type=float, default=0.05, help='significance level')
+    args = parser.parse_args()
+
+    if args.command == 'compare':
+        return 1 if compare(args.baseline, args.current, args.threshold, args.alpha) else 0
+
+    if args.cpu is None and hasattr(os, 'sched_getaffinity'):
+        args.cpu = min(os.sched_getaffinity(0))
+    baseline_file = os.path.join(args.dir, 'baseline.json')
+    if args.command == 'baseline':
+        run_benchmark(args, baseline_file)
+        print(f'Stored baseline in {baseline_file}')
+        return 0
+
+    if not os.path.exists(baseline_file):
+        print(f'No baseline in {baseline_file}, create one first (benchmark_baseline target).', file=sys.stderr)
+        return 2
+    current_file = os.path.join(args.dir, 'current.json')
+    run_benchmark(args, current_file)
+    return 1 if compare(baseline_file, current_file, args.threshold, args.alpha) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,13 +1,83 @@
+#include <libunicode/benchmark_corpus.h>
+#include <libunicode/benchmark_perf_counters.h>
+#include <libunicode/byte_ring.h>
+#include <libunicode/capi.h>
+#include <libunicode/codepoint_overlay.h>
+#include <libunicode/codepoint_versions.h>
+#include <libunicode/compact_line.h>
 #include <libunicode/convert.h>
+#include <libunicode/instrumentation.h>
+#include <libunicode/line_index.h>
+#include <libunicode/profiler.h>
 #include <libunicode/scan.h>
+#include <libunicode/script_segmenter.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/stream_segmenter.h>
 #include <libunicode/utf8.h>
+#include <libunicode/utf8_grapheme_segmenter.h>
+#include <libunicode/views.h>
+#include <libunicode/vt_scan.h>
+#include <libunicode/width.h>
 
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
+    #include <libunicode/run_segmenter.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ranges>
+#include <set>
+#include <sstream>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
+using std::string;
 using std::string_view;
 
+// Hardware performance counters, enabled via --perf-counters.
+static std::unique_ptr<unicode::benchmark_perf::counters> perfCounters;
+
+// Starts the hardware performance counters, if enabled, right before a benchmark's timed loop.
+static void startPerfCounters()
+{
+    if (perfCounters)
+        perfCounters->start();
+}
+
+static unicode::benchmark_perf::counters::values stopPerfCounters()
+{
+    return perfCounters ? perfCounters->stop() : unicode::benchmark_perf::counters::values {};
+}
+
+// Reports each available counter per unit, e.g. as "cycles/byte", given the units processed per iteration.
+static void reportPerfCounters(benchmark::State& benchmarkState,
+                               unicode::benchmark_perf::counters::values const& counted,
+                               string_view unit,
+                               size_t unitsPerIteration)
+{
+    auto const units = static_cast<double>(benchmarkState.iterations()) * static_cast<double>(unitsPerIteration);
+    for (size_t i = 0; i < counted.size(); ++i)
+        if (counted[i] && units != 0)
+        {
+            auto const name = string(unicode::benchmark_perf::name(unicode::benchmark_perf::all_events[i])) + "/" + string(unit);
+            benchmarkState.counters[name] = *counted[i] / units;
+        }
+}
+
 template <size_t L>
 static void benchmarkWithLength(benchmark::State& benchmarkState)
 {
@@ -63,5 +133,1023 @@ BENCHMARK(benchmarkWithOffset<120>);
 BENCHMARK(benchmarkWithOffset<125>);
 BENCHMARK(benchmarkWithOffset<130>);
 
-// Run the benchmark
-BENCHMARK_MAIN();
+// Mimics `ls --color` output: short file names, each wrapped into SGR sequences.
+static string lsColorOutput()
+{
+    auto text = string {};
+    for (int i = 0; i < 2000; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0: text += "\033[0m\033[01;34mdirectory" + std::to_string(i) + "\033[0m  "; break;
+            case 1: text += "\033[01;32mscript" + std::to_string(i) + ".sh\033[0m  "; break;
+            default: text += "file" + std::to_string(i) + ".txt  "; break;
+        }
+        if (i % 6 == 5)
+            text += "\r\n";
+    }
+    return text;
+}
+
+// Mimics colored compiler diagnostics, including some non-ASCII quotation marks.
+static string compilerOutput()
+{
+    auto text = string {};
+    for (int i = 0; i < 500; ++i)
+    {
+        auto const line = std::to_string(i + 10);
+        text += "\033[1msrc/module" + std::to_string(i) + ".cpp:" + line + ":17: \033[0m";
+        text += "\033[1;31merror: \033[0m\033[1mno member named \xE2\x80\x98value\xE2\x80\x99 in \xE2\x80\x98" "foo\xE2\x80\x99\033[0m\r\n";
+        text += "   " + line + " |     auto const x = foo.value(bar, baz);\r\n";
+        text += "      |                    \033[0;32m^~~~~\033[0m\r\n";
+    }
+    return text;
+}
+
+// Processes the text the classic way: hand control back at every control byte and skip the escape sequence.
+static void scanTextPerSequence(benchmark::State& benchmarkState, string const& text)
+{
+    for (auto _: benchmarkState)
+    {
+        auto state = unicode::scan_state {};
+        auto input = string_view(text);
+        size_t columns = 0;
+        while (!input.empty())
+        {
+            state.next = input.data();
+            columns += unicode::scan_text(state, input, std::numeric_limits<size_t>::max()).count;
+            input.remove_prefix(static_cast<size_t>(state.next - input.data()));
+            if (input.empty())
+                break;
+            if (input.front() == '\033' && input.size() > 1 && input[1] == '[')
+            {
+                size_t i = 2;
+                while (i < input.size() && static_cast<uint8_t>(input[i]) < 0x40)
+                    ++i;
+                input.remove_prefix(std::min(i + 1, input.size()));
+            }
+            else
+                input.remove_prefix(1);
+        }
+        benchmark::DoNotOptimize(columns);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+static void scanVT(benchmark::State& benchmarkState, string const& text)
+{
+    auto events = std::array<unicode::vt_event, 256> {};
+    for (auto _: benchmarkState)
+    {
+        auto state = unicode::vt_scan_state {};
+        auto input = string_view(text);
+        size_t eventCount = 0;
+        while (!input.empty())
+        {
+            auto const result = unicode::scan_vt(state, input, events);
+            eventCount += result.eventCount;
+            input.remove_prefix(static_cast<size_t>(result.next - input.data()));
+        }
+        benchmark::DoNotOptimize(eventCount);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+BENCHMARK_CAPTURE(scanTextPerSequence, ls_color, lsColorOutput());
+BENCHMARK_CAPTURE(scanVT, ls_color, lsColorOutput());
+BENCHMARK_CAPTURE(scanTextPerSequence, compiler_output, compilerOutput());
+BENCHMARK_CAPTURE(scanVT, compiler_output, compilerOutput());
+
+// Log-file like text of the given size, with some lines containing non-ASCII characters.
+static string const& logFile(size_t size)
+{
+    static auto cache = std::map<size_t, string> {};
+    auto& text = cache[size];
+    if (text.empty())
+    {
+        text.reserve(size + 200);
+        for (size_t i = 0; text.size() < size; ++i)
+        {
+            text += "2023-11-27T12:34:56.789 [info] request " + std::to_string(i) + " served in 12ms";
+            if (i % 20 == 0)
+                text += " \xE2\x80\x94 na\xC3\xAFve caf\xC3\xA9";
+            text += '\n';
+        }
+    }
+    return text;
+}
+
+// Finds lines with memchr() and measures each with scan_text().
+static void lineIndexScanText(benchmark::State& benchmarkState)
+{
+    auto const& text = logFile(static_cast<size_t>(benchmarkState.range(0)));
+    for (auto _: benchmarkState)
+    {
+        size_t columns = 0;
+        auto input = string_view(text);
+        while (!input.empty())
+        {
+            auto const p = static_cast<char const*>(std::memchr(input.data(), '\n', input.size()));
+            auto line = input.substr(0, p ? static_cast<size_t>(p - input.data()) : input.size());
+            auto state = unicode::scan_state {};
+            state.next = line.data();
+            columns += unicode::scan_text(state, line, std::numeric_limits<size_t>::max()).count;
+            input.remove_prefix(std::min(line.size() + 1, input.size()));
+        }
+        benchmark::DoNotOptimize(columns);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+template <unsigned Threads>
+static void lineIndex(benchmark::State& benchmarkState)
+{
+    auto const& text = logFile(static_cast<size_t>(benchmarkState.range(0)));
+    auto const options = unicode::line_index_options { .threads = Threads };
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::build_line_index(text, options));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+BENCHMARK(lineIndexScanText)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(lineIndex, 1)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(lineIndex, 4)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+
+// Mostly non-ASCII text, with some US-ASCII in between.
+static string const& mixedText()
+{
+    static auto const text = [] {
+        auto s = string {};
+        while (s.size() < 1024 * 1024)
+            s += "Gr\xC3\xBC\xC3\x9F" "e \xE2\x80\x94 \xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C \xF0\x9F\x98\x80 ";
+        return s;
+    }();
+    return text;
+}
+
+static void utf8Validate(benchmark::State& benchmarkState,
+                         unicode::detail::utf8_validator validator,
+                         string const& text)
+{
+    if (!unicode::detail::is_supported(validator))
+    {
+        benchmarkState.SkipWithError("Not supported on this CPU.");
+        return;
+    }
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::detail::utf8_validate(text, validator));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+static void utf8Sanitize(benchmark::State& benchmarkState)
+{
+    auto text = mixedText();
+    for (size_t i = 0; i < text.size(); i += 4096)
+        text[i] = '\xFF';
+    auto storage = string {};
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::utf8_sanitize(text, storage));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+BENCHMARK_CAPTURE(utf8Validate, scalar_ascii, unicode::detail::utf8_validator::Scalar, logFile(1 << 20));
+BENCHMARK_CAPTURE(utf8Validate, baseline_ascii, unicode::detail::utf8_validator::Baseline, logFile(1 << 20));
+BENCHMARK_CAPTURE(utf8Validate, avx2_ascii, unicode::detail::utf8_validator::AVX2, logFile(1 << 20));
+BENCHMARK_CAPTURE(utf8Validate, avx512_ascii, unicode::detail::utf8_validator::AVX512, logFile(1 << 20));
+BENCHMARK_CAPTURE(utf8Validate, scalar_mixed, unicode::detail::utf8_validator::Scalar, mixedText());
+BENCHMARK_CAPTURE(utf8Validate, baseline_mixed, unicode::detail::utf8_validator::Baseline, mixedText());
+BENCHMARK_CAPTURE(utf8Validate, avx2_mixed, unicode::detail::utf8_validator::AVX2, mixedText());
+BENCHMARK_CAPTURE(utf8Validate, avx512_mixed, unicode::detail::utf8_validator::AVX512, mixedText());
+BENCHMARK(utf8Sanitize);
+
+// German text encoded in Windows-1252, with typographic quotes.
+static string const& windows1252Text()
+{
+    static auto const text = [] {
+        auto s = string {};
+        while (s.size() < 1024 * 1024)
+            s += "\x84Gr\xFC\xDF"
+                 "e aus K\xF6ln\x93 \x96 kostet 5 \x80. ";
+        return s;
+    }();
+    return text;
+}
+
+static void singleByteDecodePerCodepoint(benchmark::State& benchmarkState)
+{
+    auto const& text = windows1252Text();
+    auto output = string(text.size() * 3, '\0');
+    for (auto _: benchmarkState)
+    {
+        auto out = reinterpret_cast<uint8_t*>(output.data());
+        for (auto const ch: text)
+        {
+            auto const byte = static_cast<uint8_t>(ch);
+            auto const codepoint = byte >= 0x80 && byte < 0xA0 ? char32_t { 0x20AC } : char32_t { byte };
+            out += unicode::to_utf8(codepoint, out);
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+static void singleByteDecode(benchmark::State& benchmarkState)
+{
+    auto const& text = windows1252Text();
+    auto output = string(unicode::utf8_length(unicode::single_byte_encoding::Windows1252, text), '\0');
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::decode_single_byte(unicode::single_byte_encoding::Windows1252, text, output.data()));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+static void singleByteEncode(benchmark::State& benchmarkState)
+{
+    auto const text = unicode::decode_single_byte(unicode::single_byte_encoding::Windows1252, windows1252Text());
+    auto output = string(unicode::single_byte_length(text), '\0');
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::encode_single_byte(unicode::single_byte_encoding::Windows1252, text, output.data()));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+static void isLatin1(benchmark::State& benchmarkState)
+{
+    auto const text = unicode::decode_single_byte(unicode::single_byte_encoding::Latin1, windows1252Text());
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::is_representable(unicode::single_byte_encoding::Latin1, text));
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+BENCHMARK(singleByteDecodePerCodepoint);
+BENCHMARK(singleByteDecode);
+BENCHMARK(singleByteEncode);
+BENCHMARK(isLatin1);
+
+// Mostly US-ASCII lines, with some German, Russian and Chinese ones.
+static std::vector<string> const& scrollbackLines()
+{
+    static auto const lines = [] {
+        auto result = std::vector<string> {};
+        for (size_t i = 0; i < 10'000; ++i)
+        {
+            switch (i % 20)
+            {
+                case 0: result.emplace_back("Gr\xC3\xBC\xC3\x9F" "e aus K\xC3\xB6ln, der Stra\xC3\x9F" "e entlang bis zum Ufer."); break;
+                case 1: result.emplace_back("\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, \xD0\xBC\xD0\xB8\xD1\x80! \xE2\x94\x80\xE2\x94\x80\xE2\x94\x80"); break;
+                case 2: result.emplace_back("\xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C \xF0\x9F\x98\x80 build finished"); break;
+                default:
+                    result.emplace_back(std::to_string(i) + " [info] request handled in " + std::to_string(i % 97)
+                                        + " ms by worker " + std::to_string(i % 8));
+            }
+        }
+        return result;
+    }();
+    return lines;
+}
+
+static void compactLineMemory(benchmark::State& benchmarkState)
+{
+    auto const& lines = scrollbackLines();
+    auto compactBytes = size_t { 0 };
+    for (auto _: benchmarkState)
+    {
+        auto compactLines = std::vector<unicode::compact_line> {};
+        compactLines.reserve(lines.size());
+        for (auto const& line: lines)
+            compactLines.emplace_back(line);
+        compactBytes = 0;
+        for (auto const& line: compactLines)
+            compactBytes += line.memory_usage();
+        benchmark::DoNotOptimize(compactLines.data());
+    }
+
+    auto utf8Bytes = size_t { 0 };
+    auto utf32Bytes = size_t { 0 };
+    for (auto const& line: lines)
+    {
+        utf8Bytes += sizeof(string) + (line.size() > 15 ? line.size() + 1 : 0);
+        utf32Bytes += sizeof(std::u32string) + (unicode::from_utf8<char32_t>(line).size() + 1) * sizeof(char32_t);
+    }
+    benchmarkState.counters["utf8_bytes"] = static_cast<double>(utf8Bytes);
+    benchmarkState.counters["utf32_bytes"] = static_cast<double>(utf32Bytes);
+    benchmarkState.counters["compact_bytes"] = static_cast<double>(compactBytes);
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(lines.size()));
+}
+
+static void compactLineColumnAccess(benchmark::State& benchmarkState)
+{
+    auto compactLines = std::vector<unicode::compact_line> {};
+    for (auto const& line: scrollbackLines())
+        compactLines.emplace_back(line);
+    for (auto _: benchmarkState)
+        for (auto const& line: compactLines)
+            benchmark::DoNotOptimize(line.cluster_at_column(line.columns() / 2));
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(compactLines.size()));
+}
+
+// Column access on plain UTF-8, which has to walk the text up to the given column.
+static void utf8ColumnAccess(benchmark::State& benchmarkState)
+{
+    auto const& lines = scrollbackLines();
+    auto columns = std::vector<size_t> {};
+    for (auto const& line: lines)
+        columns.push_back(unicode::compact_line(line).columns());
+    for (auto _: benchmarkState)
+    {
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            auto state = unicode::scan_state {};
+            state.next = lines[i].data();
+            benchmark::DoNotOptimize(unicode::scan_text(state, lines[i], columns[i] / 2));
+        }
+    }
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(lines.size()));
+}
+
+BENCHMARK(compactLineMemory);
+BENCHMARK(compactLineColumnAccess);
+BENCHMARK(utf8ColumnAccess);
+
+// Lines of mixed scripts and emoji, each occupying about 150 columns.
+static string const& longLines()
+{
+    static auto const text = [] {
+        auto s = string {};
+        for (int i = 0; i < 4096; ++i)
+        {
+            for (int k = 0; k < 8; ++k)
+                s += "Gr\xC3\xBC\xC3\x9F" "e \xE2\x80\x94 \xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C \xF0\x9F\x98\x80 ";
+            s += '\n';
+        }
+        return s;
+    }();
+    return text;
+}
+
+template <typename F>
+static void forEachLine(string_view text, F&& callback)
+{
+    while (!text.empty())
+    {
+        auto const end = std::min(text.find('\n'), text.size());
+        callback(text.substr(0, end));
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+}
+
+// Counts the grapheme clusters within the first 80 columns of each line, decoding and segmenting lazily.
+static void firstColumnsLazy(benchmark::State& benchmarkState)
+{
+    for (auto _: benchmarkState)
+    {
+        size_t clusterCount = 0;
+        forEachLine(longLines(), [&](string_view line) {
+            size_t columns = 0;
+            auto const fitting = [&](auto const& cluster) {
+                columns += cluster.width;
+                return columns <= 80;
+            };
+            for (auto const& cluster: line | unicode::views::utf8_decode | unicode::views::graphemes
+                                          | unicode::views::with_width | std::views::take_while(fitting))
+            {
+                benchmark::DoNotOptimize(cluster);
+                ++clusterCount;
+            }
+        });
+        benchmark::DoNotOptimize(clusterCount);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(longLines().size()));
+}
+
+// Same as above, but materializing each line as UTF-32 first.
+static void firstColumnsMaterializing(benchmark::State& benchmarkState)
+{
+    for (auto _: benchmarkState)
+    {
+        size_t clusterCount = 0;
+        forEachLine(longLines(), [&](string_view line) {
+            auto const codepoints = unicode::convert_to<char32_t>(line);
+            size_t columns = 0;
+            for (auto segmenter = unicode::grapheme_segmenter(codepoints); !(*segmenter).empty(); ++segmenter)
+            {
+                columns += unicode::grapheme_cluster_width(*segmenter);
+                if (columns > 80)
+                    break;
+                benchmark::DoNotOptimize(*segmenter);
+                ++clusterCount;
+            }
+        });
+        benchmark::DoNotOptimize(clusterCount);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(longLines().size()));
+}
+
+BENCHMARK(firstColumnsLazy);
+BENCHMARK(firstColumnsMaterializing);
+
+// Counts the grapheme clusters of text received in chunks of 4096 bytes, segmenting each chunk as it arrives.
+static void chunkedGraphemesStreaming(benchmark::State& benchmarkState)
+{
+    auto constexpr ChunkSize = size_t { 4096 };
+    auto const text = string_view(longLines());
+    for (auto _: benchmarkState)
+    {
+        size_t clusterCount = 0;
+        auto segmenter = unicode::grapheme_stream_segmenter {};
+        for (size_t offset = 0; offset < text.size(); offset += ChunkSize)
+            for (auto const cluster: segmenter.feed(text.substr(offset, ChunkSize)))
+            {
+                benchmark::DoNotOptimize(cluster);
+                ++clusterCount;
+            }
+        for (auto const cluster: segmenter.finish())
+        {
+            benchmark::DoNotOptimize(cluster);
+            ++clusterCount;
+        }
+        benchmark::DoNotOptimize(clusterCount);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Same as above, but buffering the chunks up to complete lines, which are then segmented as UTF-32.
+static void chunkedGraphemesBuffered(benchmark::State& benchmarkState)
+{
+    auto constexpr ChunkSize = size_t { 4096 };
+    auto const text = string_view(longLines());
+    auto const segmentLine = [](string_view line, size_t& clusterCount) {
+        auto const codepoints = unicode::convert_to<char32_t>(line);
+        for (auto segmenter = unicode::grapheme_segmenter(codepoints); !(*segmenter).empty(); ++segmenter)
+        {
+            benchmark::DoNotOptimize(*segmenter);
+            ++clusterCount;
+        }
+    };
+    for (auto _: benchmarkState)
+    {
+        size_t clusterCount = 0;
+        auto buffer = string {};
+        for (size_t offset = 0; offset < text.size(); offset += ChunkSize)
+        {
+            buffer += text.substr(offset, ChunkSize);
+            auto const end = buffer.rfind('\n');
+            if (end == string::npos)
+                continue;
+            forEachLine(string_view(buffer).substr(0, end + 1), [&](string_view line) { segmentLine(line, clusterCount); });
+            buffer.erase(0, end + 1);
+        }
+        segmentLine(buffer, clusterCount);
+        benchmark::DoNotOptimize(clusterCount);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+BENCHMARK(chunkedGraphemesStreaming);
+BENCHMARK(chunkedGraphemesBuffered);
+
+// Looks up the width of mixed text's codepoints, each lookup going through codepoint_properties::get().
+static void codepointWidth(benchmark::State& benchmarkState)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(mixedText()));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        unsigned columns = 0;
+        for (char32_t const codepoint: codepoints)
+            columns += unicode::width(codepoint);
+        benchmark::DoNotOptimize(columns);
+    }
+    reportPerfCounters(benchmarkState, stopPerfCounters(), "lookup", codepoints.size());
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(codepoints.size()));
+}
+
+// Same as above, with widths overridden by a published codepoint_overlay.
+static void codepointWidthOverlay(benchmark::State& benchmarkState)
+{
+    unicode::codepoint_properties::publish(
+        unicode::codepoint_overlay {}.set_width(0xE000, 0xF8FF, 2).set_width(0x2500, 0x257F, 2).build());
+    codepointWidth(benchmarkState);
+    unicode::codepoint_properties::publish(nullptr);
+}
+
+// Same as above, but with widths overridden by checking a map before each lookup.
+static void codepointWidthMapOverride(benchmark::State& benchmarkState)
+{
+    auto const overrides = std::map<char32_t, std::pair<char32_t, unsigned>> {
+        { 0x2500, { 0x257F, 2 } },
+        { 0xE000, { 0xF8FF, 2 } },
+    };
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(mixedText()));
+    for (auto _: benchmarkState)
+    {
+        unsigned columns = 0;
+        for (char32_t const codepoint: codepoints)
+        {
+            auto const i = overrides.upper_bound(codepoint);
+            if (i != overrides.begin() && codepoint <= std::prev(i)->second.first)
+                columns += std::prev(i)->second.second;
+            else
+                columns += unicode::width(codepoint);
+        }
+        benchmark::DoNotOptimize(columns);
+    }
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(codepoints.size()));
+}
+
+// The older of two versions, and the configured tables as the newer one.
+static unicode::codepoint_versions const& twoVersions()
+{
+    static auto const older = unicode::codepoint_overlay {}.set_width(0x2500, 0x257F, 2).build();
+    static auto const versions =
+        unicode::codepoint_versions({ older->properties, unicode::codepoint_properties::configured_tables });
+    return versions;
+}
+
+// Same as codepointWidth, but passing a version handle.
+static void codepointWidthVersioned(benchmark::State& benchmarkState)
+{
+    auto const& tables = twoVersions()[1];
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(mixedText()));
+    for (auto _: benchmarkState)
+    {
+        unsigned columns = 0;
+        for (char32_t const codepoint: codepoints)
+            columns += unicode::width(codepoint, tables);
+        benchmark::DoNotOptimize(columns);
+    }
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(codepoints.size()));
+}
+
+// Scans mixed text with scan_text(), skipping control characters,
+// either using the published tables or passing a version handle.
+static void scanMixedText(benchmark::State& benchmarkState, bool versioned)
+{
+    auto const& tables = twoVersions()[1];
+    auto const& text = mixedText();
+    for (auto _: benchmarkState)
+    {
+        auto state = unicode::scan_state {};
+        auto input = string_view(text);
+        size_t columns = 0;
+        while (!input.empty())
+        {
+            state.next = input.data();
+            auto constexpr MaxColumns = std::numeric_limits<size_t>::max();
+            columns += versioned ? unicode::scan_text(state, input, MaxColumns, tables).count
+                                 : unicode::scan_text(state, input, MaxColumns).count;
+            input.remove_prefix(static_cast<size_t>(state.next - input.data()));
+            if (!input.empty())
+                input.remove_prefix(1);
+        }
+        benchmark::DoNotOptimize(columns);
+    }
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Text in many scripts, as seen by a terminal, touching many different blocks and properties of the tables.
+static string const& multilingualText()
+{
+    static auto const text = [] {
+        auto s = string {};
+        while (s.size() < 1024 * 1024)
+        {
+            s += "The quick brown fox jumps over the lazy dog. ";
+            s += "Gr\xC3\xBC\xC3\x9F" "e aus K\xC3\xB6ln, \xC3\xA7" "a va tr\xC3\xA8s bien. ";
+            // Russian, Greek
+            s += "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xCE\x93\xCE\xB5\xCE\xB9\xCE\xAC ";
+            // Chinese, Japanese, Korean
+            s += "\xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C ";
+            s += "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF ";
+            s += "\xEC\x95\x88\xEB\x85\x95\xED\x95\x98\xEC\x84\xB8\xEC\x9A\x94 ";
+            // Box drawing, Powerline symbol, punctuation, arrow
+            s += "\xE2\x94\x8C\xE2\x94\x80\xE2\x94\x90 \xEE\x82\xB0 \xE2\x80\x94 \xE2\x86\x92 ";
+            // Emoji, combining mark
+            s += "\xF0\x9F\x98\x80\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD\xF0\x9F\x9A\x80 e\xCC\x81 ";
+        }
+        return s;
+    }();
+    return text;
+}
+
+// Looks up the width of multilingual text's codepoints.
+//
+// Reports the number of distinct cache lines of the tables touched ("tableLines"), the footprint that
+// the table layout aims to minimize. Cache misses can be measured along with it where hardware counters
+// are available, e.g. --benchmark_perf_counters=L1-dcache-load-misses,LLC-load-misses.
+static void codepointWidthMultilingual(benchmark::State& benchmarkState)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(multilingualText()));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        unsigned columns = 0;
+        for (char32_t const codepoint: codepoints)
+            columns += unicode::width(codepoint);
+        benchmark::DoNotOptimize(columns);
+    }
+    reportPerfCounters(benchmarkState, stopPerfCounters(), "lookup", codepoints.size());
+    benchmarkState.SetItemsProcessed(benchmarkState.iterations() * static_cast<int64_t>(codepoints.size()));
+
+    auto constexpr CacheLineSize = uintptr_t { 64 };
+    auto const& tables = unicode::codepoint_properties::configured_tables;
+    auto lines = std::set<uintptr_t> {};
+    for (char32_t const codepoint: codepoints)
+    {
+        auto const blockIndex = size_t { tables.stage1[codepoint / tables.block_size] } * tables.block_size;
+        auto const stage2 = &tables.stage2[blockIndex + codepoint % tables.block_size];
+        lines.insert(reinterpret_cast<uintptr_t>(stage2) / CacheLineSize);
+        lines.insert(reinterpret_cast<uintptr_t>(&tables.stage3[*stage2]) / CacheLineSize);
+    }
+    benchmarkState.counters["tableLines"] = static_cast<double>(lines.size());
+}
+
+BENCHMARK(codepointWidth);
+BENCHMARK(codepointWidthMultilingual);
+BENCHMARK(codepointWidthOverlay);
+BENCHMARK(codepointWidthMapOverride);
+BENCHMARK(codepointWidthVersioned);
+BENCHMARK_CAPTURE(scanMixedText, published, false);
+BENCHMARK_CAPTURE(scanMixedText, versioned, true);
+
+// Hands over text from a producer thread, paced at 1 GB/s, to a consumer thread running scan_text(),
+// reporting the latency between a chunk being committed and being scanned.
+static void byteRingPipeline(benchmark::State& benchmarkState)
+{
+    using clock = std::chrono::steady_clock;
+    auto constexpr ChunkSize = size_t { 4096 };
+    auto constexpr ChunkCount = size_t { 4 * 1024 }; // 16 MiB per iteration
+    auto constexpr BytesPerSecond = 1'000'000'000.0;
+
+    auto const& text = mixedText();
+    auto ring = unicode::byte_ring(1024 * 1024);
+    auto commitTimes = std::vector<clock::time_point>(ChunkCount);
+    auto totalLatency = clock::duration {};
+    auto maxLatency = clock::duration {};
+
+    for (auto _: benchmarkState)
+    {
+        auto producer = std::thread([&]() {
+            auto const start = clock::now();
+            for (size_t chunk = 0; chunk < ChunkCount; ++chunk)
+            {
+                auto const offset = std::chrono::duration<double>(static_cast<double>(chunk * ChunkSize) / BytesPerSecond);
+                auto const due = start + std::chrono::duration_cast<clock::duration>(offset);
+                while (clock::now() < due)
+                    std::this_thread::yield();
+                auto bytes = std::string_view(text).substr((chunk * ChunkSize) % (text.size() - ChunkSize), ChunkSize);
+                commitTimes[chunk] = clock::now();
+                while (!bytes.empty())
+                {
+                    auto const count = ring.write(bytes);
+                    bytes.remove_prefix(count);
+                    if (!count)
+                        std::this_thread::yield();
+                }
+            }
+        });
+
+        auto state = unicode::scan_state {};
+        auto const pendingBytes = [&]() -> size_t {
+            return state.utf8.expectedLength ? state.utf8.currentLength : 0;
+        };
+        size_t consumed = 0;
+        size_t nextChunk = 0;
+        while (consumed + pendingBytes() < ChunkCount * ChunkSize)
+        {
+            auto const pending = pendingBytes();
+            auto const bytes = ring.readable();
+            if (bytes.size() <= pending)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            unicode::scan_text(state, ring, std::numeric_limits<size_t>::max(), unicode::null_receiver::get());
+            if (state.next == bytes.data() + pending)
+            {
+                ring.consume(1); // control character
+                consumed += 1;
+            }
+            else
+                consumed += static_cast<size_t>(state.next - bytes.data()) - pendingBytes();
+
+            for (auto const now = clock::now(); nextChunk < ChunkCount && (nextChunk + 1) * ChunkSize <= consumed; ++nextChunk)
+            {
+                auto const latency = now - commitTimes[nextChunk];
+                totalLatency += latency;
+                maxLatency = std::max(maxLatency, latency);
+            }
+        }
+        producer.join();
+
+        // Drop the incomplete UTF-8 sequence the last chunk may end with.
+        ring.consume(pendingBytes());
+    }
+
+    auto const chunks = static_cast<double>(benchmarkState.iterations()) * ChunkCount;
+    benchmarkState.counters["latency_avg_us"] = std::chrono::duration<double, std::micro>(totalLatency).count() / chunks;
+    benchmarkState.counters["latency_max_us"] = std::chrono::duration<double, std::micro>(maxLatency).count();
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(ChunkCount * ChunkSize));
+}
+
+BENCHMARK(byteRingPipeline)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// {{{ per-corpus benchmarks
+using unicode::benchmark_corpus::corpus;
+
+// Reports the throughput of processing the whole corpus once per iteration, in bytes and in codepoints per second.
+// Also reports the hardware performance counters per byte and per codepoint, if enabled.
+static void setCorpusProcessed(benchmark::State& benchmarkState, corpus c)
+{
+    auto const counted = stopPerfCounters();
+    auto const& text = unicode::benchmark_corpus::text(c);
+    auto const codepointCount = unicode::convert_to<char32_t>(string_view(text)).size();
+    reportPerfCounters(benchmarkState, counted, "byte", text.size());
+    reportPerfCounters(benchmarkState, counted, "codepoint", codepointCount);
+    benchmarkState.SetBytesProcessed(benchmarkState.iterations() * static_cast<int64_t>(text.size()));
+    benchmarkState.counters["codepoints"] = benchmark::Counter(
+        static_cast<double>(benchmarkState.iterations()) * static_cast<double>(codepointCount), benchmark::Counter::kIsRate);
+}
+
+// With LIBUNICODE_INSTRUMENTATION=ON, also reports how the text was scanned.
+static void corpusScanText(benchmark::State& benchmarkState, corpus c)
+{
+    unicode::instrumentation::reset();
+    startPerfCounters();
+    scanTextPerSequence(benchmarkState, unicode::benchmark_corpus::text(c));
+    setCorpusProcessed(benchmarkState, c);
+
+    if constexpr (unicode::instrumentation::enabled)
+    {
+        using unicode::instrumentation::counter;
+        auto const snapshot = unicode::instrumentation::snapshot();
+        auto const bytes = snapshot[counter::scan_ascii_bytes] + snapshot[counter::scan_nonascii_bytes];
+        benchmarkState.counters["asciiFastPath"] =
+            bytes ? static_cast<double>(snapshot[counter::scan_ascii_bytes]) / static_cast<double>(bytes) : 0.0;
+        benchmarkState.counters["invalid"] = benchmark::Counter(
+            static_cast<double>(snapshot[counter::scan_invalid_sequences]), benchmark::Counter::kAvgIterations);
+        benchmarkState.counters["clusterLength"] = snapshot.average_cluster_length();
+    }
+}
+
+static void corpusUtf8Decode(benchmark::State& benchmarkState, corpus c)
+{
+    auto const& text = unicode::benchmark_corpus::text(c);
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        auto state = unicode::utf8_decoder_state {};
+        size_t decoded = 0;
+        for (char const ch: text)
+            decoded += std::holds_alternative<unicode::Success>(unicode::from_utf8(state, static_cast<uint8_t>(ch)));
+        benchmark::DoNotOptimize(decoded);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+static void corpusConvertToUtf32(benchmark::State& benchmarkState, corpus c)
+{
+    auto const& text = unicode::benchmark_corpus::text(c);
+    startPerfCounters();
+    for (auto _: benchmarkState)
+        benchmark::DoNotOptimize(unicode::convert_to<char32_t>(string_view(text)));
+    setCorpusProcessed(benchmarkState, c);
+}
+
+static void corpusGraphemeSegmenter(benchmark::State& benchmarkState, corpus c)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(unicode::benchmark_corpus::text(c)));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        size_t clusters = 0;
+        for (auto segmenter = unicode::grapheme_segmenter(codepoints); segmenter.codepointsAvailable(); ++segmenter)
+            ++clusters;
+        benchmark::DoNotOptimize(clusters);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+static void corpusUtf8GraphemeSegmenter(benchmark::State& benchmarkState, corpus c)
+{
+    auto const& text = unicode::benchmark_corpus::text(c);
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        size_t clusters = 0;
+        for (auto const& cluster: unicode::utf8_grapheme_segmenter(text))
+            clusters += !cluster.empty();
+        benchmark::DoNotOptimize(clusters);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+static void corpusScriptSegmenter(benchmark::State& benchmarkState, corpus c)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(unicode::benchmark_corpus::text(c)));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        size_t runs = 0;
+        auto segmenter = unicode::script_segmenter(codepoints);
+        while (segmenter.consume())
+            ++runs;
+        benchmark::DoNotOptimize(runs);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
+static void corpusEmojiSegmenter(benchmark::State& benchmarkState, corpus c)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(unicode::benchmark_corpus::text(c)));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        size_t runs = 0;
+        size_t size = 0;
+        auto presentationStyle = unicode::PresentationStyle::Text;
+        auto segmenter = unicode::emoji_segmenter(codepoints);
+        while (segmenter.consume(unicode::out(size), unicode::out(presentationStyle)))
+            ++runs;
+        benchmark::DoNotOptimize(runs);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+static void corpusRunSegmenter(benchmark::State& benchmarkState, corpus c)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(unicode::benchmark_corpus::text(c)));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        size_t runs = 0;
+        auto segmenter = unicode::run_segmenter(codepoints);
+        auto range = unicode::run_segmenter::range {};
+        while (segmenter.consume(unicode::out(range)))
+            ++runs;
+        benchmark::DoNotOptimize(runs);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+#endif
+
+static void corpusCodepointProperties(benchmark::State& benchmarkState, corpus c)
+{
+    auto const codepoints = unicode::convert_to<char32_t>(string_view(unicode::benchmark_corpus::text(c)));
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        unsigned sum = 0;
+        for (char32_t const codepoint: codepoints)
+        {
+            auto const& properties = unicode::codepoint_properties::get(codepoint);
+            sum += properties.char_width + static_cast<unsigned>(properties.grapheme_cluster_break);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+// Measures the C API, one u8_gc_count() call per line.
+static void corpusCapiGcCount(benchmark::State& benchmarkState, corpus c)
+{
+    auto const& text = unicode::benchmark_corpus::text(c);
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        int clusters = 0;
+        forEachLine(text, [&](string_view line) { clusters += u8_gc_count(line.data(), line.size()); });
+        benchmark::DoNotOptimize(clusters);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+// Measures the C API, one u32_gc_width() call per line (u8_gc_width() is not implemented yet).
+static void corpusCapiGcWidth(benchmark::State& benchmarkState, corpus c)
+{
+    auto lines = std::vector<std::u32string> {};
+    forEachLine(unicode::benchmark_corpus::text(c),
+                [&](string_view line) { lines.emplace_back(unicode::convert_to<char32_t>(line)); });
+    startPerfCounters();
+    for (auto _: benchmarkState)
+    {
+        int columns = 0;
+        for (auto const& line: lines)
+            columns += u32_gc_width(reinterpret_cast<u32_char_t const*>(line.data()), line.size(), GC_WIDTH_MODE_MODIFIABLE);
+        benchmark::DoNotOptimize(columns);
+    }
+    setCorpusProcessed(benchmarkState, c);
+}
+
+// Registers the given benchmark for each corpus, as name/corpus.
+static void registerForEachCorpus(char const* name, void (*function)(benchmark::State&, corpus))
+{
+    for (auto const c: unicode::benchmark_corpus::all_corpora)
+    {
+        auto const fullName = string(name) + "/" + string(unicode::benchmark_corpus::name(c));
+        benchmark::RegisterBenchmark(fullName.c_str(), function, c);
+    }
+}
+
+static void registerCorpusBenchmarks()
+{
+    registerForEachCorpus("corpusScanText", corpusScanText);
+    registerForEachCorpus("corpusUtf8Decode", corpusUtf8Decode);
+    registerForEachCorpus("corpusConvertToUtf32", corpusConvertToUtf32);
+    registerForEachCorpus("corpusGraphemeSegmenter", corpusGraphemeSegmenter);
+    registerForEachCorpus("corpusUtf8GraphemeSegmenter", corpusUtf8GraphemeSegmenter);
+    registerForEachCorpus("corpusScriptSegmenter", corpusScriptSegmenter);
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
+    registerForEachCorpus("corpusEmojiSegmenter", corpusEmojiSegmenter);
+    registerForEachCorpus("corpusRunSegmenter", corpusRunSegmenter);
+#endif
+    registerForEachCorpus("corpusCodepointProperties", corpusCodepointProperties);
+    registerForEachCorpus("corpusCapiGcCount", corpusCapiGcCount);
+    registerForEachCorpus("corpusCapiGcWidth", corpusCapiGcWidth);
+}
+// }}}
+
+// Writes the codepoint frequency profile of the given files, or of the benchmarks' sample texts if none given,
+// for use with unicode_tablegen --frequencies=FILE.
+//
+// @return false if one of the files could not be read.
+static bool writeFrequencyProfile(int argc, char** argv, std::ostream& output)
+{
+    auto texts = std::vector<string> {};
+    for (int i = 0; i < argc; ++i)
+    {
+        auto file = std::ifstream(argv[i], std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Could not open " << argv[i] << '\n';
+            return false;
+        }
+        auto contents = std::ostringstream {};
+        contents << file.rdbuf();
+        texts.emplace_back(std::move(contents).str());
+    }
+    if (texts.empty())
+        texts = { logFile(1 << 20), mixedText(), multilingualText(), lsColorOutput(), compilerOutput() };
+
+    auto counts = std::map<char32_t, uint64_t> {};
+    for (auto const& text: texts)
+        for (char32_t const codepoint: unicode::convert_to<char32_t>(string_view(text)))
+            ++counts[codepoint];
+
+    output << "# libunicode codepoint frequency profile\n";
+    for (auto const& [codepoint, count]: counts)
+        output << "U+" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << static_cast<uint32_t>(codepoint)
+               << std::dec << ' ' << count << '\n';
+    return true;
+}
+
+// Runs the benchmarks, or with --frequency-profile [FILE...], writes a codepoint frequency profile to stdout.
+// With leading --perf-counters, also reports hardware performance counters where available.
+// With leading --profile=FILE, writes the time spent setting up the benchmarks (such as generating the corpora
+// and building tables) as Chrome trace JSON to FILE, and a summary to stderr.
+int main(int argc, char** argv)
+{
+    if (argc > 1 && argv[1] == string_view("--frequency-profile"))
+    {
+        return writeFrequencyProfile(argc - 2, argv + 2, std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    auto profileFileName = string {};
+    while (argc > 1 && (argv[1] == string_view("--perf-counters") || string_view(argv[1]).starts_with("--profile=")))
+    {
+        if (argv[1] == string_view("--perf-counters"))
+        {
+            perfCounters = std::make_unique<unicode::benchmark_perf::counters>();
+            if (!perfCounters->any_available())
+            {
+                std::cerr << "Hardware performance counters are unavailable "
+                             "(virtualized CPU, or see /proc/sys/kernel/perf_event_paranoid), running without them.\n";
+                perfCounters.reset();
+            }
+        }
+        else
+            profileFileName = argv[1] + string_view("--profile=").size();
+        std::copy(argv + 2, argv + argc, argv + 1);
+        --argc;
+    }
+    support::profiler::enable(!profileFileName.empty());
+
+    registerCorpusBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return EXIT_FAILURE;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    if (!profileFileName.empty())
+    {
+        auto profileFile = std::ofstream(profileFileName);
+        if (!profileFile)
+        {
+            std::cerr << "Could not write profile: " << profileFileName << '\n';
+            return EXIT_FAILURE;
+        }
+        support::profiler::write_chrome_trace(profileFile);
+        support::profiler::write_summary(std::cerr);
+    }
+    return EXIT_SUCCESS;
+}
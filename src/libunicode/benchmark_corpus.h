@@ -0,0 +1,240 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/convert.h>
+#include <libunicode/profiler.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace unicode::benchmark_corpus
+{
+
+/// The corpora the benchmarks are run on, each deterministically generated,
+/// so that results are comparable between library releases.
+enum class corpus
+{
+    english_log,  // log lines, US-ASCII only
+    cjk,          // Chinese and Japanese prose
+    arabic,       // Arabic prose with some diacritics
+    emoji_chat,   // chat messages with emoji, including ZWJ sequences, modifiers and flags
+    source_code,  // C++ source code with some non-ASCII in comments and strings
+    invalid_utf8, // mixed text with ill-formed UTF-8 sequences
+};
+
+inline constexpr auto all_corpora = std::array {
+    corpus::english_log, corpus::cjk,         corpus::arabic,
+    corpus::emoji_chat,  corpus::source_code, corpus::invalid_utf8,
+};
+
+inline constexpr std::string_view name(corpus c) noexcept
+{
+    switch (c)
+    {
+        case corpus::english_log: return "english_log";
+        case corpus::cjk: return "cjk";
+        case corpus::arabic: return "arabic";
+        case corpus::emoji_chat: return "emoji_chat";
+        case corpus::source_code: return "source_code";
+        case corpus::invalid_utf8: return "invalid_utf8";
+    }
+    return "unknown";
+}
+
+namespace detail
+{
+    inline constexpr size_t CorpusSize = 1024 * 1024;
+
+    // Deterministic across platforms, unlike the standard distributions.
+    class random
+    {
+      public:
+        explicit random(uint32_t seed): _engine { seed } {}
+
+        // Returns a number in [0, n).
+        uint32_t operator()(uint32_t n) { return static_cast<uint32_t>(_engine() % n); }
+
+        template <typename T, size_t N>
+        T const& pick(std::array<T, N> const& values)
+        {
+            return values[(*this)(static_cast<uint32_t>(N))];
+        }
+
+      private:
+        std::mt19937 _engine;
+    };
+
+    inline void append(std::string& text, char32_t codepoint)
+    {
+        text += convert_to<char>(std::u32string_view(&codepoint, 1));
+    }
+
+    inline std::string english_log()
+    {
+        auto rng = random { 1 };
+        auto constexpr Levels = std::array<std::string_view, 4> { "debug", "info", "warning", "error" };
+        auto constexpr Words = std::array<std::string_view, 12> {
+            "request", "served", "connection", "closed", "user", "logged", "in", "cache", "miss", "for", "key", "retrying",
+        };
+        auto text = std::string {};
+        for (unsigned line = 0; text.size() < CorpusSize; ++line)
+        {
+            text += "2023-11-27T12:" + std::to_string(10 + line / 600 % 50) + ":" + std::to_string(10 + line / 10 % 50)
+                    + "." + std::to_string(100 + line % 900) + " [" + std::string(rng.pick(Levels)) + "]";
+            for (auto i = 4 + rng(8); i > 0; --i)
+                text += " " + std::string(rng.pick(Words));
+            text += " (" + std::to_string(rng(1000)) + "ms)\n";
+        }
+        return text;
+    }
+
+    inline std::string cjk()
+    {
+        auto rng = random { 2 };
+        auto constexpr Punctuation = std::array<char32_t, 4> { 0x3001, 0x3002, 0xFF0C, 0xFF01 };
+        auto text = std::string {};
+        while (text.size() < CorpusSize)
+        {
+            for (auto i = 10 + rng(30); i > 0; --i)
+            {
+                if (rng(4) == 0)
+                    append(text, 0x3041 + rng(0x56)); // Hiragana
+                else
+                    append(text, 0x4E00 + rng(0x5200)); // CJK Unified Ideographs
+            }
+            append(text, rng.pick(Punctuation));
+            if (rng(8) == 0)
+                text += '\n';
+        }
+        return text;
+    }
+
+    inline std::string arabic()
+    {
+        auto rng = random { 3 };
+        auto text = std::string {};
+        while (text.size() < CorpusSize)
+        {
+            for (auto i = 2 + rng(6); i > 0; --i)
+            {
+                append(text, 0x0621 + rng(0x2A)); // letters
+                if (rng(5) == 0)
+                    append(text, 0x064B + rng(8)); // diacritics
+            }
+            text += rng(10) == 0 ? ".\n" : " ";
+            if (rng(20) == 0)
+                append(text, 0x0660 + rng(10)); // Arabic-Indic digits
+        }
+        return text;
+    }
+
+    inline std::string emoji_chat()
+    {
+        auto rng = random { 4 };
+        auto constexpr Names = std::array<std::string_view, 4> { "alice", "bob", "carol", "dave" };
+        auto constexpr Words = std::array<std::string_view, 8> { "lol", "see", "you", "later", "nice", "ok", "thanks", "wow" };
+        auto constexpr Emoji = std::array<std::u32string_view, 8> {
+            U"\U0001F600",                                 // grinning face
+            U"\U0001F602",                                 // face with tears of joy
+            U"\U0001F44D\U0001F3FD",                       // thumbs up, skin tone modifier
+            U"\u2764\uFE0F",                               // heart, VS16
+            U"\U0001F468\u200D\U0001F469\u200D\U0001F467", // family (ZWJ sequence)
+            U"\U0001F1E9\U0001F1EA",                       // flag
+            U"\U0001F680",                                 // rocket
+            U"\u263A",                                     // smiling face, text presentation
+        };
+        auto text = std::string {};
+        while (text.size() < CorpusSize)
+        {
+            text += "<" + std::string(rng.pick(Names)) + "> ";
+            for (auto i = 1 + rng(6); i > 0; --i)
+            {
+                if (rng(3) == 0)
+                    text += convert_to<char>(rng.pick(Emoji));
+                else
+                    text += rng.pick(Words);
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    inline std::string source_code()
+    {
+        auto rng = random { 5 };
+        auto text = std::string {};
+        for (unsigned i = 0; text.size() < CorpusSize; ++i)
+        {
+            auto const n = std::to_string(i);
+            text += "// Computes the value number " + n + (rng(8) == 0 ? " \xE2\x80\x94 see the na\xC3\xAFve version.\n" : ".\n");
+            text += "int compute" + n + "(std::vector<int> const& values)\n{\n";
+            text += "\tint sum = " + std::to_string(rng(100)) + ";\n";
+            text += "\tfor (auto const value: values)\n\t\tsum += value * " + std::to_string(rng(10)) + ";\n";
+            if (rng(4) == 0)
+                text += "\tstd::puts(\"r\xC3\xA9sultat: \xE2\x9C\x93\");\n";
+            text += "\treturn sum;\n}\n\n";
+        }
+        return text;
+    }
+
+    inline std::string invalid_utf8()
+    {
+        auto rng = random { 6 };
+        auto constexpr Invalid = std::array<std::string_view, 6> {
+            "\xFF", "\xC0\xAF", "\xE2\x82", "\xED\xA0\x80", "\x80\x80", "\xF4\x90\x80\x80",
+        };
+        auto text = std::string {};
+        while (text.size() < CorpusSize)
+        {
+            switch (rng(4))
+            {
+                case 0: text += "plain text "; break;
+                case 1: text += "gr\xC3\xBC\xC3\x9F" "e "; break;
+                case 2: text += "\xE4\xBD\xA0\xE5\xA5\xBD "; break;
+                default: text += rng.pick(Invalid); break;
+            }
+            if (rng(16) == 0)
+                text += '\n';
+        }
+        return text;
+    }
+} // namespace detail
+
+/// Returns the text of the given corpus, about 1 MiB of UTF-8.
+inline std::string const& text(corpus c)
+{
+    static auto const texts = [] {
+        auto const _ = support::profiler::scope { "Generating corpora" };
+        auto const generate = [](corpus c, auto generator) {
+            auto const _ = support::profiler::scope { name(c) };
+            return generator();
+        };
+        return std::array {
+            generate(corpus::english_log, detail::english_log),
+            generate(corpus::cjk, detail::cjk),
+            generate(corpus::arabic, detail::arabic),
+            generate(corpus::emoji_chat, detail::emoji_chat),
+            generate(corpus::source_code, detail::source_code),
+            generate(corpus::invalid_utf8, detail::invalid_utf8),
+        };
+    }();
+    return texts[static_cast<size_t>(c)];
+}
+
+} // namespace unicode::benchmark_corpus
@@ -0,0 +1,179 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// clang-format off
+#if defined(__linux__)
+    #define LIBUNICODE_PERF_EVENTS 1
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+// clang-format on
+
+namespace unicode::benchmark_perf
+{
+
+enum class event
+{
+    cycles,
+    instructions,
+    branch_misses,
+    l1d_misses,  // L1 data cache read misses
+    llc_misses,  // last level cache read misses
+    dtlb_misses, // data TLB read misses
+};
+
+inline constexpr auto all_events = std::array {
+    event::cycles,     event::instructions, event::branch_misses,
+    event::l1d_misses, event::llc_misses,   event::dtlb_misses,
+};
+
+inline constexpr std::string_view name(event e) noexcept
+{
+    switch (e)
+    {
+        case event::cycles: return "cycles";
+        case event::instructions: return "instructions";
+        case event::branch_misses: return "branch-misses";
+        case event::l1d_misses: return "L1D-misses";
+        case event::llc_misses: return "LLC-misses";
+        case event::dtlb_misses: return "dTLB-misses";
+    }
+    return "unknown";
+}
+
+/// Hardware performance counters of the calling thread, read via perf_event_open(2).
+///
+/// Counters the kernel does not provide (e.g. other platforms, virtualized CPUs,
+/// or a too restrictive /proc/sys/kernel/perf_event_paranoid) are unavailable
+/// and reported as std::nullopt.
+class counters
+{
+  public:
+    using values = std::array<std::optional<double>, all_events.size()>;
+
+    counters() noexcept
+    {
+        for (size_t i = 0; i < all_events.size(); ++i)
+            _fds[i] = open(all_events[i]);
+    }
+
+    ~counters()
+    {
+#if defined(LIBUNICODE_PERF_EVENTS)
+        for (auto const fd: _fds)
+            if (fd != -1)
+                close(fd);
+#endif
+    }
+
+    counters(counters const&) = delete;
+    counters& operator=(counters const&) = delete;
+
+    [[nodiscard]] bool any_available() const noexcept
+    {
+        for (auto const fd: _fds)
+            if (fd != -1)
+                return true;
+        return false;
+    }
+
+    /// Resets and starts all available counters.
+    void start() noexcept
+    {
+#if defined(LIBUNICODE_PERF_EVENTS)
+        for (auto const fd: _fds)
+            if (fd != -1)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+
+    /// Stops all available counters.
+    ///
+    /// @returns the events counted since start(), scaled up if the kernel had to multiplex the counters.
+    values stop() noexcept
+    {
+        auto result = values {};
+#if defined(LIBUNICODE_PERF_EVENTS)
+        for (auto const fd: _fds)
+            if (fd != -1)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (size_t i = 0; i < _fds.size(); ++i)
+        {
+            struct
+            {
+                uint64_t value;
+                uint64_t timeEnabled;
+                uint64_t timeRunning;
+            } data {};
+            if (_fds[i] == -1 || read(_fds[i], &data, sizeof(data)) != sizeof(data) || data.timeRunning == 0)
+                continue;
+            result[i] = static_cast<double>(data.value) * static_cast<double>(data.timeEnabled)
+                        / static_cast<double>(data.timeRunning);
+        }
+#endif
+        return result;
+    }
+
+  private:
+    static int open(event e) noexcept
+    {
+#if defined(LIBUNICODE_PERF_EVENTS)
+        auto constexpr ReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        auto attributes = perf_event_attr {};
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HW_CACHE;
+        switch (e)
+        {
+            case event::cycles:
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case event::instructions:
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case event::branch_misses:
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case event::l1d_misses: attributes.config = PERF_COUNT_HW_CACHE_L1D | ReadMiss; break;
+            case event::llc_misses: attributes.config = PERF_COUNT_HW_CACHE_LL | ReadMiss; break;
+            case event::dtlb_misses: attributes.config = PERF_COUNT_HW_CACHE_DTLB | ReadMiss; break;
+        }
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+        (void) e;
+        return -1;
+#endif
+    }
+
+    std::array<int, all_events.size()> _fds {};
+};
+
+} // namespace unicode::benchmark_perf
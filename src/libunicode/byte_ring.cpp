@@ -0,0 +1,206 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/byte_ring.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+
+// clang-format off
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBUNICODE_BYTE_RING_MIRRORED 1
+    #include <string>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+// clang-format on
+
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    // Number of bytes beyond the wrap-around point, a non-mirrored readable region may extend to,
+    // i.e. the maximum number of continuation bytes of a UTF-8 sequence.
+    auto constexpr Slack = size_t { 3 };
+
+    size_t page_size() noexcept
+    {
+#if defined(LIBUNICODE_BYTE_RING_MIRRORED)
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+#if defined(LIBUNICODE_BYTE_RING_MIRRORED)
+    int create_shared_memory(size_t size) noexcept
+    {
+    #if defined(__linux__)
+        auto const fd = memfd_create("libunicode-byte-ring", MFD_CLOEXEC);
+    #else
+        static auto counter = std::atomic<unsigned> { 0 };
+        auto const name = "/libunicode-byte-ring-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+        auto const fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd != -1)
+            shm_unlink(name.c_str());
+    #endif
+        if (fd == -1)
+            return -1;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Maps the same memory of the given size twice into consecutive virtual memory.
+    char* map_mirrored(size_t size) noexcept
+    {
+        auto const fd = create_shared_memory(size);
+        if (fd == -1)
+            return nullptr;
+
+        // Reserve the address range for both mappings first.
+        auto const base = static_cast<char*>(mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (base == MAP_FAILED)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        auto const protection = PROT_READ | PROT_WRITE;
+        auto const first = mmap(base, size, protection, MAP_SHARED | MAP_FIXED, fd, 0);
+        auto const second = mmap(base + size, size, protection, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+
+        if (first == MAP_FAILED || second == MAP_FAILED)
+        {
+            munmap(base, 2 * size);
+            return nullptr;
+        }
+        return base;
+    }
+#endif
+} // namespace
+
+byte_ring::byte_ring(size_t minimumCapacity):
+    _capacity { std::bit_ceil(std::max(minimumCapacity, page_size())) }
+{
+#if defined(LIBUNICODE_BYTE_RING_MIRRORED)
+    _buffer = map_mirrored(_capacity);
+    _mirrored = _buffer != nullptr;
+#endif
+    if (!_buffer)
+        _buffer = new char[_capacity + Slack];
+}
+
+byte_ring::~byte_ring()
+{
+#if defined(LIBUNICODE_BYTE_RING_MIRRORED)
+    if (_mirrored)
+    {
+        munmap(_buffer, 2 * _capacity);
+        return;
+    }
+#endif
+    delete[] _buffer;
+}
+
+std::span<char> byte_ring::writable() noexcept
+{
+    auto const head = _head.load(std::memory_order_relaxed);
+    if (head - _cachedTail == _capacity)
+        _cachedTail = _tail.load(std::memory_order_acquire);
+
+    auto const offset = head & (_capacity - 1);
+    auto size = _capacity - (head - _cachedTail);
+    if (!_mirrored)
+        size = std::min(size, _capacity - offset);
+    return { _buffer + offset, size };
+}
+
+void byte_ring::commit(size_t count) noexcept
+{
+    auto const head = _head.load(std::memory_order_relaxed);
+    auto const offset = head & (_capacity - 1);
+
+    // Duplicate the bytes right after the wrap-around point, so that the readable region can extend to them.
+    if (!_mirrored && offset < Slack)
+        std::memcpy(_buffer + _capacity + offset, _buffer + offset, std::min(count, Slack - offset));
+
+    _head.store(head + count, std::memory_order_release);
+}
+
+size_t byte_ring::write(string_view data) noexcept
+{
+    auto written = size_t { 0 };
+    while (written < data.size())
+    {
+        auto const target = writable();
+        if (target.empty())
+            break;
+        auto const count = std::min(target.size(), data.size() - written);
+        std::memcpy(target.data(), data.data() + written, count);
+        commit(count);
+        written += count;
+    }
+    return written;
+}
+
+string_view byte_ring::readable() noexcept
+{
+    auto const tail = _tail.load(std::memory_order_relaxed);
+    _cachedHead = _head.load(std::memory_order_acquire);
+
+    auto const offset = tail & (_capacity - 1);
+    auto size = _cachedHead - tail;
+    if (!_mirrored)
+        size = std::min(size, _capacity + Slack - offset);
+    return { _buffer + offset, size };
+}
+
+void byte_ring::consume(size_t count) noexcept
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+scan_result scan_text(scan_state& state,
+                      byte_ring& ring,
+                      size_t maxColumnCount,
+                      grapheme_cluster_receiver& receiver) noexcept
+{
+    auto const pendingBytes = [&]() noexcept -> size_t {
+        return state.utf8.expectedLength ? state.utf8.currentLength : 0;
+    };
+
+    // The bytes of an incomplete UTF-8 sequence have already been fed into the decoder state,
+    // but are still kept in the ring.
+    auto const bytes = ring.readable();
+    auto const text = bytes.substr(std::min(pendingBytes(), bytes.size()));
+
+    state.next = text.data();
+    auto const result = scan_text(state, text, maxColumnCount, receiver);
+
+    auto const processed = static_cast<size_t>(state.next - bytes.data());
+    ring.consume(processed - pendingBytes());
+    return result;
+}
+
+} // namespace unicode
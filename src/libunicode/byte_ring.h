@@ -0,0 +1,105 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/scan.h>
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace unicode
+{
+
+/// Lock-free single-producer/single-consumer byte ring buffer,
+/// such as for handing over bytes from a PTY reader thread to a thread running scan_text().
+///
+/// Where supported (POSIX), the buffer is mapped twice into consecutive virtual memory,
+/// so that both the writable and the readable region are always contiguous, regardless of the wrap-around.
+/// Otherwise, the writable region ends at the wrap-around point, and the readable region extends
+/// at most 3 bytes beyond it (which the producer duplicates), so that a UTF-8 sequence is never split.
+///
+/// All producer-side functions must be called from one thread, and all consumer-side functions
+/// from one (other) thread.
+class byte_ring
+{
+  public:
+    /// Creates a ring buffer of at least the given capacity.
+    ///
+    /// The capacity is rounded up to the next power of two, and at least to the page size.
+    ///
+    /// @throws std::bad_alloc if no memory could be allocated.
+    explicit byte_ring(size_t minimumCapacity);
+    ~byte_ring();
+
+    byte_ring(byte_ring const&) = delete;
+    byte_ring(byte_ring&&) = delete;
+    byte_ring& operator=(byte_ring const&) = delete;
+    byte_ring& operator=(byte_ring&&) = delete;
+
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+    /// Indicates whether the buffer is mapped twice, providing contiguous regions across the wrap-around.
+    [[nodiscard]] bool mirrored() const noexcept { return _mirrored; }
+
+    // {{{ producer
+    /// Returns the contiguous free space the producer can write to.
+    [[nodiscard]] std::span<char> writable() noexcept;
+
+    /// Publishes the first @p count bytes of writable() to the consumer.
+    void commit(size_t count) noexcept;
+
+    /// Copies as many bytes of @p data into the ring as fit.
+    ///
+    /// @return number of bytes written.
+    size_t write(std::string_view data) noexcept;
+    // }}}
+
+    // {{{ consumer
+    /// Returns the contiguous bytes that are ready to be read by the consumer.
+    [[nodiscard]] std::string_view readable() noexcept;
+
+    /// Releases the first @p count bytes of readable(), making their space available to the producer.
+    void consume(size_t count) noexcept;
+    // }}}
+
+  private:
+    char* _buffer = nullptr;
+    size_t _capacity = 0;
+    bool _mirrored = false;
+
+    // Total number of bytes written, and the producer's last seen value of _tail.
+    alignas(64) std::atomic<size_t> _head = 0;
+    size_t _cachedTail = 0;
+
+    // Total number of bytes consumed, and the consumer's last seen value of _head.
+    alignas(64) std::atomic<size_t> _tail = 0;
+    size_t _cachedHead = 0;
+};
+
+/// Scans the readable bytes of @p ring with scan_text() and releases all bytes that are processed.
+///
+/// An incomplete UTF-8 sequence at the end of the readable bytes is carried in @p state,
+/// while its bytes are kept in the ring until the sequence is completed, so that the returned
+/// scan_result (whose start may point before the readable bytes when resuming that sequence)
+/// always refers to contiguous, valid memory.
+///
+/// Like scan_text(), this stops at control characters, which are left in the ring.
+scan_result scan_text(scan_state& state,
+                      byte_ring& ring,
+                      size_t maxColumnCount,
+                      grapheme_cluster_receiver& receiver) noexcept;
+
+} // namespace unicode
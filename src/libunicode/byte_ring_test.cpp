@@ -0,0 +1,148 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/byte_ring.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <thread>
+
+using std::string;
+using std::string_view;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+// Advances the ring's read and write position to @p count bytes before the wrap-around point.
+void moveToEnd(unicode::byte_ring& ring, size_t count)
+{
+    auto const filler = string(ring.capacity() - count, '.');
+    REQUIRE(ring.write(filler) == filler.size());
+    while (!ring.readable().empty())
+        ring.consume(ring.readable().size());
+}
+
+} // namespace
+
+TEST_CASE("byte_ring.capacity")
+{
+    auto const ring = unicode::byte_ring(5000);
+    CHECK(ring.capacity() >= 5000);
+    CHECK((ring.capacity() & (ring.capacity() - 1)) == 0);
+}
+
+TEST_CASE("byte_ring.write_and_consume")
+{
+    auto ring = unicode::byte_ring(4096);
+    CHECK(ring.readable().empty());
+    CHECK(ring.writable().size() == ring.capacity());
+
+    CHECK(ring.write("Hello"sv) == 5);
+    CHECK(ring.readable() == "Hello");
+    CHECK(ring.writable().size() == ring.capacity() - 5);
+
+    ring.consume(2);
+    CHECK(ring.readable() == "llo");
+
+    // The ring does not accept more bytes than it has space for.
+    CHECK(ring.write(string(ring.capacity(), 'x')) == ring.capacity() - 3);
+    CHECK(ring.writable().empty());
+}
+
+TEST_CASE("byte_ring.wrap_around")
+{
+    auto ring = unicode::byte_ring(4096);
+    moveToEnd(ring, 4);
+
+    CHECK(ring.write("0123456789"sv) == 10);
+    if (ring.mirrored())
+        CHECK(ring.readable() == "0123456789");
+    else
+        CHECK(ring.readable() == "0123456");
+
+    auto received = string {};
+    while (!ring.readable().empty())
+    {
+        received += ring.readable();
+        ring.consume(ring.readable().size());
+    }
+    CHECK(received == "0123456789");
+}
+
+TEST_CASE("byte_ring.scan_text_incomplete")
+{
+    auto ring = unicode::byte_ring(4096);
+    moveToEnd(ring, 3);
+    auto state = unicode::scan_state {};
+
+    ring.write("ab\xF0\x9F"sv);
+    auto result = unicode::scan_text(state, ring, 80, unicode::null_receiver::get());
+    CHECK(result.count == 2);
+
+    // The incomplete sequence is kept in the ring.
+    CHECK(ring.readable() == "\xF0\x9F");
+
+    ring.write("\x98\x80"
+               "cd"sv);
+    result = unicode::scan_text(state, ring, 80, unicode::null_receiver::get());
+    CHECK(result.count == 4);
+    CHECK(string_view(result.start, static_cast<size_t>(result.end - result.start)) == "\xF0\x9F\x98\x80"
+                                                                                      "cd");
+    CHECK(ring.readable().empty());
+}
+
+TEST_CASE("byte_ring.threads")
+{
+    auto constexpr TotalSize = size_t { 4 * 1024 * 1024 };
+    auto ring = unicode::byte_ring(4096);
+
+    auto producer = std::thread([&]() {
+        auto chunk = string(1000, '\0');
+        for (size_t written = 0; written < TotalSize;)
+        {
+            for (size_t i = 0; i < chunk.size(); ++i)
+                chunk[i] = static_cast<char>((written + i) % 251);
+            auto remaining = string_view(chunk).substr(0, std::min(chunk.size(), TotalSize - written));
+            while (!remaining.empty())
+            {
+                auto const count = ring.write(remaining);
+                remaining.remove_prefix(count);
+                written += count;
+                if (!count)
+                    std::this_thread::yield();
+            }
+        }
+    });
+
+    auto mismatches = size_t { 0 };
+    for (size_t received = 0; received < TotalSize;)
+    {
+        auto const bytes = ring.readable();
+        if (bytes.empty())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < bytes.size(); ++i)
+            mismatches += bytes[i] != static_cast<char>((received + i) % 251);
+        ring.consume(bytes.size());
+        received += bytes.size();
+    }
+    producer.join();
+
+    CHECK(mismatches == 0);
+}
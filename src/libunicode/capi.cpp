@@ -14,9 +14,11 @@
 #include <libunicode/capi.h>
 #include <libunicode/convert.h>
 #include <libunicode/grapheme_segmenter.h>
+#include <libunicode/instrumentation.h>
 #include <libunicode/ucd.h>
 #include <libunicode/width.h>
 
+#include <algorithm>
 #include <iterator>
 
 int u32_gc_count(u32_char_t const* codepoints, size_t size)
@@ -133,3 +135,34 @@ int u32u8_convert(u32_char_t const* source, size_t slen, u8_char_t* dest, size_t
 
     return nwritten;
 }
+
+int u_instrumentation_enabled(void)
+{
+    return unicode::instrumentation::enabled ? 1 : 0;
+}
+
+size_t u_instrumentation_counter_count(void)
+{
+    return unicode::instrumentation::counter_count;
+}
+
+char const* u_instrumentation_counter_name(size_t index)
+{
+    if (index >= unicode::instrumentation::counter_count)
+        return nullptr;
+    // The names are string literals, thus zero-terminated.
+    return unicode::instrumentation::name(static_cast<unicode::instrumentation::counter>(index)).data();
+}
+
+size_t u_instrumentation_snapshot(uint64_t* values, size_t n)
+{
+    auto const snapshot = unicode::instrumentation::snapshot();
+    auto const count = std::min(n, snapshot.values.size());
+    std::copy_n(snapshot.values.begin(), count, values);
+    return count;
+}
+
+void u_instrumentation_reset(void)
+{
+    unicode::instrumentation::reset();
+}
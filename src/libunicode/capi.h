@@ -201,6 +201,40 @@ extern "C"
      */
     int u32u8_convert(u32_char_t const* source, size_t slen, u8_char_t* dest, size_t dlen);
 
+    /**
+     * Tests if the library was built with hot-path instrumentation counters (LIBUNICODE_INSTRUMENTATION=ON).
+     *
+     * @retval 1 counters are collected.
+     * @retval 0 counters are compiled out and always read as zero.
+     */
+    int u_instrumentation_enabled(void);
+
+    /**
+     * Returns the number of instrumentation counters.
+     */
+    size_t u_instrumentation_counter_count(void);
+
+    /**
+     * Returns the name of the instrumentation counter at @p index, such as "scan_ascii_runs",
+     * or NULL if @p index is out of range.
+     */
+    char const* u_instrumentation_counter_name(size_t index);
+
+    /**
+     * Copies the calling thread's instrumentation counters into @p values.
+     *
+     * @param values Destination for the counter values, in the order of u_instrumentation_counter_name().
+     * @param n      Number of values to store at most.
+     *
+     * @returns the number of values stored.
+     */
+    size_t u_instrumentation_snapshot(uint64_t* values, size_t n);
+
+    /**
+     * Resets the calling thread's instrumentation counters to zero.
+     */
+    void u_instrumentation_reset(void);
+
 #if !defined(__cplusplus)
 }
 #endif
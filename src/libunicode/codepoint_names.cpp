@@ -0,0 +1,56 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_properties.h>
+#include <libunicode/codepoint_properties_data.h>
+
+#include <string_view>
+#include <vector>
+
+namespace unicode
+{
+
+namespace
+{
+    // The precompiled names (see unicode_tablegen's write_cxx_names_table()), resolved once upon loading this library.
+    // The name index shares stage 1 and 2 with the resolved names.
+    std::vector<std::string_view> const precompiledNames = [] {
+        auto result = std::vector<std::string_view> {};
+        result.reserve(precompiled::names_stage3.size());
+        for (auto const entry: precompiled::names_stage3)
+        {
+            auto const offset = entry & 0xFFFF;
+            auto const chunk = (entry >> 16) & 0xFF;
+            auto const length = entry >> 24;
+            result.emplace_back(precompiled::names_chunks[chunk] + offset, length);
+        }
+        return result;
+    }();
+
+    auto precompiledNamesView = codepoint_properties::names_view {
+        precompiled::names_stage1.data(),
+        precompiled::names_stage2.data(),
+        precompiledNames.data(),
+    };
+} // namespace
+
+codepoint_properties::names_view& codepoint_properties::configured_names = precompiledNamesView;
+
+std::string_view codepoint_properties::name(char32_t codepoint)
+{
+    if (auto const& names = _published.load(std::memory_order_acquire)->names; names.stage3)
+        return names.get(codepoint);
+    return configured_names.get(codepoint);
+}
+
+} // namespace unicode
@@ -0,0 +1,146 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_overlay.h>
+#include <libunicode/profiler.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace unicode
+{
+
+namespace
+{
+    using tables_view = codepoint_properties::tables_view;
+
+    auto constexpr BlockSize = tables_view::block_size;
+    auto constexpr BlockCount = (0x10FFFF + 1) / BlockSize;
+
+    using stage2_block = std::array<tables_view::stage2_element_type, BlockSize>;
+
+    struct properties_less
+    {
+        bool operator()(codepoint_properties const& a, codepoint_properties const& b) const noexcept
+        {
+            return std::memcmp(&a, &b, sizeof(codepoint_properties)) < 0;
+        }
+    };
+
+    struct overlay_tables
+    {
+        std::shared_ptr<codepoint_properties::table_set const> base;
+        std::vector<tables_view::stage1_element_type> stage1;
+        std::vector<tables_view::stage2_element_type> stage2;
+        std::vector<codepoint_properties> stage3;
+        codepoint_properties::table_set tables;
+    };
+} // namespace
+
+codepoint_overlay& codepoint_overlay::modify(char32_t first, char32_t last, modifier modify)
+{
+    if (first > last || last > 0x10FFFF)
+        throw std::invalid_argument("Invalid codepoint range.");
+    _overrides.push_back({ first, last, std::move(modify) });
+    return *this;
+}
+
+codepoint_overlay& codepoint_overlay::set_width(char32_t first, char32_t last, uint8_t width)
+{
+    return modify(first, last, [width](codepoint_properties& properties) { properties.char_width = width; });
+}
+
+std::shared_ptr<codepoint_properties::table_set const> codepoint_overlay::build(
+    std::shared_ptr<codepoint_properties::table_set const> base) const
+{
+    auto const _ = support::profiler::scope { "codepoint_overlay::build" };
+    auto const baseTables = base ? base->properties : codepoint_properties::configured_tables;
+
+    auto overlay = std::make_shared<overlay_tables>();
+    overlay->base = std::move(base);
+
+    // Copy the base tables' indices and properties, as far as they are referenced.
+    overlay->stage1.assign(baseTables.stage1, baseTables.stage1 + BlockCount);
+    auto const baseBlockCount = size_t { *std::max_element(overlay->stage1.begin(), overlay->stage1.end()) } + 1;
+    overlay->stage2.assign(baseTables.stage2, baseTables.stage2 + baseBlockCount * BlockSize);
+    auto const basePropertyCount = size_t { *std::max_element(overlay->stage2.begin(), overlay->stage2.end()) } + 1;
+    overlay->stage3.assign(baseTables.stage3, baseTables.stage3 + basePropertyCount);
+
+    auto propertyIndices = std::map<codepoint_properties, tables_view::stage2_element_type, properties_less> {};
+    for (size_t i = 0; i < overlay->stage3.size(); ++i)
+        propertyIndices.emplace(overlay->stage3[i], static_cast<tables_view::stage2_element_type>(i));
+
+    auto const indexOf = [&](codepoint_properties const& properties) {
+        auto const [i, inserted] =
+            propertyIndices.emplace(properties, static_cast<tables_view::stage2_element_type>(overlay->stage3.size()));
+        if (inserted)
+        {
+            if (overlay->stage3.size() > std::numeric_limits<tables_view::stage2_element_type>::max())
+                throw std::length_error("Too many distinct codepoint properties.");
+            overlay->stage3.push_back(properties);
+        }
+        return i->second;
+    };
+
+    auto touchedBlocks = std::set<size_t> {};
+    for (auto const& range: _overrides)
+        for (auto block = range.first / BlockSize; block <= range.last / BlockSize; ++block)
+            touchedBlocks.insert(block);
+
+    // Copy-on-write of the touched blocks, sharing identical copies.
+    auto addedBlocks = std::map<stage2_block, tables_view::stage1_element_type> {};
+    for (auto const block: touchedBlocks)
+    {
+        auto const blockStart = static_cast<char32_t>(block * BlockSize);
+        auto properties = std::array<codepoint_properties, BlockSize> {};
+        for (size_t i = 0; i < BlockSize; ++i)
+            properties[i] = baseTables.unsafe_get(blockStart + static_cast<char32_t>(i));
+        for (auto const& range: _overrides)
+        {
+            auto const first = std::max(range.first, blockStart);
+            auto const last = std::min(range.last, static_cast<char32_t>(blockStart + BlockSize - 1));
+            for (auto codepoint = first; codepoint <= last; ++codepoint)
+                range.modify(properties[codepoint - blockStart]);
+        }
+
+        auto indices = stage2_block {};
+        std::transform(properties.begin(), properties.end(), indices.begin(), indexOf);
+        if (std::equal(indices.begin(), indices.end(), overlay->stage2.begin() + overlay->stage1[block] * BlockSize))
+            continue;
+
+        auto const [i, inserted] =
+            addedBlocks.emplace(indices, static_cast<tables_view::stage1_element_type>(overlay->stage2.size() / BlockSize));
+        if (inserted)
+        {
+            if (overlay->stage2.size() / BlockSize > std::numeric_limits<tables_view::stage1_element_type>::max())
+                throw std::length_error("Too many distinct codepoint property blocks.");
+            overlay->stage2.insert(overlay->stage2.end(), indices.begin(), indices.end());
+        }
+        overlay->stage1[block] = i->second;
+    }
+
+    auto const names = overlay->base ? overlay->base->names : codepoint_properties::names_view {};
+    overlay->tables = codepoint_properties::table_set {
+        tables_view { overlay->stage1.data(), overlay->stage2.data(), overlay->stage3.data() },
+        names,
+    };
+    return std::shared_ptr<codepoint_properties::table_set const>(overlay, &overlay->tables);
+}
+
+} // namespace unicode
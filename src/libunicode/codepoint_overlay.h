@@ -0,0 +1,68 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/codepoint_properties.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace unicode
+{
+
+/// Overrides of codepoint properties for codepoint ranges, such as widths of private use glyphs,
+/// layered over base tables.
+///
+/// The built tables reuse the base tables' stage 2 blocks and properties, adding copies of only those
+/// blocks that contain overridden codepoints (identical ones being shared), and the names are shared as is.
+/// Lookups cost the same as with the base tables.
+///
+/// @code
+/// codepoint_properties::publish(codepoint_overlay {}.set_width(0xE000, 0xF8FF, 2).build());
+/// @endcode
+class codepoint_overlay
+{
+  public:
+    using modifier = std::function<void(codepoint_properties&)>;
+
+    /// Overrides the properties of the codepoints in the closed range [first, last] by applying @p modify to them.
+    ///
+    /// Overrides are applied in the order they were added.
+    ///
+    /// @throws std::invalid_argument if the range is empty or exceeds U+10FFFF.
+    codepoint_overlay& modify(char32_t first, char32_t last, modifier modify);
+
+    /// Overrides the width of the codepoints in the closed range [first, last].
+    codepoint_overlay& set_width(char32_t first, char32_t last, uint8_t width);
+
+    /// Builds the tables with all overrides applied over @p base, or the configured tables if nullptr.
+    ///
+    /// @throws std::length_error if the overridden tables exceed the tables' index types.
+    [[nodiscard]] std::shared_ptr<codepoint_properties::table_set const> build(
+        std::shared_ptr<codepoint_properties::table_set const> base = nullptr) const;
+
+  private:
+    struct override_range
+    {
+        char32_t first;
+        char32_t last;
+        modifier modify;
+    };
+
+    std::vector<override_range> _overrides;
+};
+
+} // namespace unicode
@@ -0,0 +1,83 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_overlay.h>
+#include <libunicode/width.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <ios>
+#include <stdexcept>
+
+using unicode::codepoint_overlay;
+using unicode::codepoint_properties;
+
+TEST_CASE("codepoint_overlay.set_width")
+{
+    // Nerd Font glyphs in the private use area, and ambiguous width box drawing characters.
+    auto const tables = codepoint_overlay {}.set_width(0xE000, 0xF8FF, 2).set_width(0x2500, 0x2502, 2).build();
+
+    for (char32_t codepoint = 0; codepoint <= 0x10FFFF; ++codepoint)
+    {
+        auto const overridden = (codepoint >= 0xE000 && codepoint <= 0xF8FF) || (codepoint >= 0x2500 && codepoint <= 0x2502);
+        auto expected = codepoint_properties::get(codepoint);
+        if (overridden)
+            expected.char_width = 2;
+        if (tables->properties.get(codepoint) != expected)
+        {
+            INFO("codepoint U+" << std::hex << static_cast<uint32_t>(codepoint));
+            REQUIRE(tables->properties.get(codepoint) == expected);
+        }
+    }
+    CHECK(tables->names.stage3 == nullptr); // i.e. the configured names
+
+    // The private use area blocks are all alike, and thus share one copy.
+    auto const baseStage2 = codepoint_properties::configured_tables.stage2;
+    CHECK(tables->properties.stage1[0xE0] == tables->properties.stage1[0xF8]);
+    CHECK(std::equal(tables->properties.stage2, tables->properties.stage2 + 0x2400, baseStage2));
+
+    codepoint_properties::publish(tables);
+    CHECK(unicode::width(0xE0A0) == 2);
+    CHECK(unicode::width(0x2501) == 2);
+    CHECK(unicode::width(0x2503) == 1);
+#if !defined(LIBUNICODE_NO_NAMES)
+    CHECK(codepoint_properties::name(U'A') == "LATIN CAPITAL LETTER A");
+#endif
+    codepoint_properties::publish(nullptr);
+    CHECK(unicode::width(0xE0A0) == 1);
+}
+
+TEST_CASE("codepoint_overlay.layered")
+{
+    auto const base = codepoint_overlay {}.set_width(0xE000, 0xE0FF, 2).build();
+    auto const tables = codepoint_overlay {}
+                            .modify(0xE080,
+                                    0xE17F,
+                                    [](codepoint_properties& properties) {
+                                        properties.char_width += 1;
+                                        properties.grapheme_cluster_break = unicode::Grapheme_Cluster_Break::Control;
+                                    })
+                            .build(base);
+
+    CHECK(tables->properties.get(0xE07F).char_width == 2);
+    CHECK(tables->properties.get(0xE080).char_width == 3);
+    CHECK(tables->properties.get(0xE100).char_width == 2);
+    CHECK(tables->properties.get(0xE180).char_width == 1);
+    CHECK(tables->properties.get(0xE100).grapheme_cluster_break == unicode::Grapheme_Cluster_Break::Control);
+    CHECK(tables->properties.get(0xE180).grapheme_cluster_break == unicode::Grapheme_Cluster_Break::Other);
+    CHECK(base->properties.get(0xE080).char_width == 2);
+
+    CHECK_THROWS_AS(codepoint_overlay {}.set_width(0x20, 0x10, 1), std::invalid_argument);
+    CHECK_THROWS_AS(codepoint_overlay {}.set_width(0x20, 0x110000, 1), std::invalid_argument);
+}
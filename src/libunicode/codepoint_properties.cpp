@@ -13,18 +13,107 @@
  */
 #include <libunicode/codepoint_properties.h>
 #include <libunicode/codepoint_properties_data.h>
+#include <libunicode/usdt.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace unicode
 {
 
-codepoint_properties::tables_view codepoint_properties::configured_tables { precompiled::stage1.data(),
-                                                                            precompiled::stage2.data(),
-                                                                            precompiled::properties.data() };
+namespace
+{
+    codepoint_properties::table_set precompiledTables {
+        codepoint_properties::tables_view {
+            precompiled::stage1.data(),
+            precompiled::stage2.data(),
+            precompiled::properties.data(),
+        },
+        codepoint_properties::names_view {}, // see codepoint_names.cpp
+    };
+
+    // Quiescent-state-based reclamation of published tables.
+    //
+    // Publishing advances the global epoch, retiring the previous tables with the new epoch.
+    // Readers record the global epoch in quiescent states, so that retired tables can be released
+    // as soon as every reader has recorded their retirement epoch (or a later one).
+    struct reclamation
+    {
+        struct retired_tables
+        {
+            uint64_t epoch;
+            std::shared_ptr<codepoint_properties::table_set const> tables;
+        };
+
+        std::mutex mutex;
+        std::atomic<uint64_t> epoch = 1;
+        std::vector<std::atomic<uint64_t> const*> readers;
+        std::shared_ptr<codepoint_properties::table_set const> published;
+        std::vector<retired_tables> retired;
+
+        size_t reclaim_locked()
+        {
+            auto oldestReader = std::numeric_limits<uint64_t>::max();
+            for (auto const* reader: readers)
+                oldestReader = std::min(oldestReader, reader->load(std::memory_order_acquire));
+            std::erase_if(retired, [&](retired_tables const& entry) { return entry.epoch <= oldestReader; });
+            return retired.size();
+        }
+    };
+
+    reclamation& reclamation_state()
+    {
+        static auto state = reclamation {};
+        return state;
+    }
+} // namespace
+
+codepoint_properties::tables_view& codepoint_properties::configured_tables = precompiledTables.properties;
+
+std::atomic<codepoint_properties::table_set const*> codepoint_properties::_published { &precompiledTables };
+
+void codepoint_properties::publish(std::shared_ptr<table_set const> tables)
+{
+    auto& state = reclamation_state();
+    auto const _ = std::lock_guard { state.mutex };
+
+    _published.store(tables ? tables.get() : &precompiledTables, std::memory_order_seq_cst);
+    auto const retirementEpoch = state.epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    if (auto previous = std::exchange(state.published, std::move(tables)))
+        state.retired.push_back({ retirementEpoch, std::move(previous) });
+    [[maybe_unused]] auto const retiredCount = state.reclaim_locked();
+    LIBUNICODE_PROBE2(tables_publish, _published.load(std::memory_order_relaxed), retiredCount);
+}
 
-codepoint_properties::names_view codepoint_properties::configured_names {
-    precompiled::names_stage1.data(),
-    precompiled::names_stage2.data(),
-    precompiled::names_stage3.data(),
-};
+size_t codepoint_properties::reclaim()
+{
+    auto& state = reclamation_state();
+    auto const _ = std::lock_guard { state.mutex };
+    return state.reclaim_locked();
+}
+
+codepoint_properties::table_reader::table_reader()
+{
+    auto& state = reclamation_state();
+    auto const _ = std::lock_guard { state.mutex };
+    _epoch.store(state.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    state.readers.push_back(&_epoch);
+}
+
+codepoint_properties::table_reader::~table_reader()
+{
+    auto& state = reclamation_state();
+    auto const _ = std::lock_guard { state.mutex };
+    std::erase(state.readers, &_epoch);
+    state.reclaim_locked();
+}
+
+void codepoint_properties::table_reader::quiescent() noexcept
+{
+    _epoch.store(reclamation_state().epoch.load(std::memory_order_seq_cst), std::memory_order_release);
+}
 
 } // namespace unicode
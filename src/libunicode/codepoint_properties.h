@@ -18,21 +18,42 @@
 #include <libunicode/support.h>   // Only for LIBUNICODE_PACKED.
 #include <libunicode/ucd_enums.h> // Only for the UCD enums.
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
 #include <type_traits>
 
 namespace unicode
 {
 
+/// Unicode properties of a single codepoint.
+///
+/// When built with LIBUNICODE_TABLES=minimal (defining LIBUNICODE_MINIMAL_TABLES), the tables only provide
+/// char_width, grapheme_cluster_break and the FlagExtendedPictographic flag. The omitted properties
+/// and the accessors of the omitted flags are unavailable, their storage being kept as reserved bytes,
+/// so that the record layout (and thus tables created by the loader) is the same in all builds.
 struct LIBUNICODE_PACKED codepoint_properties
 {
     uint8_t char_width = 0;
     uint8_t flags = 0;
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
     Script script = Script::Unknown;
     Grapheme_Cluster_Break grapheme_cluster_break = Grapheme_Cluster_Break::Other;
     East_Asian_Width east_asian_width = East_Asian_Width::Narrow;
     General_Category general_category = General_Category::Unassigned;
     EmojiSegmentationCategory emoji_segmentation_category = EmojiSegmentationCategory::Invalid;
     Age age = Age::Unassigned;
+#else
+    uint8_t reserved1 = static_cast<uint8_t>(Script::Unknown);
+    Grapheme_Cluster_Break grapheme_cluster_break = Grapheme_Cluster_Break::Other;
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+    uint8_t reserved2[4] = { static_cast<uint8_t>(East_Asian_Width::Narrow),
+                             static_cast<uint8_t>(General_Category::Unassigned),
+                             static_cast<uint8_t>(EmojiSegmentationCategory::Invalid),
+                             static_cast<uint8_t>(Age::Unassigned) };
+#endif
 
     static uint8_t constexpr FlagEmoji = 0x01;                // NOLINT(readability-identifier-naming)
     static uint8_t constexpr FlagEmojiPresentation = 0x02;    // NOLINT(readability-identifier-naming)
@@ -42,13 +63,17 @@ struct LIBUNICODE_PACKED codepoint_properties
     static uint8_t constexpr FlagExtendedPictographic = 0x20; // NOLINT(readability-identifier-naming)
     static uint8_t constexpr FlagCoreGraphemeExtend = 0x40;   // NOLINT(readability-identifier-naming)
 
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
     constexpr bool emoji() const noexcept { return flags & FlagEmoji; }
     constexpr bool emoji_presentation() const noexcept { return flags & FlagEmojiPresentation; }
     constexpr bool emoji_component() const noexcept { return flags & FlagEmojiComponent; }
     constexpr bool emoji_modifier() const noexcept { return flags & FlagEmojiModifier; }
     constexpr bool emoji_modifier_base() const noexcept { return flags & FlagEmojiModifierBase; }
+#endif
     constexpr bool extended_pictographic() const noexcept { return flags & FlagExtendedPictographic; }
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
     constexpr bool core_grapheme_extend() const noexcept { return flags & FlagCoreGraphemeExtend; }
+#endif
 
     using tables_view = support::multistage_table_view<codepoint_properties,
                                                        uint32_t,     // source type
@@ -66,13 +91,71 @@ struct LIBUNICODE_PACKED codepoint_properties
                                                       0x110'000 - 1 // max value
                                                       >;
 
-    static tables_view configured_tables;
-    static names_view configured_names;
+    /// Codepoint property and name tables, as published via publish().
+    struct table_set
+    {
+        tables_view properties;
+        names_view names; // null for the configured names (see name())
+    };
+
+    /// The tables used unless others got published, initially the precompiled properties and names.
+    ///
+    /// Assigning them is not thread-safe, use publish() instead when other threads may be reading.
+    static tables_view& configured_tables;
+#if !defined(LIBUNICODE_NO_NAMES)
+    /// Provided by the separate unicode::names library, like name().
+    static names_view& configured_names;
+#endif
 
     /// Retrieves the codepoint properties for the given codepoint.
-    [[nodiscard]] static codepoint_properties get(char32_t codepoint) noexcept { return configured_tables.get(codepoint); }
+    [[nodiscard]] static codepoint_properties get(char32_t codepoint) noexcept
+    {
+        return _published.load(std::memory_order_acquire)->properties.get(codepoint);
+    }
+
+#if !defined(LIBUNICODE_NO_NAMES)
+    /// Retrieves the name of the given codepoint.
+    ///
+    /// Falls back to the configured names unless tables with names got published.
+    /// This function is provided by the separate unicode::names library, so that processes not needing names
+    /// do not load them.
+    [[nodiscard]] static std::string_view name(char32_t codepoint);
+#endif
+
+    /// Atomically replaces the tables used by get() and name(), while other threads may be reading them.
+    ///
+    /// The previously published tables are retired, and released once every registered table_reader
+    /// has passed a quiescent state. Publishing nullptr reverts to the configured tables.
+    static void publish(std::shared_ptr<table_set const> tables);
+
+    /// Releases retired tables no longer in use by any registered reader.
+    ///
+    /// @returns the number of retired table sets still in use.
+    static size_t reclaim();
+
+    /// Registers the constructing thread as reader of published tables, for as long as it lives.
+    ///
+    /// Reading tables costs no more than a single acquire load. Instead, each reader declares a quiescent
+    /// state by calling quiescent() whenever it does not hold on to any data retrieved from the tables
+    /// (such as names), e.g. once per processed input chunk.
+    /// Threads reading while tables are being published must be registered.
+    class table_reader
+    {
+      public:
+        table_reader();
+        ~table_reader();
+        table_reader(table_reader const&) = delete;
+        table_reader& operator=(table_reader const&) = delete;
+
+        /// Declares that the calling thread does not refer to any previously retrieved table data.
+        void quiescent() noexcept;
+
+      private:
+        std::atomic<uint64_t> _epoch;
+    };
 
-    [[nodiscard]] static std::string_view name(char32_t codepoint) { return configured_names.get(codepoint); }
+  private:
+    static std::atomic<table_set const*> _published;
 };
 
 static_assert(std::has_unique_object_representations_v<codepoint_properties>);
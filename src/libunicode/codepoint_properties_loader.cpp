@@ -13,13 +13,16 @@
  */
 #include <libunicode/codepoint_properties_loader.h>
 #include <libunicode/multistage_table_generator.h>
+#include <libunicode/profiler.h>
 #include <libunicode/scoped_timer.h>
 #include <libunicode/ucd_enums.h>
+#include <libunicode/usdt.h>
 
 #include <cassert>
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <optional>
 #include <regex>
 #include <string_view>
@@ -429,13 +432,13 @@ namespace
     class codepoint_properties_loader
     {
       public:
-        static std::tuple<codepoint_properties_table, codepoint_names_table> load_from_directory(string const& ucdDataDirectory,
-                                                                                                 std::ostream* log = nullptr);
+        static std::tuple<codepoint_properties_table, codepoint_names_table> load_from_directory(
+            string const& ucdDataDirectory, std::ostream* log, std::pmr::memory_resource* resource);
 
       private:
         using tables_view = codepoint_properties::tables_view;
 
-        codepoint_properties_loader(string ucdDataDirectory, std::ostream* log = nullptr);
+        codepoint_properties_loader(string ucdDataDirectory, std::ostream* log, std::pmr::memory_resource* resource);
 
         void load();
         void create_multistage_tables();
@@ -482,15 +485,17 @@ namespace
 
         string _ucdDataDirectory;
         std::ostream* _log;
-        vector<codepoint_properties> _codepoints {}; // Meh!
+        std::pmr::vector<codepoint_properties> _codepoints; // Meh!
         codepoint_properties_table _output {};
 
-        vector<std::string> _names {};
+        std::pmr::vector<std::pmr::string> _names;
         codepoint_names_table _outputNames {};
     };
 
-    codepoint_properties_loader::codepoint_properties_loader(string ucdDataDirectory, std::ostream* log):
-        _ucdDataDirectory { std::move(ucdDataDirectory) }, _log { log }
+    codepoint_properties_loader::codepoint_properties_loader(string ucdDataDirectory,
+                                                             std::ostream* log,
+                                                             std::pmr::memory_resource* resource):
+        _ucdDataDirectory { std::move(ucdDataDirectory) }, _log { log }, _codepoints { resource }, _names { resource }
     {
         _codepoints.resize(0x110'000);
         _names.resize(0x110'000);
@@ -527,7 +532,7 @@ namespace
 
         // Prep-work for names loading
         process_properties("extracted/DerivedName.txt", [&](char32_t codepoint, string_view value) {
-            _names[static_cast<size_t>(codepoint)] = string(value.data(), value.size());
+            _names[static_cast<size_t>(codepoint)].assign(value.data(), value.size());
         });
 
         process_properties("auxiliary/GraphemeBreakProperty.txt", [&](char32_t codepoint, string_view value) {
@@ -591,11 +596,18 @@ namespace
     }
 
     std::tuple<codepoint_properties_table, codepoint_names_table> codepoint_properties_loader::load_from_directory(
-        string const& ucdDataDirectory, std::ostream* log)
+        string const& ucdDataDirectory, std::ostream* log, std::pmr::memory_resource* resource)
     {
-        auto loader = codepoint_properties_loader { ucdDataDirectory, log };
-        loader.load();
-        loader.create_multistage_tables();
+        auto const _ = support::profiler::scope { "load_from_directory" };
+        auto loader = codepoint_properties_loader { ucdDataDirectory, log, resource };
+        {
+            auto const _ = support::profiler::scope { "Loading UCD files" };
+            loader.load();
+        }
+        {
+            auto const _ = support::profiler::scope { "Creating multistage tables" };
+            loader.create_multistage_tables();
+        }
 
         return { std::move(loader._output), std::move(loader._outputNames) };
     }
@@ -613,7 +625,7 @@ namespace
         {
             auto const _ = scoped_timer { _log, "Creating multistage tables (names)" };
             support::generate(
-                _names.data(), _names.size(), _outputNames, [&](auto const& begin, auto const& end, auto value) noexcept {
+                _names.data(), _names.size(), _outputNames, [&](auto const& begin, auto const& end, string_view value) noexcept {
 #if defined(LIBUNICODE_TABLEGEN_FASTBUILD)
                     if (value.empty())
                         // This case is happening for unassigned codepoints (and quite a lot)
@@ -631,9 +643,35 @@ namespace
 } // namespace
 
 std::tuple<codepoint_properties_table, codepoint_names_table> load_from_directory(std::string const& ucdDataDirectory,
-                                                                                  std::ostream* log)
+                                                                                  std::ostream* log,
+                                                                                  std::pmr::memory_resource* resource)
 {
-    return codepoint_properties_loader::load_from_directory(ucdDataDirectory, log);
+    LIBUNICODE_PROBE1(tables_load_begin, ucdDataDirectory.c_str());
+    auto tables = codepoint_properties_loader::load_from_directory(ucdDataDirectory, log, resource);
+    LIBUNICODE_PROBE2(tables_load_end, std::get<0>(tables).stage3.size(), std::get<1>(tables).stage3.size());
+    return tables;
+}
+
+std::shared_ptr<codepoint_properties::table_set const> make_table_set(codepoint_properties_table properties,
+                                                                      codepoint_names_table names)
+{
+    struct owning_table_set
+    {
+        codepoint_properties_table properties;
+        codepoint_names_table names;
+        std::vector<std::string_view> nameViews;
+        codepoint_properties::table_set tables;
+    };
+
+    auto owner = std::make_shared<owning_table_set>();
+    owner->properties = std::move(properties);
+    owner->names = std::move(names);
+    owner->nameViews.assign(owner->names.stage3.begin(), owner->names.stage3.end());
+    owner->tables = codepoint_properties::table_set {
+        owner->properties.to_view(),
+        codepoint_properties::names_view { owner->names.stage1.data(), owner->names.stage2.data(), owner->nameViews.data() },
+    };
+    return std::shared_ptr<codepoint_properties::table_set const>(owner, &owner->tables);
 }
 
 } // namespace unicode
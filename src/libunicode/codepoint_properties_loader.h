@@ -16,6 +16,9 @@
 #include <libunicode/codepoint_properties.h>
 #include <libunicode/multistage_table_generator.h>
 
+#include <memory>
+#include <memory_resource>
+#include <tuple>
 #include <vector>
 
 namespace unicode
@@ -37,7 +40,16 @@ using codepoint_names_table = support::multistage_table<std::string,
                                                         0x110'000 - 1 // max value
                                                         >;
 
-std::tuple<codepoint_properties_table, codepoint_names_table> load_from_directory(std::string const& ucdDataDirectory,
-                                                                                  std::ostream* log);
+/// Loads the codepoint properties and names from the Unicode Character Database in the given directory.
+///
+/// The temporary per-codepoint data used while building the tables is allocated from @p resource.
+std::tuple<codepoint_properties_table, codepoint_names_table> load_from_directory(
+    std::string const& ucdDataDirectory,
+    std::ostream* log,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+/// Creates a table set, owning the given tables, to be published via codepoint_properties::publish().
+std::shared_ptr<codepoint_properties::table_set const> make_table_set(codepoint_properties_table properties,
+                                                                      codepoint_names_table names);
 
 } // namespace unicode
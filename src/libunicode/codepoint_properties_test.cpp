@@ -0,0 +1,171 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_properties.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using unicode::codepoint_properties;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+std::atomic<int> liveTableSets = 0;
+
+// Tables mapping every codepoint to the same properties and name.
+struct uniform_tables
+{
+    std::vector<uint8_t> stage1;
+    std::vector<uint16_t> stage2;
+    std::vector<codepoint_properties> stage3;
+    std::vector<std::string_view> names;
+    codepoint_properties::table_set tables;
+
+    explicit uniform_tables(uint8_t width):
+        stage1(0x110'000 / 256, 0), stage2(256, 0), stage3(1, codepoint_properties { width }), names(1, "UNIFORM"sv)
+    {
+        tables.properties = { stage1.data(), stage2.data(), stage3.data() };
+        tables.names = { stage1.data(), stage2.data(), names.data() };
+        ++liveTableSets;
+    }
+
+    ~uniform_tables()
+    {
+        // Poison, making use-after-reclaim observable.
+        std::fill(stage3.begin(), stage3.end(), codepoint_properties { 0xFF });
+        --liveTableSets;
+    }
+};
+
+std::shared_ptr<codepoint_properties::table_set const> make_uniform_tables(uint8_t width)
+{
+    auto owner = std::make_shared<uniform_tables>(width);
+    return { owner, &owner->tables };
+}
+} // namespace
+
+#if !defined(LIBUNICODE_NO_NAMES)
+TEST_CASE("codepoint_properties.name")
+{
+    CHECK(codepoint_properties::name(U'A') == "LATIN CAPITAL LETTER A");
+    CHECK(codepoint_properties::name(0x1F600) == "GRINNING FACE");
+    CHECK(codepoint_properties::name(0x1FBF9) == "SEGMENTED DIGIT NINE");
+    CHECK(codepoint_properties::name(0x0378).empty()); // unassigned
+    CHECK(codepoint_properties::name(0x110000) == codepoint_properties::name(0));
+}
+
+TEST_CASE("codepoint_properties.configured_names")
+{
+    CHECK(codepoint_properties::configured_names.get(U'A') == "LATIN CAPITAL LETTER A");
+    CHECK(codepoint_properties::configured_names.get(0x1F600) == "GRINNING FACE");
+    CHECK(codepoint_properties::configured_names.get(0x0378).empty());
+
+    // name() falls back to the configured names, whatever they are.
+    auto const uniform = uniform_tables(1);
+    auto const precompiled = codepoint_properties::configured_names;
+    codepoint_properties::configured_names = uniform.tables.names;
+    CHECK(codepoint_properties::name(U'A') == "UNIFORM");
+    codepoint_properties::configured_names = precompiled;
+    CHECK(codepoint_properties::name(U'A') == "LATIN CAPITAL LETTER A");
+}
+#endif
+
+TEST_CASE("codepoint_properties.publish")
+{
+    CHECK(codepoint_properties::get(U'A').char_width == 1);
+
+    codepoint_properties::publish(make_uniform_tables(7));
+    CHECK(codepoint_properties::get(U'A').char_width == 7);
+#if !defined(LIBUNICODE_NO_NAMES)
+    CHECK(codepoint_properties::name(U'A') == "UNIFORM");
+#endif
+    CHECK(liveTableSets == 1);
+
+    // Without any registered readers, retired tables are released right away.
+    codepoint_properties::publish(nullptr);
+    CHECK(codepoint_properties::get(U'A').char_width == 1);
+#if !defined(LIBUNICODE_NO_NAMES)
+    CHECK(codepoint_properties::name(U'A') == "LATIN CAPITAL LETTER A");
+#endif
+    CHECK(liveTableSets == 0);
+    CHECK(codepoint_properties::reclaim() == 0);
+}
+
+TEST_CASE("codepoint_properties.publish.reader")
+{
+    auto reader = std::make_unique<codepoint_properties::table_reader>();
+    codepoint_properties::publish(make_uniform_tables(7));
+#if !defined(LIBUNICODE_NO_NAMES)
+    auto const name = codepoint_properties::name(U'A');
+#endif
+
+    // Retired tables are kept until the reader has passed a quiescent state.
+    codepoint_properties::publish(make_uniform_tables(5));
+    CHECK(codepoint_properties::reclaim() == 1);
+#if !defined(LIBUNICODE_NO_NAMES)
+    CHECK(name == "UNIFORM");
+#endif
+    reader->quiescent();
+    CHECK(codepoint_properties::reclaim() == 0);
+    CHECK(liveTableSets == 1);
+
+    // ... or has been unregistered.
+    codepoint_properties::publish(nullptr);
+    CHECK(codepoint_properties::reclaim() == 1);
+    reader.reset();
+    CHECK(codepoint_properties::reclaim() == 0);
+    CHECK(liveTableSets == 0);
+}
+
+TEST_CASE("codepoint_properties.publish.concurrent")
+{
+    auto constexpr ReaderCount = 4;
+    auto constexpr PublishCount = 1000;
+
+    auto done = std::atomic<bool> { false };
+    auto failures = std::atomic<int> { 0 };
+    auto readers = std::vector<std::thread> {};
+    for (int i = 0; i < ReaderCount; ++i)
+        readers.emplace_back([&]() {
+            auto reader = codepoint_properties::table_reader {};
+            while (!done.load(std::memory_order_relaxed))
+            {
+                for (int k = 0; k < 100; ++k)
+                {
+                    auto const width = codepoint_properties::get(U'A').char_width;
+                    if (width != 1 && width != 2 && width != 3)
+                        ++failures;
+                }
+                reader.quiescent();
+            }
+        });
+
+    for (int i = 0; i < PublishCount; ++i)
+        codepoint_properties::publish(i % 3 == 2 ? nullptr : make_uniform_tables(static_cast<uint8_t>(2 + i % 3)));
+    done = true;
+    for (auto& thread: readers)
+        thread.join();
+
+    codepoint_properties::publish(nullptr);
+    CHECK(failures == 0);
+    CHECK(codepoint_properties::reclaim() == 0);
+    CHECK(liveTableSets == 0);
+}
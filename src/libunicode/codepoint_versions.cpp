@@ -0,0 +1,135 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_versions.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace unicode
+{
+
+namespace
+{
+    using tables_view = codepoint_properties::tables_view;
+
+    auto constexpr BlockSize = tables_view::block_size;
+    auto constexpr BlockCount = (0x10FFFF + 1) / BlockSize;
+    auto constexpr MaxBlocksPerVersion = size_t { std::numeric_limits<tables_view::stage1_element_type>::max() } + 1;
+
+    using stage2_block = std::array<tables_view::stage2_element_type, BlockSize>;
+
+    struct properties_less
+    {
+        bool operator()(codepoint_properties const& a, codepoint_properties const& b) const noexcept
+        {
+            return std::memcmp(&a, &b, sizeof(codepoint_properties)) < 0;
+        }
+    };
+} // namespace
+
+codepoint_versions::codepoint_versions(std::vector<tables_view> const& versions)
+{
+    auto propertyIndices = std::map<codepoint_properties, tables_view::stage2_element_type, properties_less> {};
+    auto const indexOf = [&](codepoint_properties const& properties) {
+        auto const [i, inserted] =
+            propertyIndices.emplace(properties, static_cast<tables_view::stage2_element_type>(_stage3.size()));
+        if (inserted)
+        {
+            if (_stage3.size() > std::numeric_limits<tables_view::stage2_element_type>::max())
+                throw std::length_error("Too many distinct codepoint properties.");
+            _stage3.push_back(properties);
+        }
+        return i->second;
+    };
+
+    // The shared blocks, and the position of each block's most recent copy.
+    auto blocks = std::vector<stage2_block> {};
+    auto blockPositions = std::map<stage2_block, size_t> {};
+
+    // Start of each version's window into the shared blocks.
+    auto versionOffsets = std::vector<size_t> {};
+
+    _stage1.reserve(versions.size() * BlockCount);
+    for (auto const& tables: versions)
+    {
+        // Translate the version's blocks to indices into the shared properties, each source block once.
+        auto translatedBlocks = std::map<size_t, stage2_block> {};
+        auto versionBlocks = std::vector<stage2_block>(BlockCount);
+        for (size_t block = 0; block < BlockCount; ++block)
+        {
+            auto const sourceBlock = size_t { tables.stage1[block] };
+            auto [i, inserted] = translatedBlocks.try_emplace(sourceBlock);
+            if (inserted)
+                for (size_t k = 0; k < BlockSize; ++k)
+                    i->second[k] = indexOf(tables.stage3[tables.stage2[sourceBlock * BlockSize + k]]);
+            versionBlocks[block] = i->second;
+        }
+        auto const distinctBlocks = std::set<stage2_block>(versionBlocks.begin(), versionBlocks.end());
+
+        // As stage 1 can only refer to a limited number of blocks, each version refers to a window of
+        // the shared blocks. Pick the earliest window that fits, maximizing the blocks shared
+        // with previous versions, and append the blocks not found within it.
+        auto sharedPositions = std::vector<size_t> {};
+        for (auto const& block: distinctBlocks)
+            if (auto const i = blockPositions.find(block); i != blockPositions.end())
+                sharedPositions.push_back(i->second);
+        std::sort(sharedPositions.begin(), sharedPositions.end());
+
+        auto windowStart = size_t { 0 };
+        auto missingBlocks = distinctBlocks.size() - sharedPositions.size();
+        auto nextShared = sharedPositions.begin();
+        while (blocks.size() + missingBlocks - windowStart > MaxBlocksPerVersion)
+        {
+            if (windowStart == blocks.size())
+                throw std::length_error("Too many distinct codepoint property blocks.");
+            if (nextShared != sharedPositions.end() && *nextShared == windowStart)
+            {
+                ++missingBlocks;
+                ++nextShared;
+            }
+            ++windowStart;
+        }
+
+        for (auto const& block: versionBlocks)
+        {
+            auto const i = blockPositions.find(block);
+            if (i == blockPositions.end() || i->second < windowStart)
+            {
+                blockPositions[block] = blocks.size();
+                blocks.push_back(block);
+            }
+            _stage1.push_back(
+                static_cast<tables_view::stage1_element_type>(blockPositions.at(block) - windowStart));
+        }
+        versionOffsets.push_back(windowStart);
+    }
+
+    _stage2.reserve(blocks.size() * BlockSize);
+    for (auto const& block: blocks)
+        _stage2.insert(_stage2.end(), block.begin(), block.end());
+
+    for (size_t version = 0; version < versions.size(); ++version)
+        _views.push_back(tables_view {
+            _stage1.data() + version * BlockCount,
+            _stage2.data() + versionOffsets[version] * BlockSize,
+            _stage3.data(),
+        });
+}
+
+} // namespace unicode
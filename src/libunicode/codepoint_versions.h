@@ -0,0 +1,75 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/codepoint_properties.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace unicode
+{
+
+/// Several generations of codepoint property tables, such as those of different Unicode versions,
+/// held side by side with shared storage.
+///
+/// Stage 2 blocks and properties that are equal across versions are stored only once, so that
+/// each additional version costs its stage 1 table plus the blocks that changed.
+/// Each version is exposed as its own tables_view, to be passed as version handle to
+/// width(), scan_text() and the grapheme segmentation functions. Lookups cost the same as with
+/// the configured tables.
+///
+/// @code
+/// auto const [unicode15, names15] = load_from_directory("ucd-15.1", nullptr);
+/// auto const [unicode16, names16] = load_from_directory("ucd-16.0", nullptr);
+/// auto const versions = codepoint_versions({ unicode15.to_view(), unicode16.to_view() });
+/// auto const columns = width(codepoint, versions[0]);
+/// @endcode
+class codepoint_versions
+{
+  public:
+    using tables_view = codepoint_properties::tables_view;
+
+    /// Copies the given tables into shared storage, in the given order.
+    ///
+    /// @throws std::length_error if the tables do not fit into the tables' index types.
+    explicit codepoint_versions(std::vector<tables_view> const& versions);
+
+    codepoint_versions(codepoint_versions const&) = delete;
+    codepoint_versions& operator=(codepoint_versions const&) = delete;
+    codepoint_versions(codepoint_versions&&) noexcept = default;
+    codepoint_versions& operator=(codepoint_versions&&) noexcept = default;
+
+    /// Returns the number of versions.
+    [[nodiscard]] size_t size() const noexcept { return _views.size(); }
+
+    /// Returns the tables of the version at the given index, valid for as long as this object lives.
+    [[nodiscard]] tables_view const& operator[](size_t index) const noexcept { return _views[index]; }
+
+    /// Returns the number of bytes used by all versions' tables.
+    [[nodiscard]] size_t storage_size() const noexcept
+    {
+        return _stage1.size() * sizeof(tables_view::stage1_element_type)
+               + _stage2.size() * sizeof(tables_view::stage2_element_type)
+               + _stage3.size() * sizeof(codepoint_properties);
+    }
+
+  private:
+    std::vector<tables_view::stage1_element_type> _stage1; // the versions' stage 1 tables, one after another
+    std::vector<tables_view::stage2_element_type> _stage2; // shared blocks
+    std::vector<codepoint_properties> _stage3;             // shared properties
+    std::vector<tables_view> _views;
+};
+
+} // namespace unicode
@@ -0,0 +1,103 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_overlay.h>
+#include <libunicode/codepoint_versions.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/scan.h>
+#include <libunicode/test_support.h>
+#include <libunicode/width.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+using unicode::codepoint_overlay;
+using unicode::codepoint_properties;
+using unicode::codepoint_versions;
+using unicode::test::same_tables;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+// Emulates an older version, not knowing about U+0301 being a combining character.
+std::shared_ptr<codepoint_properties::table_set const> older_tables()
+{
+    return codepoint_overlay {}
+        .modify(0x0301,
+                0x0301,
+                [](codepoint_properties& properties) {
+                    properties.grapheme_cluster_break = unicode::Grapheme_Cluster_Break::Other;
+                    properties.char_width = 1;
+                })
+        .set_width(0x2500, 0x257F, 2)
+        .build();
+}
+} // namespace
+
+TEST_CASE("codepoint_versions.lookup")
+{
+    auto const older = older_tables();
+    auto const versions = codepoint_versions({ older->properties, codepoint_properties::configured_tables });
+    REQUIRE(versions.size() == 2);
+    CHECK(same_tables(versions[0], older->properties));
+    CHECK(same_tables(versions[1], codepoint_properties::configured_tables));
+
+    CHECK(unicode::width(0x2500, versions[0]) == 2);
+    CHECK(unicode::width(0x2500, versions[1]) == 1);
+
+    CHECK(unicode::grapheme_segmenter::breakable(U'e', 0x0301, versions[0]));
+    CHECK(!unicode::grapheme_segmenter::breakable(U'e', 0x0301, versions[1]));
+
+    auto const text = "e\xCC\x81\xE2\x94\x80"sv; // e, U+0301, U+2500
+    auto state = unicode::scan_state {};
+    CHECK(unicode::scan_text(state, text, 80, versions[0]).count == 4);
+    state = {};
+    CHECK(unicode::scan_text(state, text, 80, versions[1]).count == 2);
+}
+
+TEST_CASE("codepoint_versions.shared_storage")
+{
+    auto const older = older_tables();
+    auto const single = codepoint_versions({ codepoint_properties::configured_tables });
+    auto const versions = codepoint_versions({ older->properties, codepoint_properties::configured_tables });
+
+    // The additional version costs its stage 1 table and the few changed blocks.
+    CHECK(versions.storage_size() - single.storage_size() < single.storage_size() / 10);
+}
+
+TEST_CASE("codepoint_versions.many")
+{
+    // More changed blocks in total than a single stage 1 table can refer to.
+    auto overlays = std::vector<std::shared_ptr<codepoint_properties::table_set const>> {};
+    auto tables = std::vector<codepoint_properties::tables_view> {};
+    for (char32_t i = 0; i < 8; ++i)
+    {
+        // Changes 40 blocks, each one differently.
+        auto overlay = codepoint_overlay {};
+        for (char32_t block = 0; block < 40; ++block)
+        {
+            auto const codepoint = 0x20000 + (i * 40 + block) * 256 + block;
+            overlay.set_width(codepoint, codepoint, 3);
+        }
+        overlays.push_back(overlay.build());
+        tables.push_back(overlays.back()->properties);
+    }
+    auto const versions = codepoint_versions(tables);
+    REQUIRE(versions.size() == tables.size());
+    for (size_t i = 0; i < tables.size(); ++i)
+        CHECK(same_tables(versions[i], tables[i]));
+}
@@ -0,0 +1,256 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/compact_line.h>
+#include <libunicode/convert.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/scan.h>
+#include <libunicode/utf8.h>
+#include <libunicode/width.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    auto constexpr VS16 = char32_t { 0xFE0F };
+
+    char16_t utf16_unit(string_view data, size_t index) noexcept
+    {
+        char16_t unit = 0;
+        std::memcpy(&unit, data.data() + index * sizeof(char16_t), sizeof(char16_t));
+        return unit;
+    }
+
+    constexpr size_t align_up(size_t value, size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+compact_line::compact_line(string_view text)
+{
+    auto storage = string {};
+    text = utf8_sanitize(text, storage);
+
+    // Fast path for the most common case, printable US-ASCII only.
+    if (detail::scan_for_text_ascii(text, text.size()) == text.size())
+    {
+        _columns = static_cast<uint32_t>(text.size());
+        _clusterCount = static_cast<uint32_t>(text.size());
+        assign(text, nullptr);
+        return;
+    }
+
+    auto clusters = std::vector<cluster_start> {};
+    auto state = grapheme_segmenter_state {};
+    auto uniform = true; // whether all clusters consist of a single codepoint of one column
+    auto maxCodepoint = char32_t { 0 };
+    size_t columns = 0;
+    size_t clusterWidth = 0;
+    size_t clusterCodepoints = 0;
+
+    auto const completeCluster = [&]() noexcept {
+        columns += clusterWidth;
+        uniform = uniform && clusterWidth == 1 && clusterCodepoints == 1;
+    };
+
+    auto input = text.data();
+    auto const end = input + text.size();
+    while (input != end)
+    {
+        auto const offset = static_cast<uint32_t>(input - text.data());
+        auto const codepoint = detail::decode_utf8_sequence(input, end).value_or(char32_t { 0xFFFD }); // sanitized above
+        maxCodepoint = std::max(maxCodepoint, codepoint);
+
+        if (clusters.empty() || grapheme_process_breakable(codepoint, state))
+        {
+            if (!clusters.empty())
+                completeCluster();
+            clusters.push_back(cluster_start { offset, static_cast<uint32_t>(columns) });
+            grapheme_process_init(codepoint, state);
+            clusterWidth = width(codepoint);
+            clusterCodepoints = 1;
+        }
+        else
+        {
+            ++clusterCodepoints;
+            if (codepoint == VS16)
+                clusterWidth = 2; // Increase width on VS16 but do not decrease on VS15.
+            else
+                clusterWidth = std::max(clusterWidth, static_cast<size_t>(width(codepoint)));
+        }
+    }
+    if (!clusters.empty())
+        completeCluster();
+
+    _columns = static_cast<uint32_t>(columns);
+    _clusterCount = static_cast<uint32_t>(clusters.size());
+
+    if (uniform && maxCodepoint <= 0xFF)
+    {
+        _representation = representation::Latin1;
+        assign(encode_single_byte(single_byte_encoding::Latin1, text).value_or(string {}), nullptr);
+    }
+    else if (uniform && maxCodepoint <= 0xFFFF)
+    {
+        _representation = representation::UTF16;
+        auto const units = convert_to<char16_t>(text);
+        assign(string_view(reinterpret_cast<char const*>(units.data()), units.size() * sizeof(char16_t)), nullptr);
+    }
+    else
+    {
+        _representation = representation::UTF8;
+        assign(text, clusters.data());
+    }
+}
+
+void compact_line::assign(string_view bytes, cluster_start const* clusters)
+{
+    _size = static_cast<uint32_t>(bytes.size());
+    _data.reset();
+    if (!allocation_size())
+        return;
+
+    _data = std::make_unique_for_overwrite<char[]>(allocation_size());
+    std::memcpy(_data.get(), bytes.data(), bytes.size());
+    if (clusters)
+        std::memcpy(_data.get() + align_up(_size, alignof(cluster_start)), clusters, _clusterCount * sizeof(cluster_start));
+}
+
+size_t compact_line::allocation_size() const noexcept
+{
+    if (_representation != representation::UTF8)
+        return _size;
+    return align_up(_size, alignof(cluster_start)) + _clusterCount * sizeof(cluster_start);
+}
+
+compact_line::cluster_start compact_line::cluster(size_t index) const noexcept
+{
+    auto result = cluster_start {};
+    auto const offset = align_up(_size, alignof(cluster_start)) + index * sizeof(cluster_start);
+    std::memcpy(&result, _data.get() + offset, sizeof(result));
+    return result;
+}
+
+compact_line::compact_line(compact_line const& other):
+    _representation { other._representation },
+    _size { other._size },
+    _columns { other._columns },
+    _clusterCount { other._clusterCount }
+{
+    if (other._data)
+    {
+        _data = std::make_unique_for_overwrite<char[]>(allocation_size());
+        std::memcpy(_data.get(), other._data.get(), allocation_size());
+    }
+}
+
+compact_line& compact_line::operator=(compact_line const& other)
+{
+    if (this != &other)
+        *this = compact_line(other);
+    return *this;
+}
+
+// The moved-from line is left empty.
+compact_line::compact_line(compact_line&& other) noexcept:
+    _representation { std::exchange(other._representation, representation::Latin1) },
+    _size { std::exchange(other._size, 0) },
+    _columns { std::exchange(other._columns, 0) },
+    _clusterCount { std::exchange(other._clusterCount, 0) },
+    _data { std::move(other._data) }
+{
+}
+
+compact_line& compact_line::operator=(compact_line&& other) noexcept
+{
+    if (this != &other)
+    {
+        _representation = std::exchange(other._representation, representation::Latin1);
+        _size = std::exchange(other._size, 0);
+        _columns = std::exchange(other._columns, 0);
+        _clusterCount = std::exchange(other._clusterCount, 0);
+        _data = std::move(other._data);
+    }
+    return *this;
+}
+
+size_t compact_line::memory_usage() const noexcept
+{
+    return sizeof(*this) + allocation_size();
+}
+
+string compact_line::cluster_at_column(size_t column) const
+{
+    if (column >= _columns)
+        return {};
+
+    switch (_representation)
+    {
+        case representation::Latin1:
+            return decode_single_byte(single_byte_encoding::Latin1, bytes().substr(column, 1));
+        case representation::UTF16: return unicode::to_utf8(static_cast<char32_t>(utf16_unit(bytes(), column)));
+        case representation::UTF8: break;
+    }
+
+    // Find the last cluster starting at or before the given column.
+    size_t first = 0;
+    size_t count = _clusterCount;
+    while (count > 0)
+    {
+        auto const step = count / 2;
+        if (cluster(first + step).column <= column)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+
+    auto const start = cluster(first - 1).offset;
+    auto const end = first != _clusterCount ? cluster(first).offset : _size;
+    return string(bytes().substr(start, end - start));
+}
+
+string compact_line::to_utf8() const
+{
+    switch (_representation)
+    {
+        case representation::Latin1: return decode_single_byte(single_byte_encoding::Latin1, bytes());
+        case representation::UTF16: {
+            auto result = string {};
+            result.reserve(_size / sizeof(char16_t) * 3);
+            for (size_t i = 0; i < _size / sizeof(char16_t); ++i)
+            {
+                uint8_t sequence[4] = {};
+                auto const length = unicode::to_utf8(static_cast<char32_t>(utf16_unit(bytes(), i)), sequence);
+                result.append(reinterpret_cast<char const*>(sequence), length);
+            }
+            return result;
+        }
+        case representation::UTF8: break;
+    }
+    return string(bytes());
+}
+
+} // namespace unicode
@@ -0,0 +1,102 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace unicode
+{
+
+/// Holds a single line of text in the narrowest representation that fits it.
+///
+/// Lines, whose grapheme clusters all consist of a single codepoint occupying exactly one column,
+/// are stored with a fixed number of bytes per column: one byte if all codepoints are within Latin-1,
+/// two bytes (UTF-16) if all codepoints are within the Basic Multilingual Plane.
+/// This allows accessing a column in constant time.
+///
+/// All other lines are stored as UTF-8 along with an index of their grapheme clusters,
+/// allowing to access a column in logarithmic time.
+///
+/// The number of columns and grapheme clusters is computed once upon construction.
+/// Control characters are treated as zero-width.
+class compact_line
+{
+  public:
+    enum class representation : uint8_t
+    {
+        Latin1,
+        UTF16,
+        UTF8,
+    };
+
+    compact_line() = default;
+
+    /// Constructs the line from the given UTF-8 encoded text.
+    /// Ill-formed UTF-8 sequences are replaced with U+FFFD.
+    explicit compact_line(std::string_view text);
+
+    compact_line(compact_line const& other);
+    compact_line(compact_line&& other) noexcept;
+    compact_line& operator=(compact_line const& other);
+    compact_line& operator=(compact_line&& other) noexcept;
+    ~compact_line() = default;
+
+    [[nodiscard]] representation storage() const noexcept { return _representation; }
+
+    /// Returns the number of columns this line occupies.
+    [[nodiscard]] size_t columns() const noexcept { return _columns; }
+
+    /// Returns the number of grapheme clusters of this line.
+    [[nodiscard]] size_t cluster_count() const noexcept { return _clusterCount; }
+
+    [[nodiscard]] bool empty() const noexcept { return _clusterCount == 0; }
+
+    /// Returns the number of bytes used by this line, including its heap-allocated storage.
+    [[nodiscard]] size_t memory_usage() const noexcept;
+
+    /// Returns the UTF-8 encoded grapheme cluster occupying the given column,
+    /// or an empty string if the column is beyond the end of the line.
+    [[nodiscard]] std::string cluster_at_column(size_t column) const;
+
+    /// Returns the whole line, UTF-8 encoded.
+    [[nodiscard]] std::string to_utf8() const;
+
+  private:
+    // Start of a grapheme cluster within the UTF-8 representation.
+    struct cluster_start
+    {
+        uint32_t offset; // byte offset
+        uint32_t column; // first column occupied
+    };
+
+    void assign(std::string_view bytes, cluster_start const* clusters);
+    [[nodiscard]] size_t allocation_size() const noexcept;
+    [[nodiscard]] cluster_start cluster(size_t index) const noexcept;
+    [[nodiscard]] std::string_view bytes() const noexcept { return { _data.get(), _size }; }
+
+    representation _representation = representation::Latin1;
+    uint32_t _size = 0;
+    uint32_t _columns = 0;
+    uint32_t _clusterCount = 0;
+
+    // Latin-1 bytes, native-endian UTF-16 code units, or UTF-8 bytes, depending on _representation.
+    // The UTF-8 bytes are followed by the index of all grapheme clusters (with _clusterCount entries).
+    std::unique_ptr<char[]> _data;
+};
+
+} // namespace unicode
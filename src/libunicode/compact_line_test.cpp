@@ -0,0 +1,159 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/compact_line.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+using std::string;
+using std::string_view;
+
+using namespace std::string_view_literals;
+
+using unicode::compact_line;
+using representation = unicode::compact_line::representation;
+
+TEST_CASE("compact_line.empty")
+{
+    auto const line = compact_line {};
+    CHECK(line.empty());
+    CHECK(line.columns() == 0);
+    CHECK(line.to_utf8().empty());
+    CHECK(line.cluster_at_column(0).empty());
+}
+
+TEST_CASE("compact_line.ascii")
+{
+    auto const line = compact_line("Hello, World"sv);
+    CHECK(line.storage() == representation::Latin1);
+    CHECK(line.columns() == 12);
+    CHECK(line.cluster_count() == 12);
+    CHECK(line.cluster_at_column(7) == "W");
+    CHECK(line.cluster_at_column(12).empty());
+    CHECK(line.to_utf8() == "Hello, World");
+}
+
+TEST_CASE("compact_line.latin1")
+{
+    auto const text = "Gr\xC3\xBC\xC3\x9F"
+                      "e aus K\xC3\xB6ln"sv;
+    auto const line = compact_line(text);
+    CHECK(line.storage() == representation::Latin1);
+    CHECK(line.columns() == 14);
+    CHECK(line.cluster_at_column(2) == "\xC3\xBC");
+    CHECK(line.cluster_at_column(3) == "\xC3\x9F");
+    CHECK(line.to_utf8() == text);
+}
+
+TEST_CASE("compact_line.utf16")
+{
+    auto const text = "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xE2\x94\x80\xE2\x82\xAC"sv; // Привет ─€
+    auto const line = compact_line(text);
+    CHECK(line.storage() == representation::UTF16);
+    CHECK(line.columns() == 9);
+    CHECK(line.cluster_count() == 9);
+    CHECK(line.cluster_at_column(0) == "\xD0\x9F");
+    CHECK(line.cluster_at_column(8) == "\xE2\x82\xAC");
+    CHECK(line.to_utf8() == text);
+}
+
+TEST_CASE("compact_line.utf8")
+{
+    // Wide characters, combining characters, emoji and control characters
+    // all prevent a fixed-width representation.
+    auto const text = "a\xE4\xBD\xA0"        // 你 (2 columns)
+                      "e\xCC\x81"            // e + combining acute accent (1 column)
+                      "\xF0\x9F\x98\x80"     // 😀 (2 columns)
+                      "\xE2\x9D\xA4\xEF\xB8\x8F" // ❤️ (2 columns, due to VS16)
+                      "\x01z"sv;
+    auto const line = compact_line(text);
+    CHECK(line.storage() == representation::UTF8);
+    CHECK(line.columns() == 9);
+    CHECK(line.cluster_count() == 7);
+    CHECK(line.cluster_at_column(0) == "a");
+    CHECK(line.cluster_at_column(1) == "\xE4\xBD\xA0");
+    CHECK(line.cluster_at_column(2) == "\xE4\xBD\xA0");
+    CHECK(line.cluster_at_column(3) == "e\xCC\x81");
+    CHECK(line.cluster_at_column(4) == "\xF0\x9F\x98\x80");
+    CHECK(line.cluster_at_column(6) == "\xE2\x9D\xA4\xEF\xB8\x8F");
+    CHECK(line.cluster_at_column(7) == "\xE2\x9D\xA4\xEF\xB8\x8F");
+    CHECK(line.cluster_at_column(8) == "z"); // the zero-width control character is skipped
+    CHECK(line.cluster_at_column(9).empty());
+    CHECK(line.to_utf8() == text);
+}
+
+TEST_CASE("compact_line.ill_formed")
+{
+    auto const line = compact_line("a\xC3z"sv);
+    CHECK(line.storage() == representation::UTF16);
+    CHECK(line.columns() == 3);
+    CHECK(line.to_utf8() == "a\xEF\xBF\xBDz");
+}
+
+TEST_CASE("compact_line.copy")
+{
+    auto const original = compact_line("\xF0\x9F\x98\x80 smile"sv);
+    auto copy = compact_line {};
+    copy = original;
+    CHECK(copy.storage() == representation::UTF8);
+    CHECK(copy.columns() == original.columns());
+    CHECK(copy.cluster_at_column(0) == original.cluster_at_column(0));
+    CHECK(copy.to_utf8() == original.to_utf8());
+}
+
+TEST_CASE("compact_line.move")
+{
+    auto const text = "\xF0\x9F\x98\x80 smile"sv;
+    auto original = compact_line(text);
+    auto const columns = original.columns();
+
+    auto moved = std::move(original);
+    CHECK(moved.storage() == representation::UTF8);
+    CHECK(moved.columns() == columns);
+    CHECK(moved.to_utf8() == text);
+
+    // NOLINTBEGIN(bugprone-use-after-move)
+    CHECK(original.empty());
+    CHECK(original.storage() == representation::Latin1);
+    CHECK(original.columns() == 0);
+    CHECK(original.cluster_count() == 0);
+    CHECK(original.memory_usage() == sizeof(compact_line));
+    CHECK(original.cluster_at_column(0).empty());
+    CHECK(original.to_utf8().empty());
+
+    auto assigned = compact_line("abc"sv);
+    assigned = std::move(moved);
+    CHECK(assigned.to_utf8() == text);
+    CHECK(moved.empty());
+    CHECK(moved.columns() == 0);
+    CHECK(moved.memory_usage() == sizeof(compact_line));
+    CHECK(moved.to_utf8().empty());
+    // NOLINTEND(bugprone-use-after-move)
+}
+
+TEST_CASE("compact_line.memory_usage")
+{
+    auto const text = string(100, 'x') + "\xC3\xA4";
+
+    // One byte per column.
+    auto const latin1 = compact_line(text);
+    CHECK(latin1.memory_usage() == sizeof(compact_line) + 101);
+
+    // UTF-8 bytes plus the cluster index.
+    auto const utf8 = compact_line(text + "\xE4\xBD\xA0");
+    CHECK(utf8.memory_usage() > sizeof(compact_line) + 105 + 102 * 2 * sizeof(uint32_t));
+}
@@ -0,0 +1,344 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/convert.h>
+#include <libunicode/intrinsics.h>
+#include <libunicode/utf8.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using std::string;
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    // Codepoints of the bytes 0x80..0x9F in Windows-1252.
+    constexpr char32_t Windows1252C1[32] = {
+        0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160,
+        0x2039, 0x0152, 0x008D, 0x017D, 0x008F, 0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022,
+        0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+    };
+
+    constexpr char32_t to_codepoint(single_byte_encoding encoding, uint8_t byte) noexcept
+    {
+        if (encoding == single_byte_encoding::Windows1252 && byte >= 0x80 && byte < 0xA0)
+            return Windows1252C1[byte - 0x80];
+        return byte;
+    }
+
+    // Maps the codepoints of Windows1252C1 back to their byte, ordered by codepoint.
+    constexpr auto Windows1252Reverse = [] {
+        auto table = std::array<std::pair<char32_t, int>, 32> {};
+        for (int i = 0; i < 32; ++i)
+            table[static_cast<size_t>(i)] = { Windows1252C1[i], 0x80 + i };
+        std::sort(table.begin(), table.end());
+        return table;
+    }();
+
+    // Maps the General Punctuation codepoints of Windows1252C1 (U+2000..U+213F) back to their byte, or 0 if none.
+    constexpr auto Windows1252Punctuation = [] {
+        auto table = std::array<uint8_t, 0x140> {};
+        for (int i = 0; i < 32; ++i)
+            if (Windows1252C1[i] >= 0x2000 && Windows1252C1[i] < 0x2140)
+                table[Windows1252C1[i] - 0x2000] = static_cast<uint8_t>(0x80 + i);
+        return table;
+    }();
+
+    // Returns the byte representing the given codepoint, or -1 if it cannot be represented.
+    constexpr int from_codepoint(single_byte_encoding encoding, char32_t codepoint) noexcept
+    {
+        if (encoding == single_byte_encoding::Latin1 || codepoint < 0x80 || (codepoint >= 0xA0 && codepoint <= 0xFF))
+            return codepoint <= 0xFF ? static_cast<int>(codepoint) : -1;
+
+        if (codepoint >= 0x2000 && codepoint < 0x2140)
+            return Windows1252Punctuation[codepoint - 0x2000] ? Windows1252Punctuation[codepoint - 0x2000] : -1;
+
+        auto const i = std::lower_bound(Windows1252Reverse.begin(),
+                                        Windows1252Reverse.end(),
+                                        codepoint,
+                                        [](auto const& entry, char32_t value) { return entry.first < value; });
+        if (i == Windows1252Reverse.end() || i->first != codepoint)
+            return -1;
+        return i->second;
+    }
+
+    // UTF-8 encoding of a single byte, which never exceeds 3 bytes for the supported encodings.
+    struct utf8_sequence
+    {
+        char bytes[4];
+        uint8_t length;
+    };
+
+    using decoding_table = std::array<utf8_sequence, 256>;
+
+    constexpr decoding_table make_decoding_table(single_byte_encoding encoding) noexcept
+    {
+        auto table = decoding_table {};
+        for (unsigned byte = 0; byte < 256; ++byte)
+        {
+            uint8_t bytes[4] = {};
+            auto& sequence = table[byte];
+            sequence.length = static_cast<uint8_t>(to_utf8(to_codepoint(encoding, static_cast<uint8_t>(byte)), bytes));
+            for (unsigned i = 0; i < 4; ++i)
+                sequence.bytes[i] = static_cast<char>(bytes[i]);
+        }
+        return table;
+    }
+
+    constexpr auto Latin1Table = make_decoding_table(single_byte_encoding::Latin1);
+    constexpr auto Windows1252Table = make_decoding_table(single_byte_encoding::Windows1252);
+
+    constexpr decoding_table const& decoding_table_of(single_byte_encoding encoding) noexcept
+    {
+        return encoding == single_byte_encoding::Latin1 ? Latin1Table : Windows1252Table;
+    }
+
+    constexpr bool is_continuation(uint8_t byte) noexcept
+    {
+        return (byte & 0xC0) == 0x80;
+    }
+
+    auto constexpr BlockSize = size_t { 16 };
+
+    // Tests whether the BlockSize bytes at @p input are all US-ASCII.
+    bool is_ascii_block(char const* input) noexcept
+    {
+#if defined(USE_INTRINSICS)
+        static_assert(sizeof(intrinsics::m128i) == BlockSize);
+        return intrinsics::movemask_epi8(intrinsics::load_unaligned((intrinsics::m128i const*) input)) == 0;
+#else
+        uint64_t words[2] = {};
+        std::memcpy(words, input, sizeof(words));
+        return ((words[0] | words[1]) & 0x8080'8080'8080'8080llu) == 0;
+#endif
+    }
+
+    template <bool WriteOutput>
+    bool narrow(single_byte_encoding encoding, string_view input, char*& output) noexcept
+    {
+        auto i = reinterpret_cast<uint8_t const*>(input.data());
+        auto const end = i + input.size();
+        auto out = output; // local copy, as writing through output could alias it
+
+        while (i != end)
+        {
+            if (static_cast<size_t>(end - i) >= BlockSize && is_ascii_block(reinterpret_cast<char const*>(i)))
+            {
+                if constexpr (WriteOutput)
+                {
+                    std::memcpy(out, i, BlockSize);
+                    out += BlockSize;
+                }
+                i += BlockSize;
+                continue;
+            }
+
+            auto const limit = i + std::min(BlockSize, static_cast<size_t>(end - i));
+            while (i < limit)
+            {
+                auto byte = int { *i };
+                if (byte < 0x80)
+                    ++i;
+                else if ((byte & 0xFE) == 0xC2 && i + 1 < end && is_continuation(i[1]) && (byte == 0xC3 || i[1] >= 0xA0))
+                {
+                    // Fast path for U+00A0..U+00FF, which is represented by the same byte in both encodings.
+                    byte = ((byte & 0x03) << 6) | (i[1] & 0x3F);
+                    i += 2;
+                }
+                else
+                {
+                    auto const codepoint = detail::decode_utf8_sequence(i, end);
+                    if (!codepoint)
+                        return false;
+                    byte = from_codepoint(encoding, *codepoint);
+                    if (byte < 0)
+                        return false;
+                }
+                if constexpr (WriteOutput)
+                    *out++ = static_cast<char>(byte);
+            }
+        }
+
+        output = out;
+        return true;
+    }
+
+    bool is_latin1(string_view input) noexcept
+    {
+        auto const data = reinterpret_cast<uint8_t const*>(input.data());
+        auto const size = input.size();
+        size_t i = 0;
+
+        // Whether the byte before i is a lead byte expecting a continuation byte.
+        unsigned carry = 0;
+
+#if defined(USE_INTRINSICS)
+        // Latin-1 is represented by US-ASCII and two-byte sequences starting with 0xC2 or 0xC3.
+        // Each block is valid if its non-ASCII bytes are exactly those lead bytes and the continuation bytes
+        // immediately following them.
+        auto const LeadMask = intrinsics::set1_epi8(static_cast<signed char>(0xFE));
+        auto const Lead = intrinsics::set1_epi8(static_cast<signed char>(0xC2));
+        auto const ContinuationMax = intrinsics::set1_epi8(static_cast<signed char>(0xC0)); // signed compare
+
+        for (; i + BlockSize <= size; i += BlockSize)
+        {
+            auto const batch = intrinsics::load_unaligned((intrinsics::m128i const*) (data + i));
+            auto const nonAscii = static_cast<unsigned>(intrinsics::movemask_epi8(batch));
+            if (!nonAscii && !carry)
+                continue;
+
+            // clang-format off
+            auto const leads = static_cast<unsigned>(intrinsics::movemask_epi8(intrinsics::compare_equal(intrinsics::and128(batch, LeadMask), Lead)));
+            auto const continuations = static_cast<unsigned>(intrinsics::movemask_epi8(intrinsics::compare_less(batch, ContinuationMax)));
+            // clang-format on
+            if (nonAscii != (leads | continuations) || continuations != (((leads << 1) | carry) & 0xFFFF))
+                return false;
+            carry = leads >> 15;
+        }
+#endif
+
+        for (; i < size; ++i)
+        {
+            auto const byte = data[i];
+            if (carry != static_cast<unsigned>(is_continuation(byte)))
+                return false;
+            if (carry)
+                carry = 0;
+            else if (byte >= 0x80)
+            {
+                if ((byte & 0xFE) != 0xC2)
+                    return false;
+                carry = 1;
+            }
+        }
+        return !carry;
+    }
+} // namespace
+
+size_t utf8_length(single_byte_encoding encoding, string_view input) noexcept
+{
+    auto const& table = decoding_table_of(encoding);
+    auto length = input.size();
+    size_t i = 0;
+
+#if defined(USE_INTRINSICS)
+    for (; i + BlockSize <= input.size(); i += BlockSize)
+    {
+        auto const batch = intrinsics::load_unaligned((intrinsics::m128i const*) (input.data() + i));
+        auto mask = static_cast<unsigned>(intrinsics::movemask_epi8(batch));
+        if (encoding == single_byte_encoding::Latin1)
+            length += static_cast<size_t>(std::popcount(mask));
+        else
+            for (; mask; mask &= mask - 1)
+                length += table[static_cast<uint8_t>(input[i + static_cast<size_t>(std::countr_zero(mask))])].length - 1u;
+    }
+#endif
+
+    for (; i < input.size(); ++i)
+        length += table[static_cast<uint8_t>(input[i])].length - 1u;
+
+    return length;
+}
+
+char* decode_single_byte(single_byte_encoding encoding, string_view input, char* output) noexcept
+{
+    auto const& table = decoding_table_of(encoding);
+    size_t i = 0;
+
+    // Each input byte is followed by at least 3 more, each producing at least one output byte,
+    // so that all 4 bytes of a table entry can be written at once.
+    for (; i + BlockSize + 3 <= input.size(); i += BlockSize)
+    {
+        if (is_ascii_block(input.data() + i))
+        {
+            std::memcpy(output, input.data() + i, BlockSize);
+            output += BlockSize;
+            continue;
+        }
+        for (size_t k = i; k < i + BlockSize; ++k)
+        {
+            auto const& sequence = table[static_cast<uint8_t>(input[k])];
+            std::memcpy(output, sequence.bytes, sizeof(sequence.bytes));
+            output += sequence.length;
+        }
+    }
+
+    for (; i < input.size(); ++i)
+    {
+        auto const& sequence = table[static_cast<uint8_t>(input[i])];
+        std::memcpy(output, sequence.bytes, sequence.length);
+        output += sequence.length;
+    }
+    return output;
+}
+
+string decode_single_byte(single_byte_encoding encoding, string_view input)
+{
+    auto output = string(utf8_length(encoding, input), '\0');
+    decode_single_byte(encoding, input, output.data());
+    return output;
+}
+
+size_t single_byte_length(string_view input) noexcept
+{
+    auto continuations = size_t { 0 };
+    size_t i = 0;
+
+#if defined(USE_INTRINSICS)
+    auto const ContinuationMax = intrinsics::set1_epi8(static_cast<signed char>(0xC0)); // signed compare
+    for (; i + BlockSize <= input.size(); i += BlockSize)
+    {
+        auto const batch = intrinsics::load_unaligned((intrinsics::m128i const*) (input.data() + i));
+        auto const mask = static_cast<unsigned>(intrinsics::movemask_epi8(intrinsics::compare_less(batch, ContinuationMax)));
+        continuations += static_cast<size_t>(std::popcount(mask));
+    }
+#endif
+
+    for (; i < input.size(); ++i)
+        continuations += is_continuation(static_cast<uint8_t>(input[i]));
+
+    return input.size() - continuations;
+}
+
+char* encode_single_byte(single_byte_encoding encoding, string_view input, char* output) noexcept
+{
+    if (!narrow<true>(encoding, input, output))
+        return nullptr;
+    return output;
+}
+
+std::optional<string> encode_single_byte(single_byte_encoding encoding, string_view input)
+{
+    auto output = string(single_byte_length(input), '\0');
+    auto const end = encode_single_byte(encoding, input, output.data());
+    if (!end)
+        return std::nullopt;
+    output.resize(static_cast<size_t>(end - output.data()));
+    return output;
+}
+
+bool is_representable(single_byte_encoding encoding, string_view input) noexcept
+{
+    if (encoding == single_byte_encoding::Latin1)
+        return is_latin1(input);
+
+    char* output = nullptr;
+    return narrow<false>(encoding, input, output);
+}
+
+} // namespace unicode
@@ -13,10 +13,13 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <iterator>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -319,7 +322,7 @@ namespace detail // {{{
 } // namespace detail
 
 /// @p _input with element type @p S to the appropricate type of @p _output.
-template <typename T, typename OutputIterator, typename S>
+template <typename T, std::output_iterator<T> OutputIterator, typename S>
 OutputIterator convert_to(std::basic_string_view<S> input, OutputIterator output)
 {
     if constexpr (std::is_same_v<S, T>)
@@ -349,6 +352,77 @@ std::basic_string<T> convert_to(std::basic_string_view<S> in)
     return out;
 }
 
+/// Converts a string of element type @p <S> into string of element type @p <T>,
+/// allocated from the given memory resource (such as a per-frame arena).
+template <typename T, typename S>
+std::pmr::basic_string<T> convert_to(std::basic_string_view<S> in, std::pmr::memory_resource* resource)
+{
+    auto out = std::pmr::basic_string<T>(resource);
+    convert_to<T>(in, std::back_inserter(out));
+    return out;
+}
+
+/// Converts a string of element type @p <S> into the given buffer of element type @p <T>, without allocating.
+///
+/// Conversion stops before the first codepoint that does not entirely fit into @p output,
+/// see converted_length() for the number of elements required.
+///
+/// @return number of elements written.
+template <typename T, typename S>
+size_t convert_to(std::basic_string_view<S> input, std::span<T> output)
+{
+    if constexpr (std::is_same_v<S, T>)
+    {
+        auto const count = std::min(input.size(), output.size());
+        std::copy_n(input.data(), count, output.data());
+        return count;
+    }
+    else
+    {
+        auto i = begin(input);
+        auto e = end(input);
+        decoder<S> read {};
+        encoder<T> write {};
+        size_t count = 0;
+        while (i != e)
+        {
+            auto const outChar = read(i);
+            if (!outChar.has_value())
+                continue;
+            T units[4] {};
+            auto const length = static_cast<size_t>(write(outChar.value(), units) - units);
+            if (length > output.size() - count)
+                break;
+            std::copy_n(units, length, output.data() + count);
+            count += length;
+        }
+        return count;
+    }
+}
+
+/// Returns the number of elements of type @p <T> the given string converts to.
+template <typename T, typename S>
+size_t converted_length(std::basic_string_view<S> input)
+{
+    if constexpr (std::is_same_v<S, T>)
+        return input.size();
+    else
+    {
+        auto i = begin(input);
+        auto e = end(input);
+        decoder<S> read {};
+        encoder<T> write {};
+        size_t count = 0;
+        while (i != e)
+        {
+            T units[4] {};
+            if (auto const outChar = read(i); outChar.has_value())
+                count += static_cast<size_t>(write(outChar.value(), units) - units);
+        }
+        return count;
+    }
+}
+
 template <typename T,
           typename S,
           std::enable_if_t<std::is_same_v<S, char> || std::is_same_v<S, char16_t> || std::is_same_v<S, char32_t>, int> = 0>
@@ -360,4 +434,49 @@ std::basic_string<T> convert_to(S input)
     return out;
 }
 
+// {{{ single-byte encodings
+/// Legacy single-byte encodings that can be bulk-transcoded from and to UTF-8.
+enum class single_byte_encoding
+{
+    /// ISO-8859-1, mapping each byte to the codepoint of the same value.
+    Latin1,
+
+    /// Windows code page 1252, a superset of ISO-8859-1's printable characters that maps 0x80..0x9F
+    /// to typographic characters. The five unassigned bytes in that range map to the C1 control of the same value.
+    Windows1252,
+};
+
+/// Computes the exact number of bytes needed to encode @p input as UTF-8.
+size_t utf8_length(single_byte_encoding encoding, std::string_view input) noexcept;
+
+/// Transcodes @p input from the given single-byte encoding to UTF-8.
+///
+/// @param output  buffer receiving exactly utf8_length(encoding, input) bytes
+///
+/// @return pointer to the end of the written output.
+char* decode_single_byte(single_byte_encoding encoding, std::string_view input, char* output) noexcept;
+
+/// Transcodes @p input from the given single-byte encoding to UTF-8.
+std::string decode_single_byte(single_byte_encoding encoding, std::string_view input);
+
+/// Computes the number of bytes needed to encode the UTF-8 encoded @p input in a single-byte encoding,
+/// i.e. the number of codepoints, provided that the input is well-formed.
+size_t single_byte_length(std::string_view input) noexcept;
+
+/// Transcodes the UTF-8 encoded @p input to the given single-byte encoding.
+///
+/// @param output  buffer receiving up to single_byte_length(input) bytes
+///
+/// @return pointer to the end of the written output,
+///         or nullptr if the input is ill-formed or contains codepoints that cannot be represented.
+char* encode_single_byte(single_byte_encoding encoding, std::string_view input, char* output) noexcept;
+
+/// Transcodes the UTF-8 encoded @p input to the given single-byte encoding,
+/// or returns std::nullopt if the input is ill-formed or contains codepoints that cannot be represented.
+std::optional<std::string> encode_single_byte(single_byte_encoding encoding, std::string_view input);
+
+/// Tests whether the UTF-8 encoded @p input is well-formed and can be represented in the given single-byte encoding.
+bool is_representable(single_byte_encoding encoding, std::string_view input) noexcept;
+// }}}
+
 } // namespace unicode
@@ -19,12 +19,70 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <array>
 #include <iterator>
+#include <memory_resource>
 
 using namespace unicode;
 using namespace std::string_literals;
 using namespace std;
 
+using unicode::single_byte_encoding;
+
+namespace
+{
+// Counts the allocations passed on to its upstream resource.
+class counting_resource: public std::pmr::memory_resource
+{
+  public:
+    explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept:
+        _upstream { upstream }
+    {
+    }
+
+    [[nodiscard]] size_t allocations() const noexcept { return _allocations; }
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++_allocations;
+        return _upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override { _upstream->deallocate(p, bytes, alignment); }
+
+    [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* _upstream;
+    size_t _allocations = 0;
+};
+
+// Installs a counting_resource as the default memory resource for the lifetime of this object.
+struct default_resource_guard
+{
+    counting_resource counter {};
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&counter);
+
+    ~default_resource_guard() { std::pmr::set_default_resource(previous); }
+};
+
+// Provides a monotonic arena, counting any allocation exceeding its fixed buffer.
+struct arena
+{
+    std::array<std::byte, 4096> buffer {};
+    counting_resource upstream {};
+    std::pmr::monotonic_buffer_resource resource { buffer.data(), buffer.size(), &upstream };
+
+    [[nodiscard]] bool owns(void const* p) const noexcept
+    {
+        return p >= buffer.data() && p < buffer.data() + buffer.size();
+    }
+};
+} // namespace
+
 TEST_CASE("convert.same", "[convert]")
 {
     auto const s8 = "Hello, 😀"sv;
@@ -116,3 +174,149 @@ TEST_CASE("convert.utf8.incremental_decode", "[utf8]")
     REQUIRE(result.has_value());
     REQUIRE(result.value() == U'\U0001F600'); // 😀
 }
+
+TEST_CASE("convert.latin1_to_utf8", "[convert]")
+{
+    auto const input = "caf\xE9 \xA9 \xFF"sv;
+    CHECK(unicode::utf8_length(single_byte_encoding::Latin1, input) == 11);
+    CHECK(unicode::decode_single_byte(single_byte_encoding::Latin1, input) == "caf\xC3\xA9 \xC2\xA9 \xC3\xBF");
+
+    // Every byte maps to the codepoint of the same value.
+    auto all = string {};
+    for (unsigned i = 0; i < 256; ++i)
+        all += static_cast<char>(i);
+    auto const utf8 = unicode::decode_single_byte(single_byte_encoding::Latin1, all);
+    CHECK(utf8.size() == unicode::utf8_length(single_byte_encoding::Latin1, all));
+    CHECK(unicode::from_utf8<char32_t>(utf8).size() == 256);
+    CHECK(unicode::encode_single_byte(single_byte_encoding::Latin1, utf8) == all);
+}
+
+TEST_CASE("convert.windows1252_to_utf8", "[convert]")
+{
+    auto const input = "\x93quoted\x94 \x80\x39\x39 \x81"sv;
+    auto const expected = "\xE2\x80\x9Cquoted\xE2\x80\x9D \xE2\x82\xAC"
+                          "99 \xC2\x81"sv;
+    CHECK(unicode::utf8_length(single_byte_encoding::Windows1252, input) == expected.size());
+    CHECK(unicode::decode_single_byte(single_byte_encoding::Windows1252, input) == expected);
+
+    auto all = string {};
+    for (unsigned i = 0; i < 256; ++i)
+        all += static_cast<char>(i);
+    auto const utf8 = unicode::decode_single_byte(single_byte_encoding::Windows1252, all);
+    CHECK(utf8.size() == unicode::utf8_length(single_byte_encoding::Windows1252, all));
+    CHECK(unicode::encode_single_byte(single_byte_encoding::Windows1252, utf8) == all);
+}
+
+TEST_CASE("convert.utf8_to_single_byte", "[convert]")
+{
+    auto const euro = "\xE2\x82\xAC"sv;
+    CHECK(unicode::single_byte_length(euro) == 1);
+    CHECK(!unicode::encode_single_byte(single_byte_encoding::Latin1, euro).has_value());
+    CHECK(unicode::encode_single_byte(single_byte_encoding::Windows1252, euro) == "\x80");
+
+    // U+0080 is a C1 control in Latin-1, but unassigned in Windows-1252.
+    CHECK(unicode::encode_single_byte(single_byte_encoding::Latin1, "\xC2\x80"sv) == "\x80");
+    CHECK(!unicode::encode_single_byte(single_byte_encoding::Windows1252, "\xC2\x80"sv).has_value());
+
+    for (auto const encoding: { single_byte_encoding::Latin1, single_byte_encoding::Windows1252 })
+    {
+        CHECK(!unicode::encode_single_byte(encoding, "a\xC3"sv).has_value());         // incomplete
+        CHECK(!unicode::encode_single_byte(encoding, "\xA9"sv).has_value());          // lone continuation
+        CHECK(!unicode::encode_single_byte(encoding, "\xC1\xBF"sv).has_value());      // overlong
+        CHECK(!unicode::encode_single_byte(encoding, "\xE0\x82\xAC"sv).has_value());  // overlong
+        CHECK(!unicode::encode_single_byte(encoding, "\xF0\x9F\x98\x80"sv).has_value());
+    }
+}
+
+TEST_CASE("convert.is_representable", "[convert]")
+{
+    auto const check = [](string_view text, bool latin1, bool windows1252) {
+        // Move the text across block boundaries.
+        for (size_t padding = 0; padding < 40; ++padding)
+        {
+            auto const input = string(padding, 'x') + string(text) + string(padding % 7, 'y');
+            INFO(fmt::format("text size: {}, padding: {}", text.size(), padding));
+            CHECK(unicode::is_representable(single_byte_encoding::Latin1, input) == latin1);
+            CHECK(unicode::is_representable(single_byte_encoding::Windows1252, input) == windows1252);
+            CHECK(unicode::encode_single_byte(single_byte_encoding::Latin1, input).has_value() == latin1);
+        }
+    };
+
+    check("", true, true);
+    check("Gr\xC3\xBC\xC3\x9F"
+          "e",
+          true,
+          true);
+    check("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9", true, true);
+    check("\xC2\x85", true, false);
+    check("\xE2\x82\xAC", false, true);
+    check("\xC4\x80", false, false);
+    check("\xC3", false, false);
+    check("\xA9", false, false);
+    check("\xC3\xA9\xA9", false, false);
+    check("\xC3\xC3\xA9", false, false);
+    check("\xC1\xBF", false, false);
+    check("\xF0\x9F\x98\x80", false, false);
+}
+
+TEST_CASE("convert.into_span", "[convert]")
+{
+    auto const s32 = U"Gr\u00FC\u00DFe, \U0001F600!"sv;
+    auto const s8 = "Gr\xC3\xBC\xC3\x9F" "e, \xF0\x9F\x98\x80!"sv;
+
+    auto buffer8 = array<char, 32> {};
+    auto buffer16 = array<char16_t, 32> {};
+    auto buffer32 = array<char32_t, 32> {};
+
+    auto const length8 = unicode::convert_to<char>(s32, span<char>(buffer8));
+    auto const length16 = unicode::convert_to<char16_t>(s8, span<char16_t>(buffer16));
+    auto const length32 = unicode::convert_to<char32_t>(u16string_view(buffer16.data(), length16), span<char32_t>(buffer32));
+    auto const toUtf8Length = unicode::to_utf8(s32, span<char>(buffer8));
+    auto const fromUtf8Length = unicode::from_utf8(s8, span<char32_t>(buffer32));
+
+    CHECK(length8 == s8.size());
+    CHECK(unicode::converted_length<char>(s32) == s8.size());
+    CHECK(length16 == 10);
+    CHECK(unicode::converted_length<char16_t>(s8) == 10);
+    CHECK(length32 == s32.size());
+    CHECK(toUtf8Length == s8.size());
+    CHECK(unicode::utf8_length(s32) == s8.size());
+    CHECK(fromUtf8Length == s32.size());
+    CHECK(u32string_view(buffer32.data(), fromUtf8Length) == s32);
+
+    // Output too small: stops before the codepoint that does not fit.
+    CHECK(unicode::convert_to<char>(s32, span<char>(buffer8.data(), 10)) == 9);
+    CHECK(unicode::to_utf8(s32, span<char>(buffer8.data(), 10)) == 9);
+    CHECK(string_view(buffer8.data(), 9) == s8.substr(0, 9));
+    CHECK(unicode::from_utf8(s8, span<char32_t>(buffer32.data(), 3)) == 3);
+    CHECK(unicode::from_utf8(s8, span<char32_t>()) == 0);
+
+    // Ill-formed sequences are skipped.
+    CHECK(unicode::from_utf8("a\xC3\xC3\xA9"sv, span<char32_t>(buffer32)) == 2);
+    CHECK(u32string_view(buffer32.data(), 2) == U"a\u00E9"sv);
+}
+
+TEST_CASE("convert.memory_resource", "[convert]")
+{
+    // Long enough to not fit into std::basic_string's small buffer.
+    auto const s32 = U"Gr\u00FC\u00DFe, \U0001F600! The quick brown fox."sv;
+    auto const s8 = "Gr\xC3\xBC\xC3\x9F" "e, \xF0\x9F\x98\x80! The quick brown fox."sv;
+    auto frame = arena {};
+    auto const defaultResource = default_resource_guard {};
+
+    auto const t8 = unicode::convert_to<char>(s32, &frame.resource);
+    auto const t16 = unicode::convert_to<char16_t>(s8, &frame.resource);
+    auto const t32 = unicode::from_utf8(s8, &frame.resource);
+    auto const u8 = unicode::to_utf8(s32, &frame.resource);
+    CHECK(frame.upstream.allocations() == 0);
+    CHECK(defaultResource.counter.allocations() == 0);
+
+    CHECK(t8 == s8);
+    CHECK(t16 == u"Gr\u00FC\u00DFe, \U0001F600! The quick brown fox."sv);
+    CHECK(t32 == s32);
+    CHECK(u8 == s8);
+    CHECK(frame.owns(t8.data()));
+    CHECK(frame.owns(t16.data()));
+    CHECK(frame.owns(t32.data()));
+    CHECK(frame.owns(u8.data()));
+}
@@ -14,6 +14,7 @@
 
 #include <libunicode/codepoint_properties_data.h>
 #include <libunicode/emoji_segmenter.h>
+#include <libunicode/instrumentation.h>
 #include <libunicode/ucd.h>
 
 #include <cassert>
@@ -149,6 +150,10 @@ bool emoji_segmenter::consume(out<size_t> size, out<PresentationStyle> emoji) no
 
     size.assign(currentCursorEnd_);
     emoji.assign(isEmoji_ ? PresentationStyle::Emoji : PresentationStyle::Text);
+
+    instrumentation::count(instrumentation::counter::emoji_segments);
+    if (isEmoji_)
+        instrumentation::count(instrumentation::counter::emoji_presentation_segments);
     nextCursorBegin_ = currentCursorEnd_;
 
     return true;
@@ -51,6 +51,7 @@ enum class EmojiSegmentationCategory : int8_t
     TagTerm = 15,
 };
 
+#if !defined(LIBUNICODE_MINIMAL_TABLES)
 /**
  * emoji_segmenter API for segmenting emojis into text-emoji and emoji-emoji presentations.
  *
@@ -114,6 +115,7 @@ class emoji_segmenter
   private:
     size_t consume_once();
 };
+#endif // !LIBUNICODE_MINIMAL_TABLES
 
 inline std::ostream& operator<<(std::ostream& os, PresentationStyle ps)
 {
@@ -0,0 +1,132 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <utility>
+
+namespace unicode
+{
+
+/// Minimal synchronous generator, as a stand-in for C++23's std::generator.
+///
+/// The coroutine runs lazily, each co_yield'ed value being referenced by the iterator
+/// until the coroutine is resumed by incrementing it. It is a move-only input view.
+template <typename T>
+class generator: public std::ranges::view_base
+{
+  public:
+    struct promise_type
+    {
+        T const* current = nullptr;
+        std::exception_ptr exception {};
+
+        generator get_return_object() noexcept { return generator { handle_type::from_promise(*this) }; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+        std::suspend_always yield_value(T const& value) noexcept
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        // Generators are synchronous.
+        template <typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    class iterator
+    {
+      public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(handle_type handle) noexcept: _handle { handle } {}
+
+        T const& operator*() const noexcept { return *_handle.promise().current; }
+        T const* operator->() const noexcept { return _handle.promise().current; }
+
+        iterator& operator++()
+        {
+            resume(_handle);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(iterator const& i, std::default_sentinel_t) noexcept { return !i._handle || i._handle.done(); }
+
+      private:
+        handle_type _handle {};
+    };
+
+    generator() noexcept = default;
+    generator(generator&& other) noexcept: _handle { std::exchange(other._handle, {}) } {}
+    generator& operator=(generator&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (_handle)
+                _handle.destroy();
+            _handle = std::exchange(other._handle, {});
+        }
+        return *this;
+    }
+    generator(generator const&) = delete;
+    generator& operator=(generator const&) = delete;
+
+    ~generator()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    /// Runs the coroutine up to its first co_yield (or its end).
+    ///
+    /// Must be called at most once.
+    iterator begin()
+    {
+        resume(_handle);
+        return iterator { _handle };
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+  private:
+    explicit generator(handle_type handle) noexcept: _handle { handle } {}
+
+    static void resume(handle_type handle)
+    {
+        if (!handle || handle.done())
+            return;
+        handle.resume();
+        if (auto const exception = std::exchange(handle.promise().exception, {}))
+            std::rethrow_exception(exception);
+    }
+
+    handle_type _handle {};
+};
+
+} // namespace unicode
@@ -42,6 +42,16 @@ void grapheme_process_init(char32_t nextCodepoint, grapheme_segmenter_state& sta
 /// @retval false both codepoints belong to the same grapheme cluster
 bool grapheme_process_breakable(char32_t nextCodepoint, grapheme_segmenter_state& state) noexcept;
 
+/// Same as above, but using the given tables, such as those of a specific Unicode version (see codepoint_versions).
+void grapheme_process_init(char32_t nextCodepoint,
+                           grapheme_segmenter_state& state,
+                           codepoint_properties::tables_view const& tables) noexcept;
+
+/// Same as above, but using the given tables, such as those of a specific Unicode version (see codepoint_versions).
+bool grapheme_process_breakable(char32_t nextCodepoint,
+                                grapheme_segmenter_state& state,
+                                codepoint_properties::tables_view const& tables) noexcept;
+
 /// Implements http://www.unicode.org/reports/tr29/tr29-27.html#Grapheme_Cluster_Boundary_Rules
 class grapheme_segmenter
 {
@@ -88,15 +98,13 @@ class grapheme_segmenter
     ///
     /// @retval true both codepoints to not belong to the same grapheme cluster
     /// @retval false both codepoints belong to the same grapheme cluster
-    static bool breakable(char32_t a, char32_t b) noexcept
-    {
-        auto state = grapheme_segmenter_state {};
-        state.previousCodepoint = a;
-        state.previousProperties = codepoint_properties::get(a);
-        state.ri_counter =
-            (state.previousProperties.grapheme_cluster_break == Grapheme_Cluster_Break::Regional_Indicator) ? 1 : 0;
-        return grapheme_process_breakable(b, state);
-    }
+    ///
+    /// Unlike grapheme_process_breakable(), this is not counted by the instrumentation,
+    /// as callers like scan_text() count the clusters they keep themselves.
+    static bool breakable(char32_t a, char32_t b) noexcept;
+
+    /// Same as above, but using the given tables, such as those of a specific Unicode version.
+    static bool breakable(char32_t a, char32_t b, codepoint_properties::tables_view const& tables) noexcept;
 
     static bool nonbreakable(char32_t a, char32_t b) noexcept { return !breakable(a, b); }
 
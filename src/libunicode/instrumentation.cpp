@@ -0,0 +1,59 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/instrumentation.h>
+
+namespace unicode::instrumentation
+{
+
+#if defined(LIBUNICODE_INSTRUMENTATION)
+thread_local std::array<uint64_t, counter_count> detail::thread_counters {};
+#endif
+
+std::string_view name(counter c) noexcept
+{
+    switch (c)
+    {
+        case counter::scan_ascii_runs: return "scan_ascii_runs";
+        case counter::scan_ascii_bytes: return "scan_ascii_bytes";
+        case counter::scan_nonascii_runs: return "scan_nonascii_runs";
+        case counter::scan_nonascii_bytes: return "scan_nonascii_bytes";
+        case counter::scan_column_limit_rewinds: return "scan_column_limit_rewinds";
+        case counter::scan_invalid_sequences: return "scan_invalid_sequences";
+        case counter::grapheme_clusters: return "grapheme_clusters";
+        case counter::grapheme_codepoints: return "grapheme_codepoints";
+        case counter::emoji_segments: return "emoji_segments";
+        case counter::emoji_presentation_segments: return "emoji_presentation_segments";
+        case counter::script_runs: return "script_runs";
+        case counter::script_codepoints: return "script_codepoints";
+    }
+    return "unknown";
+}
+
+snapshot_values snapshot() noexcept
+{
+#if defined(LIBUNICODE_INSTRUMENTATION)
+    return { detail::thread_counters };
+#else
+    return {};
+#endif
+}
+
+void reset() noexcept
+{
+#if defined(LIBUNICODE_INSTRUMENTATION)
+    detail::thread_counters = {};
+#endif
+}
+
+} // namespace unicode::instrumentation
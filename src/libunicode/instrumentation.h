@@ -0,0 +1,90 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Hot-path counters of scan_text() and the segmenters, to see how production text is processed.
+///
+/// The counters are per thread, and only compiled in when built with LIBUNICODE_INSTRUMENTATION=ON
+/// (defining LIBUNICODE_INSTRUMENTATION). Otherwise counting compiles to nothing and snapshots are all zero.
+namespace unicode::instrumentation
+{
+
+enum class counter : uint8_t
+{
+    scan_ascii_runs,             ///< ASCII fast path runs in scan_text()
+    scan_ascii_bytes,            ///< bytes consumed by the ASCII fast path
+    scan_nonascii_runs,          ///< detail::scan_for_text_nonascii() runs
+    scan_nonascii_bytes,         ///< bytes consumed by detail::scan_for_text_nonascii()
+    scan_column_limit_rewinds,   ///< grapheme clusters rewound for not fitting the column limit
+    scan_invalid_sequences,      ///< invalid or incomplete UTF-8 sequences
+    grapheme_clusters,           ///< grapheme clusters started by the grapheme segmentation
+    grapheme_codepoints,         ///< codepoints processed by the grapheme segmentation
+    emoji_segments,              ///< segments emitted by emoji_segmenter
+    emoji_presentation_segments, ///< of which in emoji presentation
+    script_runs,                 ///< script runs ended by script_segmenter
+    script_codepoints,           ///< codepoints processed by script_segmenter
+};
+
+inline constexpr size_t counter_count = static_cast<size_t>(counter::script_codepoints) + 1;
+
+#if defined(LIBUNICODE_INSTRUMENTATION)
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+std::string_view name(counter c) noexcept;
+
+/// The calling thread's counter values at the time of snapshot().
+struct snapshot_values
+{
+    std::array<uint64_t, counter_count> values {};
+
+    constexpr uint64_t operator[](counter c) const noexcept { return values[static_cast<size_t>(c)]; }
+
+    /// Average number of codepoints per grapheme cluster.
+    [[nodiscard]] constexpr double average_cluster_length() const noexcept
+    {
+        auto const clusters = (*this)[counter::grapheme_clusters];
+        return clusters ? static_cast<double>((*this)[counter::grapheme_codepoints]) / static_cast<double>(clusters) : 0.0;
+    }
+};
+
+/// @returns the calling thread's counters.
+[[nodiscard]] snapshot_values snapshot() noexcept;
+
+/// Resets the calling thread's counters to zero.
+void reset() noexcept;
+
+namespace detail
+{
+#if defined(LIBUNICODE_INSTRUMENTATION)
+    extern thread_local std::array<uint64_t, counter_count> thread_counters;
+#endif
+} // namespace detail
+
+/// Adds @p n to the calling thread's counter @p c, or does nothing unless instrumentation is enabled.
+inline void count([[maybe_unused]] counter c, [[maybe_unused]] uint64_t n = 1) noexcept
+{
+#if defined(LIBUNICODE_INSTRUMENTATION)
+    detail::thread_counters[static_cast<size_t>(c)] += n;
+#endif
+}
+
+} // namespace unicode::instrumentation
@@ -0,0 +1,137 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/capi.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/instrumentation.h>
+#include <libunicode/scan.h>
+#include <libunicode/script_segmenter.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string_view>
+#include <thread>
+
+using unicode::instrumentation::counter;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+// Returns the expected counter value, which is zero unless instrumentation is enabled.
+uint64_t expected(uint64_t value)
+{
+    return unicode::instrumentation::enabled ? value : 0;
+}
+} // namespace
+
+TEST_CASE("instrumentation.scan_text")
+{
+    unicode::instrumentation::reset();
+    auto state = unicode::scan_state {};
+    auto const text = "Hello \xFF\xC3\xA4world"sv; // an invalid byte, ä
+    CHECK(unicode::scan_text(state, text, 80).count == 13);
+
+    auto const snapshot = unicode::instrumentation::snapshot();
+    CHECK(snapshot[counter::scan_ascii_runs] == expected(2));
+    CHECK(snapshot[counter::scan_ascii_bytes] == expected(11));
+    CHECK(snapshot[counter::scan_nonascii_runs] == expected(1));
+    CHECK(snapshot[counter::scan_nonascii_bytes] == expected(3));
+    CHECK(snapshot[counter::scan_invalid_sequences] == expected(1));
+    CHECK(snapshot[counter::scan_column_limit_rewinds] == 0);
+    CHECK(snapshot[counter::grapheme_clusters] == expected(1));
+}
+
+TEST_CASE("instrumentation.scan_text.rewind")
+{
+    unicode::instrumentation::reset();
+    auto state = unicode::scan_state {};
+    auto const text = "ab\xF0\x9F\x98\x80"sv; // ab, U+1F600 (wide)
+    CHECK(unicode::scan_text(state, text, 3).count == 2);
+    CHECK(unicode::instrumentation::snapshot()[counter::scan_column_limit_rewinds] == expected(1));
+}
+
+TEST_CASE("instrumentation.scan_text.rewind_counts_once")
+{
+    unicode::instrumentation::reset();
+    auto state = unicode::scan_state {};
+    auto const text = "\xC3\xA4\xC3\xB6\xF0\x9F\x98\x80"sv; // ä, ö, U+1F600 (wide)
+    CHECK(unicode::scan_text(state, text, 3).count == 2);
+
+    // The rewound emoji is counted by the call that scans it again, not by both.
+    auto const rest = text.substr(static_cast<size_t>(state.next - text.data()));
+    CHECK(unicode::scan_text(state, rest, 80).count == 2);
+
+    auto const snapshot = unicode::instrumentation::snapshot();
+    CHECK(snapshot[counter::scan_column_limit_rewinds] == expected(1));
+    CHECK(snapshot[counter::grapheme_clusters] == expected(3));
+    CHECK(snapshot[counter::grapheme_codepoints] == expected(3));
+}
+
+TEST_CASE("instrumentation.grapheme_segmenter")
+{
+    unicode::instrumentation::reset();
+    auto const codepoints = U"e\u0301xy\U0001F468\u200D\U0001F469"sv; // é, x, y, man-ZWJ-woman
+    auto segmenter = unicode::grapheme_segmenter(codepoints);
+    while (segmenter.codepointsAvailable())
+        ++segmenter;
+
+    auto const snapshot = unicode::instrumentation::snapshot();
+    CHECK(snapshot[counter::grapheme_clusters] == expected(4));
+    CHECK(snapshot[counter::grapheme_codepoints] == expected(codepoints.size()));
+    if (unicode::instrumentation::enabled)
+        CHECK(snapshot.average_cluster_length() == 1.75);
+}
+
+TEST_CASE("instrumentation.script_segmenter")
+{
+    unicode::instrumentation::reset();
+    auto const codepoints = U"AB \u03BB;\u5408"sv; // Latin, Greek, Han
+    auto segmenter = unicode::script_segmenter(codepoints);
+    auto runs = uint64_t { 0 };
+    while (segmenter.consume().has_value())
+        ++runs;
+
+    // Each codepoint is processed once, including those starting a new script run.
+    auto const snapshot = unicode::instrumentation::snapshot();
+    CHECK(snapshot[counter::script_runs] == expected(runs));
+    CHECK(snapshot[counter::script_codepoints] == expected(codepoints.size()));
+}
+
+TEST_CASE("instrumentation.per_thread")
+{
+    unicode::instrumentation::reset();
+    std::thread([] {
+        auto state = unicode::scan_state {};
+        (void) unicode::scan_text(state, "text"sv, 80);
+        CHECK(unicode::instrumentation::snapshot()[counter::scan_ascii_runs] == expected(1));
+    }).join();
+    CHECK(unicode::instrumentation::snapshot()[counter::scan_ascii_runs] == 0);
+}
+
+TEST_CASE("instrumentation.capi")
+{
+    REQUIRE(u_instrumentation_counter_count() == unicode::instrumentation::counter_count);
+    CHECK(u_instrumentation_counter_name(0) == "scan_ascii_runs"sv);
+    CHECK(u_instrumentation_counter_name(unicode::instrumentation::counter_count) == nullptr);
+    CHECK(u_instrumentation_enabled() == (unicode::instrumentation::enabled ? 1 : 0));
+
+    u_instrumentation_reset();
+    auto state = unicode::scan_state {};
+    (void) unicode::scan_text(state, "text"sv, 80);
+    auto values = std::array<uint64_t, unicode::instrumentation::counter_count> {};
+    CHECK(u_instrumentation_snapshot(values.data(), values.size()) == values.size());
+    CHECK(values[static_cast<size_t>(counter::scan_ascii_bytes)] == expected(4));
+    CHECK(u_instrumentation_snapshot(values.data(), 1) == 1);
+}
@@ -13,6 +13,8 @@
  */
 #pragma once
 
+#include <cstdint>
+
 #if defined(__x86_64__) || defined(_M_AMD64)
     #include <emmintrin.h> // AVX, AVX2, FMP
     #include <immintrin.h> // SSE2
@@ -65,6 +67,8 @@ struct platform_intrinsics<__m128i>
 
     static inline m128i compare_less(m128i a, m128i b) noexcept { return _mm_cmplt_epi8(a, b); }
 
+    static inline m128i compare_equal(m128i a, m128i b) noexcept { return _mm_cmpeq_epi8(a, b); }
+
     static inline int movemask_epi8(m128i a) { return _mm_movemask_epi8(a); }
 
     static inline m128i cvtsi64_si128(int64_t a) { return _mm_cvtsi64_si128(a); }
@@ -141,6 +145,12 @@ struct platform_intrinsics<int64x2_t>
         return vreinterpretq_s64_u8(vcltq_s8(vreinterpretq_s8_s64(a), vreinterpretq_s8_s64(b)));
     }
 
+    static inline m128i compare_equal(m128i a, m128i b) noexcept
+    {
+        // Compares the 16 8-bit integers in a and the 16 8-bit integers in b for equality.
+        return vreinterpretq_s64_u8(vceqq_s8(vreinterpretq_s8_s64(a), vreinterpretq_s8_s64(b)));
+    }
+
     static inline int movemask_epi8(m128i a)
     {
         // Use increasingly wide shifts+adds to collect the sign bits
@@ -0,0 +1,276 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/intrinsics.h>
+#include <libunicode/line_index.h>
+#include <libunicode/scan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <thread>
+
+using std::string_view;
+using std::vector;
+
+namespace unicode
+{
+
+namespace
+{
+    auto constexpr BlockSize = size_t { 64 };
+
+    // Tests if given byte is either a control character or part of a non-ASCII codepoint.
+    constexpr bool is_special(char ch) noexcept
+    {
+        return static_cast<uint8_t>(ch) < 0x20 || static_cast<uint8_t>(ch) >= 0x80;
+    }
+
+    int countTrailingZeroBits(uint64_t value) noexcept
+    {
+#if defined(_WIN32)
+        unsigned long r = 0;
+        _BitScanForward64(&r, value);
+        return static_cast<int>(r);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    struct block_masks
+    {
+        uint64_t newlines;
+        uint64_t special;
+        uint64_t carriageReturns;
+    };
+
+    // Classifies the BlockSize bytes at @p input.
+    block_masks classify_block(char const* input) noexcept
+    {
+#if defined(USE_INTRINSICS)
+        auto const LF = intrinsics::set1_epi8('\n');
+        auto const CR = intrinsics::set1_epi8('\r');
+        auto const ControlCodeMax = intrinsics::set1_epi8(0x20); // signed compare, also catches 0x80..0xFF
+
+        auto masks = block_masks { 0, 0, 0 };
+        for (size_t i = 0; i < BlockSize; i += sizeof(intrinsics::m128i))
+        {
+            auto const batch = intrinsics::load_unaligned((intrinsics::m128i const*) (input + i));
+            auto const shift = static_cast<unsigned>(i);
+            // clang-format off
+            masks.newlines |= uint64_t(static_cast<uint16_t>(intrinsics::movemask_epi8(intrinsics::compare_equal(batch, LF)))) << shift;
+            masks.special |= uint64_t(static_cast<uint16_t>(intrinsics::movemask_epi8(intrinsics::compare_less(batch, ControlCodeMax)))) << shift;
+            masks.carriageReturns |= uint64_t(static_cast<uint16_t>(intrinsics::movemask_epi8(intrinsics::compare_equal(batch, CR)))) << shift;
+            // clang-format on
+        }
+        return masks;
+#else
+        auto masks = block_masks { 0, 0, 0 };
+        for (size_t i = 0; i < BlockSize; ++i)
+        {
+            auto const bit = uint64_t { 1 } << i;
+            if (input[i] == '\n')
+                masks.newlines |= bit;
+            if (input[i] == '\r')
+                masks.carriageReturns |= bit;
+            if (is_special(input[i]))
+                masks.special |= bit;
+        }
+        return masks;
+#endif
+    }
+
+    size_t measure_columns(string_view line) noexcept
+    {
+        auto state = scan_state {};
+        size_t columns = 0;
+        while (!line.empty())
+        {
+            state.next = line.data();
+            columns += scan_text(state, line, std::numeric_limits<size_t>::max()).count;
+            auto const consumed = static_cast<size_t>(state.next - line.data());
+            // Skip the control character scan_text() stopped at (zero-width).
+            line.remove_prefix(consumed ? consumed : 1);
+        }
+        return columns;
+    }
+
+    class line_indexer
+    {
+      public:
+        line_indexer(string_view text, size_t base, bool crlf, vector<line_info>& output) noexcept:
+            _text { text }, _base { base }, _crlf { crlf }, _output { output }
+        {
+        }
+
+        void run()
+        {
+            auto const end = _text.size();
+            auto pos = size_t { 0 };
+            for (; pos + BlockSize <= end; pos += BlockSize)
+            {
+                auto masks = classify_block(_text.data() + pos);
+                if (_crlf)
+                {
+                    // CR immediately followed by LF is part of the line terminator.
+                    auto nextNewlines = masks.newlines >> 1;
+                    if (pos + BlockSize < end && _text[pos + BlockSize] == '\n')
+                        nextNewlines |= uint64_t { 1 } << 63;
+                    masks.special &= ~(masks.carriageReturns & nextNewlines);
+                }
+                masks.special &= ~masks.newlines;
+
+                while (masks.newlines)
+                {
+                    auto const bit = countTrailingZeroBits(masks.newlines);
+                    auto const below = (uint64_t { 1 } << bit) - 1;
+                    _lineHasSpecial = _lineHasSpecial || (masks.special & below) != 0;
+                    addLine(pos + static_cast<size_t>(bit));
+                    masks.special &= ~below;
+                    masks.newlines &= masks.newlines - 1;
+                }
+                _lineHasSpecial = _lineHasSpecial || masks.special != 0;
+            }
+
+            for (; pos < end; ++pos)
+            {
+                if (_text[pos] == '\n')
+                    addLine(pos);
+                else if (is_special(_text[pos]) && !(_crlf && _text[pos] == '\r' && pos + 1 < end && _text[pos + 1] == '\n'))
+                    _lineHasSpecial = true;
+            }
+
+            if (_lineStart < end)
+                addLine(end, false);
+        }
+
+      private:
+        void addLine(size_t terminator, bool terminated = true)
+        {
+            auto length = terminator - _lineStart;
+            if (terminated && _crlf && length && _text[terminator - 1] == '\r')
+                --length;
+
+            auto line = line_info {};
+            line.offset = _base + _lineStart;
+            line.length = length;
+            line.ascii = !_lineHasSpecial;
+            line.columns = line.ascii ? length : measure_columns(_text.substr(_lineStart, length));
+            _output.emplace_back(line);
+
+            _lineStart = terminator + 1;
+            _lineHasSpecial = false;
+        }
+
+        string_view _text;
+        size_t _base;
+        bool _crlf;
+        vector<line_info>& _output;
+        size_t _lineStart = 0;
+        bool _lineHasSpecial = false;
+    };
+
+    // Estimates the number of lines from a sample at the beginning of the text,
+    // so that the output can be allocated up front rather than grown (and copied) repeatedly.
+    // The estimate is bounded by the number of bytes, as no line is shorter than one byte.
+    size_t estimate_line_count(string_view text) noexcept
+    {
+        auto constexpr SampleSize = size_t { 64 * 1024 };
+        auto const sample = text.substr(0, SampleSize);
+        auto const newlines = static_cast<size_t>(std::count(sample.begin(), sample.end(), '\n'));
+        if (sample.size() == text.size())
+            return newlines + 1;
+        auto const estimate = (newlines + 1) * (text.size() / sample.size() + 1) * 9 / 8;
+        return std::min(estimate, text.size() + 1);
+    }
+
+    // Joins all started threads when leaving the scope, also when unwinding.
+    struct thread_join_guard
+    {
+        vector<std::thread>& threads;
+
+        ~thread_join_guard()
+        {
+            for (auto& thread: threads)
+                if (thread.joinable())
+                    thread.join();
+        }
+    };
+
+    // Finds the start of the line following the given position.
+    size_t next_line_start(string_view text, size_t pos) noexcept
+    {
+        if (pos >= text.size())
+            return text.size();
+        auto const p = static_cast<char const*>(std::memchr(text.data() + pos, '\n', text.size() - pos));
+        return p ? static_cast<size_t>(p - text.data()) + 1 : text.size();
+    }
+} // namespace
+
+vector<line_info> build_line_index(string_view text, line_index_options const& options)
+{
+    auto const threadCount = std::max(1u, options.threads);
+    if (threadCount == 1 || text.size() < threadCount * BlockSize)
+    {
+        auto lines = vector<line_info> {};
+        lines.reserve(estimate_line_count(text));
+        line_indexer(text, 0, options.crlf, lines).run();
+        return lines;
+    }
+
+    // Split the text into chunks at line boundaries, so that each thread works on whole lines only.
+    auto bounds = vector<size_t> { 0 };
+    for (unsigned i = 1; i < threadCount; ++i)
+        bounds.push_back(std::max(bounds.back(), next_line_start(text, text.size() * i / threadCount)));
+    bounds.push_back(text.size());
+
+    auto chunks = vector<vector<line_info>>(threadCount);
+    auto errors = vector<std::exception_ptr>(threadCount);
+    {
+        auto threads = vector<std::thread> {};
+        auto const joinGuard = thread_join_guard { threads };
+        threads.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([&, i]() {
+                try
+                {
+                    auto const chunk = text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+                    chunks[i].reserve(estimate_line_count(chunk));
+                    line_indexer(chunk, bounds[i], options.crlf, chunks[i]).run();
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+    }
+    for (auto const& error: errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    auto lineCount = size_t { 0 };
+    for (auto const& chunk: chunks)
+        lineCount += chunk.size();
+
+    auto lines = vector<line_info> {};
+    lines.reserve(lineCount);
+    for (auto const& chunk: chunks)
+        lines.insert(lines.end(), chunk.begin(), chunk.end());
+    return lines;
+}
+
+} // namespace unicode
@@ -0,0 +1,66 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace unicode
+{
+
+/// Describes a single line as found by build_line_index().
+struct line_info
+{
+    /// Byte offset of the first byte of this line.
+    size_t offset = 0;
+
+    /// Number of bytes of this line, excluding the line terminator.
+    size_t length = 0;
+
+    /// Number of columns this line occupies, with control characters being treated as zero-width.
+    size_t columns = 0;
+
+    /// Indicates whether this line only consists of printable US-ASCII characters,
+    /// in which case the number of columns equals the number of bytes.
+    bool ascii = true;
+
+    constexpr bool operator==(line_info const&) const noexcept = default;
+};
+
+/// Configures build_line_index().
+struct line_index_options
+{
+    /// Treats CR LF as a line terminator, rather than LF only.
+    bool crlf = false;
+
+    /// Number of threads to split the work across. Values less than 2 disable threading.
+    unsigned threads = 1;
+};
+
+/// Builds an index of all lines of the given UTF-8 encoded text.
+///
+/// Lines are terminated by LF (or CR LF, if enabled). The text after the last line terminator
+/// is only considered a line if it is not empty.
+///
+/// Line terminators and non-ASCII bytes are found in a single SIMD pass over the buffer.
+/// Only lines containing control characters or non-ASCII codepoints are measured with scan_text().
+///
+/// @param text     UTF-8 encoded text to index
+/// @param options  line terminator and threading options
+///
+/// @return all lines in order of appearance.
+std::vector<line_info> build_line_index(std::string_view text, line_index_options const& options = {});
+
+} // namespace unicode
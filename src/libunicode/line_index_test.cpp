@@ -0,0 +1,125 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/line_index.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+using namespace std::string_view_literals;
+
+using unicode::line_info;
+
+TEST_CASE("line_index.empty")
+{
+    CHECK(unicode::build_line_index(""sv).empty());
+}
+
+TEST_CASE("line_index.ascii")
+{
+    auto const lines = unicode::build_line_index("Hello\n\nWorld!"sv);
+    REQUIRE(lines.size() == 3);
+    CHECK(lines[0] == line_info { 0, 5, 5, true });
+    CHECK(lines[1] == line_info { 6, 0, 0, true });
+    CHECK(lines[2] == line_info { 7, 6, 6, true });
+}
+
+TEST_CASE("line_index.trailing_newline")
+{
+    auto const lines = unicode::build_line_index("a\nb\n"sv);
+    REQUIRE(lines.size() == 2);
+    CHECK(lines[1] == line_info { 2, 1, 1, true });
+}
+
+TEST_CASE("line_index.non_ascii")
+{
+    // U+00A9 (1 column), U+1F600 (2 columns), and a TAB (control, zero-width).
+    auto const lines = unicode::build_line_index("a\xC2\xA9\n\xF0\x9F\x98\x80x\n\tb"sv);
+    REQUIRE(lines.size() == 3);
+    CHECK(lines[0] == line_info { 0, 3, 2, false });
+    CHECK(lines[1] == line_info { 4, 5, 3, false });
+    CHECK(lines[2] == line_info { 10, 2, 1, false });
+}
+
+TEST_CASE("line_index.crlf")
+{
+    auto const text = "ab\r\ncd\r\n\re"sv;
+
+    auto const lf = unicode::build_line_index(text);
+    REQUIRE(lf.size() == 3);
+    CHECK(lf[0] == line_info { 0, 3, 2, false });
+
+    auto const crlf = unicode::build_line_index(text, { .crlf = true });
+    REQUIRE(crlf.size() == 3);
+    CHECK(crlf[0] == line_info { 0, 2, 2, true });
+    CHECK(crlf[1] == line_info { 4, 2, 2, true });
+    CHECK(crlf[2] == line_info { 8, 2, 1, false });
+}
+
+TEST_CASE("line_index.blocks")
+{
+    // Exercise the SIMD path with lines crossing block boundaries, CR LF split across blocks,
+    // and a non-ASCII character in the middle of a long line.
+    auto text = string {};
+    for (int i = 0; i < 50; ++i)
+    {
+        text += string(static_cast<size_t>(i * 7 % 130), 'x');
+        if (i % 5 == 0)
+            text += "\xC3\xA4";
+        text += "\r\n";
+    }
+
+    for (bool const crlf: { false, true })
+    {
+        auto const lines = unicode::build_line_index(text, { .crlf = crlf });
+        REQUIRE(lines.size() == 50);
+        size_t offset = 0;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            auto const length = i * 7 % 130 + (i % 5 == 0 ? 2 : 0);
+            auto const columns = i * 7 % 130 + (i % 5 == 0 ? 1 : 0);
+            INFO("line " << i << " crlf " << crlf);
+            CHECK(lines[i].offset == offset);
+            CHECK(lines[i].length == length + (crlf ? 0 : 1));
+            CHECK(lines[i].columns == columns);
+            CHECK(lines[i].ascii == (crlf && i % 5 != 0));
+            offset += length + 2;
+        }
+    }
+}
+
+TEST_CASE("line_index.threads")
+{
+    auto text = string {};
+    for (int i = 0; i < 1000; ++i)
+        text += string(static_cast<size_t>(i % 97), 'a') + (i % 3 ? "\n" : "\xE2\x80\xA6\n");
+
+    auto const expected = unicode::build_line_index(text);
+    REQUIRE(expected.size() == 1000);
+    for (unsigned const threads: { 2u, 3u, 8u })
+        CHECK(unicode::build_line_index(text, { .threads = threads }) == expected);
+}
+
+TEST_CASE("line_index.reserve_bounded")
+{
+    // A sample full of newlines must not make the index reserve more entries than there are bytes.
+    auto const text = string(64 * 1024, '\n') + string(1024 * 1024, 'x');
+    auto const lines = unicode::build_line_index(text);
+    CHECK(lines.size() == 64 * 1024 + 1);
+    CHECK(lines.capacity() <= text.size() + 1);
+}
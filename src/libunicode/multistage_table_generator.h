@@ -22,9 +22,11 @@
 #include <iomanip>
 #include <iterator>
 #include <limits>
+#include <numeric>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace support
@@ -49,7 +51,10 @@ struct multistage_table
     T const& get(SourceType index) const noexcept { return to_view().get(index); }
 };
 
+/// Generates a multistage_table of @p T values from the input values,
+/// which may be of a different type, such as strings using a different allocator.
 template <typename T,
+          typename InputType,
           typename SourceType,
           typename Stage1ElementType,
           typename Stage2ElementType,
@@ -59,7 +64,7 @@ template <typename T,
 class multistage_table_generator
 {
   public:
-    T const* _input;
+    InputType const* _input;
     size_t _inputSize;
     multistage_table<T, SourceType, Stage1ElementType, Stage2ElementType, BlockSize, MaxValue>& _output;
     Stage3Finder _stage3Finder;
@@ -155,22 +160,87 @@ class multistage_table_generator
 };
 
 template <typename T,
+          typename InputType,
           typename SourceType,
           typename Stage1ElementType,
           typename Stage2ElementType,
           typename Stage3Finder,
           SourceType BlockSize,
           SourceType MaxValue = std::numeric_limits<SourceType>::max()>
-void generate(T const* input,
+void generate(InputType const* input,
               size_t inputSize,
               multistage_table<T, SourceType, Stage1ElementType, Stage2ElementType, BlockSize, MaxValue>& output,
               Stage3Finder&& stage3Finder)
 {
-    auto builder =
-        multistage_table_generator<T, SourceType, Stage1ElementType, Stage2ElementType, Stage3Finder, BlockSize, MaxValue> {
-            input, inputSize, output, std::forward<Stage3Finder>(stage3Finder)
-        };
+    auto builder = multistage_table_generator<T,
+                                              InputType,
+                                              SourceType,
+                                              Stage1ElementType,
+                                              Stage2ElementType,
+                                              Stage3Finder,
+                                              BlockSize,
+                                              MaxValue> { input, inputSize, output, std::forward<Stage3Finder>(stage3Finder) };
     builder.generate();
 }
 
+/// Reorders the table's stage 3 values and stage 2 blocks by descending weight, so that the values and blocks
+/// looked up most frequently sit together, sharing cache lines.
+///
+/// The weight of a value or block is the sum of the weights of all source indices referring to it.
+/// Values and blocks of equal weight keep their order.
+///
+/// @param weight returns the weight (such as the lookup frequency) of the given source index.
+template <typename T,
+          typename SourceType,
+          typename Stage1ElementType,
+          typename Stage2ElementType,
+          SourceType BlockSize,
+          SourceType MaxValue,
+          typename Weight>
+void reorder(multistage_table<T, SourceType, Stage1ElementType, Stage2ElementType, BlockSize, MaxValue>& table,
+             Weight&& weight)
+{
+    auto valueWeights = std::vector<uint64_t>(table.stage3.size());
+    auto blockWeights = std::vector<uint64_t>(table.stage2.size() / BlockSize);
+    for (size_t block = 0; block < table.stage1.size(); ++block)
+    {
+        auto const stage2Block = size_t { table.stage1[block] };
+        for (size_t i = 0; i < BlockSize; ++i)
+        {
+            auto const w = static_cast<uint64_t>(weight(static_cast<SourceType>(block * BlockSize + i)));
+            blockWeights[stage2Block] += w;
+            valueWeights[table.stage2[stage2Block * BlockSize + i]] += w;
+        }
+    }
+
+    // Returns the old indices in their new order, and the new index of each old index.
+    auto const byWeight = [](std::vector<uint64_t> const& weights) {
+        auto order = std::vector<size_t>(weights.size());
+        std::iota(order.begin(), order.end(), size_t { 0 });
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+        auto newIndices = std::vector<size_t>(weights.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            newIndices[order[i]] = i;
+        return std::pair { std::move(order), std::move(newIndices) };
+    };
+    auto const [valueOrder, newValueIndices] = byWeight(valueWeights);
+    auto const [blockOrder, newBlockIndices] = byWeight(blockWeights);
+
+    auto stage3 = std::vector<T> {};
+    stage3.reserve(table.stage3.size());
+    for (auto const index: valueOrder)
+        stage3.push_back(std::move(table.stage3[index]));
+
+    auto stage2 = std::vector<Stage2ElementType> {};
+    stage2.reserve(table.stage2.size());
+    for (auto const block: blockOrder)
+        for (size_t i = 0; i < BlockSize; ++i)
+            stage2.push_back(static_cast<Stage2ElementType>(newValueIndices[table.stage2[block * BlockSize + i]]));
+
+    for (auto& block: table.stage1)
+        block = static_cast<Stage1ElementType>(newBlockIndices[block]);
+    table.stage2 = std::move(stage2);
+    table.stage3 = std::move(stage3);
+}
+
 } // namespace support
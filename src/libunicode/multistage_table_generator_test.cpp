@@ -0,0 +1,65 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/multistage_table_generator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+// 16 source indices in 4 blocks of 4, of which the first and third share the same stage 2 block.
+using small_table = support::multistage_table<char, uint32_t, uint8_t, uint8_t, 4, 15>;
+
+small_table make_small_table()
+{
+    auto table = small_table {};
+    table.stage1 = { 0, 1, 0, 2 };
+    table.stage2 = { 0, 0, 0, 0, /**/ 1, 2, 1, 2, /**/ 3, 3, 2, 3 };
+    table.stage3 = { 'a', 'b', 'c', 'd' };
+    return table;
+}
+} // namespace
+
+TEST_CASE("multistage_table_generator.reorder")
+{
+    auto table = make_small_table();
+    auto const original = make_small_table();
+
+    // The last block is looked up by far the most.
+    auto const weight = [](uint32_t index) { return index >= 12 ? 100 : 1; };
+    support::reorder(table, weight);
+
+    for (uint32_t index = 0; index <= 15; ++index)
+        CHECK(table.get(index) == original.get(index));
+
+    // 'd' is looked up 300 times, 'c' 102 times, 'a' 8 times and 'b' 2 times.
+    CHECK(table.stage3 == std::vector<char> { 'd', 'c', 'a', 'b' });
+
+    // The hottest block moves to the front, followed by the one shared by two source blocks.
+    CHECK(table.stage1 == std::vector<uint8_t> { 1, 2, 1, 0 });
+    CHECK(table.stage2 == std::vector<uint8_t> { 0, 0, 1, 0, /**/ 2, 2, 2, 2, /**/ 3, 1, 3, 1 });
+}
+
+TEST_CASE("multistage_table_generator.reorder_stable")
+{
+    auto table = make_small_table();
+    support::reorder(table, [](uint32_t) { return 0; });
+
+    auto const original = make_small_table();
+    CHECK(table.stage1 == original.stage1);
+    CHECK(table.stage2 == original.stage2);
+    CHECK(table.stage3 == original.stage3);
+}
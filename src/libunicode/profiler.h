@@ -0,0 +1,351 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// clang-format off
+#if defined(__x86_64__) || defined(_M_AMD64)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+// clang-format on
+
+/// Hierarchical scope profiler for the table loader, the table generator and the benchmarks.
+///
+/// Scopes are recorded into per-thread buffers, with timestamps read from the TSC (x86-64)
+/// or the virtual counter (AArch64) where available, and steady_clock otherwise.
+/// Recording is off by default, in which case opening a scope is a single relaxed atomic load.
+///
+/// The recorded scopes are aggregated per scope path by statistics() and write_summary(),
+/// and can be exported as Chrome trace JSON (for chrome://tracing or https://ui.perfetto.dev)
+/// by write_chrome_trace(). Both must only be called while no profiled scope is open on another thread,
+/// whereas reset() may be called at any time.
+namespace support::profiler
+{
+
+/// @returns the current timestamp in ticks of the profiler clock.
+inline uint64_t ticks() noexcept
+{
+#if defined(__x86_64__) || defined(_M_AMD64)
+    return __rdtsc();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t value;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/// A recorded scope.
+struct event
+{
+    std::string name;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    uint32_t parent = 0; ///< index + 1 of the enclosing scope in the same thread buffer, or 0
+};
+
+struct thread_buffer
+{
+    uint32_t threadId = 0;
+    std::vector<event> events;
+    uint32_t current = 0;    ///< index + 1 of the innermost open scope, or 0
+    uint32_t generation = 0; ///< reset() generation the events were recorded in
+};
+
+/// Aggregated durations (in microseconds) of all scopes with the same path.
+struct scope_statistics
+{
+    std::string path; ///< names of the enclosing scopes and the scope itself, separated by " > "
+    size_t count = 0;
+    double total = 0;
+    double min = 0;
+    double average = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+namespace detail
+{
+    struct state
+    {
+        std::atomic<bool> enabled = false;
+        std::atomic<uint32_t> generation = 0;
+        std::mutex mutex;
+        std::vector<std::shared_ptr<thread_buffer>> buffers;
+        uint64_t startTicks = ticks();
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    };
+
+    inline state& global()
+    {
+        static auto instance = state {};
+        return instance;
+    }
+
+    inline thread_buffer& this_thread()
+    {
+        // The buffers are owned by the global state, so that their events outlive the thread.
+        thread_local auto* const buffer = [] {
+            auto& s = global();
+            auto const _ = std::lock_guard { s.mutex };
+            auto const& result = s.buffers.emplace_back(std::make_shared<thread_buffer>());
+            result->threadId = static_cast<uint32_t>(s.buffers.size());
+            return result.get();
+        }();
+        return *buffer;
+    }
+
+    /// @returns the profiler clock's ticks per microsecond.
+    inline double ticks_per_microsecond()
+    {
+#if defined(__x86_64__) || defined(_M_AMD64) || (defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__)))
+        // Calibrated against steady_clock since the profiler state was created, waiting for at least 10 ms.
+        auto& s = global();
+        auto now = std::chrono::steady_clock::now();
+        while (now - s.startTime < std::chrono::milliseconds(10))
+        {
+            std::this_thread::yield();
+            now = std::chrono::steady_clock::now();
+        }
+        auto const elapsedTicks = static_cast<double>(ticks() - s.startTicks);
+        return elapsedTicks / std::chrono::duration<double, std::micro>(now - s.startTime).count();
+#else
+        return 1000.0;
+#endif
+    }
+
+    /// @returns the thread buffers recorded in since the last reset(), with the state's mutex held.
+    inline std::vector<thread_buffer const*> current_buffers()
+    {
+        auto& s = global();
+        auto const generation = s.generation.load(std::memory_order_relaxed);
+        auto result = std::vector<thread_buffer const*> {};
+        for (auto const& buffer: s.buffers)
+            if (buffer->generation == generation)
+                result.push_back(buffer.get());
+        return result;
+    }
+
+    inline std::string path_of(thread_buffer const& buffer, event const& e)
+    {
+        auto path = e.name;
+        for (auto parent = e.parent; parent != 0; parent = buffer.events[parent - 1].parent)
+            path = buffer.events[parent - 1].name + " > " + path;
+        return path;
+    }
+
+    inline void write_json_string(std::ostream& output, std::string_view text)
+    {
+        output << '"';
+        for (auto const ch: text)
+        {
+            switch (ch)
+            {
+                case '"': output << "\\\""; break;
+                case '\\': output << "\\\\"; break;
+                case '\n': output << "\\n"; break;
+                case '\t': output << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(ch));
+                        output << escaped;
+                    }
+                    else
+                        output << ch;
+                    break;
+            }
+        }
+        output << '"';
+    }
+} // namespace detail
+
+/// Starts or stops recording scopes.
+inline void enable(bool value = true) noexcept
+{
+    detail::global().enabled.store(value, std::memory_order_relaxed);
+}
+
+[[nodiscard]] inline bool enabled() noexcept
+{
+    return detail::global().enabled.load(std::memory_order_relaxed);
+}
+
+/// Discards all recorded scopes.
+///
+/// Only starts a new generation: each thread clears its own buffer when it next opens a scope,
+/// so that reset() never touches a buffer another thread is recording into. Scopes open during
+/// reset() are not recorded.
+inline void reset() noexcept
+{
+    detail::global().generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Records the time between construction and destruction as a scope nested in the innermost open one,
+/// if the profiler is enabled.
+class scope
+{
+  public:
+    explicit scope(std::string_view name)
+    {
+        if (!enabled())
+            return;
+        _buffer = &detail::this_thread();
+        if (auto const generation = detail::global().generation.load(std::memory_order_relaxed);
+            _buffer->generation != generation)
+        {
+            _buffer->events.clear();
+            _buffer->current = 0;
+            _buffer->generation = generation;
+        }
+        _generation = _buffer->generation;
+        _buffer->events.push_back(event { std::string(name), 0, 0, _buffer->current });
+        _index = static_cast<uint32_t>(_buffer->events.size());
+        _buffer->current = _index;
+        _buffer->events.back().start = ticks();
+    }
+
+    ~scope()
+    {
+        if (!_buffer || _buffer->generation != _generation)
+            return;
+        auto const end = ticks();
+        auto& e = _buffer->events[_index - 1];
+        e.end = end;
+        _buffer->current = e.parent;
+    }
+
+    scope(scope const&) = delete;
+    scope& operator=(scope const&) = delete;
+
+  private:
+    thread_buffer* _buffer = nullptr;
+    uint32_t _index = 0;
+    uint32_t _generation = 0;
+};
+
+/// @returns the durations of all completed scopes of all threads, aggregated by scope path,
+///          in the order the paths were first entered.
+[[nodiscard]] inline std::vector<scope_statistics> statistics()
+{
+    auto& s = detail::global();
+    auto const _ = std::lock_guard { s.mutex };
+    auto const ticksPerMicrosecond = detail::ticks_per_microsecond();
+
+    auto paths = std::vector<std::string> {};
+    auto durations = std::unordered_map<std::string, std::vector<double>> {};
+    for (auto const& buffer: detail::current_buffers())
+        for (auto const& e: buffer->events)
+        {
+            if (e.end == 0)
+                continue;
+            auto path = detail::path_of(*buffer, e);
+            auto& pathDurations = durations[path];
+            if (pathDurations.empty())
+                paths.emplace_back(std::move(path));
+            pathDurations.push_back(static_cast<double>(e.end - e.start) / ticksPerMicrosecond);
+        }
+
+    auto result = std::vector<scope_statistics> {};
+    result.reserve(paths.size());
+    for (auto& path: paths)
+    {
+        auto& values = durations[path];
+        std::sort(values.begin(), values.end());
+        auto& stats = result.emplace_back();
+        stats.count = values.size();
+        for (auto const value: values)
+            stats.total += value;
+        stats.min = values.front();
+        stats.average = stats.total / static_cast<double>(values.size());
+        stats.p99 = values[static_cast<size_t>(std::ceil(0.99 * static_cast<double>(values.size()))) - 1];
+        stats.max = values.back();
+        stats.path = std::move(path);
+    }
+    return result;
+}
+
+/// Writes statistics() as a table, durations in microseconds.
+inline void write_summary(std::ostream& output)
+{
+    auto const stats = statistics();
+    auto width = size_t { 5 };
+    for (auto const& entry: stats)
+        width = std::max(width, entry.path.size());
+
+    auto const flags = output.flags();
+    output << std::left << std::setw(static_cast<int>(width)) << "Scope" << std::right;
+    for (auto const* column: { "count", "total", "min", "avg", "p99", "max" })
+        output << std::setw(12) << column;
+    output << "  (us)\n" << std::fixed << std::setprecision(1);
+    for (auto const& entry: stats)
+    {
+        output << std::left << std::setw(static_cast<int>(width)) << entry.path << std::right;
+        output << std::setw(12) << entry.count;
+        for (auto const value: { entry.total, entry.min, entry.average, entry.p99, entry.max })
+            output << std::setw(12) << value;
+        output << '\n';
+    }
+    output.flags(flags);
+}
+
+/// Writes all completed scopes as Chrome trace JSON ("X" events, timestamps in microseconds).
+inline void write_chrome_trace(std::ostream& output)
+{
+    auto& s = detail::global();
+    auto const _ = std::lock_guard { s.mutex };
+    auto const ticksPerMicrosecond = detail::ticks_per_microsecond();
+
+    auto const flags = output.flags();
+    output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::fixed << std::setprecision(3);
+    auto separator = "\n";
+    for (auto const& buffer: detail::current_buffers())
+        for (auto const& e: buffer->events)
+        {
+            if (e.end == 0)
+                continue;
+            output << separator << "{\"name\":";
+            detail::write_json_string(output, e.name);
+            output << ",\"cat\":\"libunicode\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                   << ",\"ts\":" << static_cast<double>(e.start - s.startTicks) / ticksPerMicrosecond
+                   << ",\"dur\":" << static_cast<double>(e.end - e.start) / ticksPerMicrosecond << '}';
+            separator = ",\n";
+        }
+    output << "\n]}\n";
+    output.flags(flags);
+}
+
+} // namespace support::profiler
@@ -0,0 +1,138 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/profiler.h>
+#include <libunicode/scoped_timer.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace profiler = support::profiler;
+
+namespace
+{
+// Enables the profiler with no recorded scopes for the lifetime of the guard.
+struct profiling
+{
+    profiling()
+    {
+        profiler::reset();
+        profiler::enable();
+    }
+
+    ~profiling()
+    {
+        profiler::enable(false);
+        profiler::reset();
+    }
+};
+} // namespace
+
+TEST_CASE("profiler.disabled")
+{
+    profiler::reset();
+    {
+        auto const _ = profiler::scope { "ignored" };
+    }
+    CHECK(profiler::statistics().empty());
+}
+
+TEST_CASE("profiler.nested")
+{
+    auto const _ = profiling {};
+    {
+        auto const outer = profiler::scope { "outer" };
+        for (int i = 0; i < 3; ++i)
+            auto const inner = profiler::scope { "inner" };
+        auto const timer = support::scoped_timer { nullptr, "timer" };
+    }
+
+    auto const stats = profiler::statistics();
+    REQUIRE(stats.size() == 3);
+    CHECK(stats[0].path == "outer");
+    CHECK(stats[0].count == 1);
+    CHECK(stats[1].path == "outer > inner");
+    CHECK(stats[1].count == 3);
+    CHECK(stats[2].path == "outer > timer");
+    CHECK(stats[2].count == 1);
+    for (auto const& entry: stats)
+    {
+        CHECK(entry.min <= entry.average);
+        CHECK(entry.average <= entry.p99);
+        CHECK(entry.p99 <= entry.max);
+    }
+    CHECK(stats[1].total <= stats[0].total);
+}
+
+TEST_CASE("profiler.threads")
+{
+    auto const _ = profiling {};
+    {
+        auto const main = profiler::scope { "main" };
+        std::thread([] { auto const worker = profiler::scope { "worker" }; }).join();
+    }
+
+    auto const stats = profiler::statistics();
+    REQUIRE(stats.size() == 2);
+    CHECK(((stats[0].path == "main" && stats[1].path == "worker")
+           || (stats[0].path == "worker" && stats[1].path == "main")));
+}
+
+TEST_CASE("profiler.chrome_trace")
+{
+    auto const _ = profiling {};
+    {
+        auto const scope = profiler::scope { "Loading \"file\"" };
+    }
+
+    auto output = std::ostringstream {};
+    profiler::write_chrome_trace(output);
+    auto const trace = output.str();
+    CHECK(trace.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    CHECK(trace.find(R"({"name":"Loading \"file\"","cat":"libunicode","ph":"X","pid":1,"tid":)") != std::string::npos);
+    CHECK(trace.ends_with("]}\n"));
+
+    output = std::ostringstream {};
+    profiler::write_summary(output);
+    CHECK(output.str().find("Loading \"file\"") != std::string::npos);
+}
+
+TEST_CASE("profiler.reset_with_open_scope")
+{
+    auto const _ = profiling {};
+    {
+        auto const before = profiler::scope { "before" };
+        profiler::reset();
+        {
+            auto const after = profiler::scope { "after" };
+        }
+    }
+    {
+        auto const open = profiler::scope { "open" };
+        std::thread([] { profiler::reset(); }).join();
+    }
+
+    auto const stats = profiler::statistics();
+    CHECK(stats.empty());
+
+    {
+        auto const next = profiler::scope { "next" };
+    }
+    auto const nextStats = profiler::statistics();
+    REQUIRE(nextStats.size() == 1);
+    CHECK(nextStats[0].path == "next");
+    CHECK(nextStats[0].count == 1);
+}
@@ -0,0 +1,27 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/run_segmenter.h>
+#include <libunicode/usdt.h>
+
+#if defined(LIBUNICODE_HAS_USDT)
+namespace unicode::detail
+{
+
+void probe_run_segment(size_t start, size_t end) noexcept
+{
+    LIBUNICODE_PROBE2(run_segment, start, end);
+}
+
+} // namespace unicode::detail
+#endif
@@ -13,6 +13,10 @@
  */
 #pragma once
 
+#if defined(LIBUNICODE_MINIMAL_TABLES)
+    #error "run_segmenter requires the emoji properties, which are omitted with LIBUNICODE_TABLES=minimal."
+#endif
+
 #include <libunicode/emoji_segmenter.h>
 #include <libunicode/script_segmenter.h>
 #include <libunicode/support.h>
@@ -40,6 +44,14 @@ namespace detail
     {
         ((os << prep << std::get<Ts>(p)), ...);
     }
+
+#if defined(LIBUNICODE_HAS_USDT)
+    /// Fires the run_segment USDT probe (see usdt.h).
+    ///
+    /// Not inline, so that the probe site is part of libunicode rather than of every binary
+    /// instantiating basic_run_segmenter. Only called if libunicode was built with LIBUNICODE_USDT=ON.
+    void probe_run_segment(size_t start, size_t end) noexcept;
+#endif
 } // namespace detail
 
 /// API for segmenting incoming text into small runs.
@@ -112,6 +124,9 @@ class basic_run_segmenter
         candidate_.start = candidate_.end;
         candidate_.end = lastSplit_;
         candidate_.properties = properties_;
+#if defined(LIBUNICODE_HAS_USDT)
+        detail::probe_run_segment(candidate_.start, candidate_.end);
+#endif
 
         *result = candidate_;
         return true;
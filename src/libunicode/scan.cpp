@@ -12,8 +12,10 @@
  * limitations under the License.
  */
 #include <libunicode/grapheme_segmenter.h>
+#include <libunicode/instrumentation.h>
 #include <libunicode/intrinsics.h>
 #include <libunicode/scan.h>
+#include <libunicode/usdt.h>
 #include <libunicode/utf8.h>
 #include <libunicode/width.h>
 
@@ -139,113 +141,265 @@ size_t detail::scan_for_text_ascii(string_view text, size_t maxColumnCount) noex
     return static_cast<size_t>(distance(text.data(), input));
 }
 
-scan_result detail::scan_for_text_nonascii(scan_state& state,
-                                           string_view text,
-                                           size_t maxColumnCount,
-                                           grapheme_cluster_receiver& receiver) noexcept
+namespace
 {
-    size_t count = 0;
+    // Looks up codepoint properties in the published tables.
+    struct published_tables
+    {
+        static unsigned width(char32_t codepoint) noexcept { return unicode::width(codepoint); }
+        static bool breakable(char32_t a, char32_t b) noexcept { return grapheme_segmenter::breakable(a, b); }
+    };
 
-    char const* start = text.data();
-    char const* end = start + text.size();
-    char const* input = start;
-    char const* clusterStart = start;
-    char const* lastCodepointStart = start;
+    // Looks up codepoint properties in the given tables, such as those of a specific Unicode version.
+    struct given_tables
+    {
+        codepoint_properties::tables_view const& tables;
 
-    unsigned byteCount = 0; // bytes consume for the current codepoint
+        unsigned width(char32_t codepoint) const noexcept { return unicode::width(codepoint, tables); }
+        bool breakable(char32_t a, char32_t b) const noexcept { return grapheme_segmenter::breakable(a, b, tables); }
+    };
 
-    // TODO: move currentClusterWidth to scan_state.
-    size_t currentClusterWidth = 0; // current grapheme cluster's East Asian Width
+    template <typename Tables>
+    scan_result scan_nonascii(scan_state& state,
+                              string_view text,
+                              size_t maxColumnCount,
+                              grapheme_cluster_receiver& receiver,
+                              Tables const& tables) noexcept
+    {
+        size_t count = 0;
 
-    char const* resultStart = state.utf8.expectedLength ? start - state.utf8.currentLength : start;
-    char const* resultEnd = resultStart;
+        char const* start = text.data();
+        char const* end = start + text.size();
+        char const* input = start;
+        char const* clusterStart = start;
+        char const* lastCodepointStart = start;
 
-    while (input != end && count <= maxColumnCount)
-    {
-        if (is_control(*input) || !is_complex(*input))
-        {
-            // Incomplete UTF-8 sequence hit. That's invalid as well.
-            if (state.utf8.expectedLength)
-            {
-                ++count;
-                receiver.receiveInvalidGraphemeCluster();
-                state.utf8 = {};
-            }
-            state.lastCodepointHint = 0;
-            resultEnd = input;
-            break;
-        }
+        unsigned byteCount = 0; // bytes consume for the current codepoint
 
-        auto const result = from_utf8(state.utf8, static_cast<uint8_t>(*input++));
-        ++byteCount;
+        // TODO: move currentClusterWidth to scan_state.
+        size_t currentClusterWidth = 0; // current grapheme cluster's East Asian Width
 
-        if (holds_alternative<Incomplete>(result))
-            continue;
+        char const* resultStart = state.utf8.expectedLength ? start - state.utf8.currentLength : start;
+        char const* resultEnd = resultStart;
 
-        if (holds_alternative<Success>(result))
+        instrumentation::count(instrumentation::counter::scan_nonascii_runs);
+
+        // The current grapheme cluster is only counted once it is known to be kept,
+        // as one rewound at the column limit is scanned again by the next call.
+        uint64_t pendingClusters = 0;
+        uint64_t pendingCodepoints = 0;
+        auto const countPending = [&]() noexcept {
+            instrumentation::count(instrumentation::counter::grapheme_clusters, pendingClusters);
+            instrumentation::count(instrumentation::counter::grapheme_codepoints, pendingCodepoints);
+            pendingClusters = 0;
+            pendingCodepoints = 0;
+        };
+
+        while (input != end && count <= maxColumnCount)
         {
-            auto const prevCodepoint = state.lastCodepointHint;
-            auto const nextCodepoint = get<Success>(result).value;
-            auto const nextWidth = max(currentClusterWidth, static_cast<size_t>(width(nextCodepoint)));
-            state.lastCodepointHint = nextCodepoint;
-            if (grapheme_segmenter::breakable(prevCodepoint, nextCodepoint))
+            if (is_control(*input) || !is_complex(*input))
             {
-                // Flush out current grapheme cluster's East Asian Width.
-                count += currentClusterWidth;
-
-                if (count + nextWidth > maxColumnCount)
+                // Incomplete UTF-8 sequence hit. That's invalid as well.
+                if (state.utf8.expectedLength)
                 {
-                    // Currently scanned grapheme cluster won't fit. Break at start.
-                    currentClusterWidth = 0;
-                    input -= byteCount;
-                    break;
+                    instrumentation::count(instrumentation::counter::scan_invalid_sequences);
+                    ++count;
+                    receiver.receiveInvalidGraphemeCluster();
+                    state.utf8 = {};
                 }
-                receiver.receiveGraphemeCluster(string_view(clusterStart, byteCount), currentClusterWidth);
-
-                // And start a new grapheme cluster.
-                currentClusterWidth = nextWidth;
-                clusterStart = lastCodepointStart;
-                lastCodepointStart = input - byteCount;
-                byteCount = 0;
+                state.lastCodepointHint = 0;
                 resultEnd = input;
+                break;
             }
-            else
+
+            auto const result = from_utf8(state.utf8, static_cast<uint8_t>(*input++));
+            ++byteCount;
+
+            if (holds_alternative<Incomplete>(result))
+                continue;
+
+            if (holds_alternative<Success>(result))
             {
-                resultEnd = input;
-                // Increase width on VS16 but do not decrease on VS15.
-                if (nextCodepoint == 0xFE0F) // VS16
+                auto const prevCodepoint = state.lastCodepointHint;
+                auto const nextCodepoint = get<Success>(result).value;
+                auto const nextWidth = max(currentClusterWidth, static_cast<size_t>(tables.width(nextCodepoint)));
+                state.lastCodepointHint = nextCodepoint;
+                if (tables.breakable(prevCodepoint, nextCodepoint))
                 {
-                    currentClusterWidth = 2;
-                    if (count + currentClusterWidth > maxColumnCount)
+                    // Flush out current grapheme cluster's East Asian Width.
+                    count += currentClusterWidth;
+
+                    if (count + nextWidth > maxColumnCount)
                     {
-                        // Rewinding by {byteCount} bytes (overflow due to VS16).
+                        // Currently scanned grapheme cluster won't fit. Break at start.
+                        instrumentation::count(instrumentation::counter::scan_column_limit_rewinds);
                         currentClusterWidth = 0;
-                        input = clusterStart;
+                        input -= byteCount;
                         break;
                     }
+                    receiver.receiveGraphemeCluster(string_view(clusterStart, byteCount), currentClusterWidth);
+                    countPending();
+                    pendingClusters = 1;
+                    pendingCodepoints = 1;
+
+                    // And start a new grapheme cluster.
+                    currentClusterWidth = nextWidth;
+                    clusterStart = lastCodepointStart;
+                    lastCodepointStart = input - byteCount;
+                    byteCount = 0;
+                    resultEnd = input;
                 }
+                else
+                {
+                    resultEnd = input;
+                    // Increase width on VS16 but do not decrease on VS15.
+                    if (nextCodepoint == 0xFE0F) // VS16
+                    {
+                        currentClusterWidth = 2;
+                        if (count + currentClusterWidth > maxColumnCount)
+                        {
+                            // Rewinding by {byteCount} bytes (overflow due to VS16).
+                            instrumentation::count(instrumentation::counter::scan_column_limit_rewinds);
+                            currentClusterWidth = 0;
+                            input = clusterStart;
+                            pendingClusters = 0;
+                            pendingCodepoints = 0;
+                            break;
+                        }
+                    }
+                    ++pendingCodepoints;
 
-                // Consumed {byteCount} bytes for grapheme cluster.
-                lastCodepointStart = input - byteCount;
+                    // Consumed {byteCount} bytes for grapheme cluster.
+                    lastCodepointStart = input - byteCount;
+                }
+            }
+            else
+            {
+                assert(holds_alternative<Invalid>(result));
+                countPending();
+                instrumentation::count(instrumentation::counter::scan_invalid_sequences);
+                count++;
+                receiver.receiveInvalidGraphemeCluster();
+                currentClusterWidth = 0;
+                state.lastCodepointHint = 0;
+                state.utf8.expectedLength = 0;
+                byteCount = 0;
             }
         }
-        else
+        countPending();
+        count += currentClusterWidth;
+
+        assert(resultStart <= resultEnd);
+        instrumentation::count(instrumentation::counter::scan_nonascii_bytes, static_cast<uint64_t>(input - start));
+
+        state.next = input;
+        return { count, resultStart, resultEnd };
+    }
+
+    template <typename Tables>
+    scan_result scan(scan_state& state,
+                     std::string_view text,
+                     size_t maxColumnCount,
+                     grapheme_cluster_receiver& receiver,
+                     Tables const& tables) noexcept
+    {
+        //       ----(a)--->   A   -------> END
+        //                   ^   |
+        //                   |   |
+        // Start            (a) (b)
+        //                   |   |
+        //                   |   v
+        //       ----(b)--->   B   -------> END
+
+        enum class NextState
+        {
+            Trivial,
+            Complex
+        };
+
+        auto result = scan_result { 0, text.data(), text.data() };
+
+        if (state.next == nullptr)
+            state.next = text.data();
+
+        // If state indicates that we previously started consuming a UTF-8 sequence but did not complete yet,
+        // attempt to finish that one first.
+        if (state.utf8.expectedLength != 0)
+        {
+            result = scan_nonascii(state, text, maxColumnCount, receiver, tables);
+            text = std::string_view(result.end, static_cast<size_t>(std::distance(result.end, text.data() + text.size())));
+        }
+
+        if (text.empty())
+            return result;
+
+        auto nextState = is_complex(text.front()) ? NextState::Complex : NextState::Trivial;
+        while (result.count < maxColumnCount && state.next != (text.data() + text.size()))
         {
-            assert(holds_alternative<Invalid>(result));
-            count++;
-            receiver.receiveInvalidGraphemeCluster();
-            currentClusterWidth = 0;
-            state.lastCodepointHint = 0;
-            state.utf8.expectedLength = 0;
-            byteCount = 0;
+            switch (nextState)
+            {
+                case NextState::Trivial: {
+                    auto const count = detail::scan_for_text_ascii(text, maxColumnCount - result.count);
+                    if (!count)
+                        return result;
+                    instrumentation::count(instrumentation::counter::scan_ascii_runs);
+                    instrumentation::count(instrumentation::counter::scan_ascii_bytes, count);
+                    receiver.receiveAsciiSequence(text.substr(0, count));
+                    result.count += count;
+                    state.next += count;
+                    result.end += count;
+                    nextState = NextState::Complex;
+                    text.remove_prefix(count);
+                    break;
+                }
+                case NextState::Complex: {
+                    auto const sub = scan_nonascii(state, text, maxColumnCount - result.count, receiver, tables);
+                    if (!sub.count)
+                        return result;
+                    nextState = NextState::Trivial;
+                    result.count += sub.count;
+                    result.end = sub.end;
+                    text.remove_prefix(static_cast<size_t>(std::distance(sub.start, sub.end)));
+                    break;
+                }
+            }
         }
+
+        assert(result.start <= result.end);
+        assert(result.end <= state.next);
+
+        return result;
+    }
+
+    template <typename Tables>
+    scan_result probed_scan(scan_state& state,
+                            std::string_view text,
+                            size_t maxColumnCount,
+                            grapheme_cluster_receiver& receiver,
+                            Tables const& tables) noexcept
+    {
+        LIBUNICODE_PROBE3(scan_text_entry, text.data(), text.size(), maxColumnCount);
+        auto const result = scan(state, text, maxColumnCount, receiver, tables);
+        LIBUNICODE_PROBE2(scan_text_exit, static_cast<size_t>(result.end - result.start), result.count);
+        return result;
     }
-    count += currentClusterWidth;
+} // namespace
 
-    assert(resultStart <= resultEnd);
+scan_result detail::scan_for_text_nonascii(scan_state& state,
+                                           string_view text,
+                                           size_t maxColumnCount,
+                                           grapheme_cluster_receiver& receiver) noexcept
+{
+    return scan_nonascii(state, text, maxColumnCount, receiver, published_tables {});
+}
 
-    state.next = input;
-    return { count, resultStart, resultEnd };
+scan_result detail::scan_for_text_nonascii(scan_state& state,
+                                           string_view text,
+                                           size_t maxColumnCount,
+                                           grapheme_cluster_receiver& receiver,
+                                           codepoint_properties::tables_view const& tables) noexcept
+{
+    return scan_nonascii(state, text, maxColumnCount, receiver, given_tables { tables });
 }
 
 scan_result scan_text(scan_state& state, std::string_view text, size_t maxColumnCount) noexcept
@@ -258,70 +412,24 @@ scan_result scan_text(scan_state& state,
                       size_t maxColumnCount,
                       grapheme_cluster_receiver& receiver) noexcept
 {
-    //       ----(a)--->   A   -------> END
-    //                   ^   |
-    //                   |   |
-    // Start            (a) (b)
-    //                   |   |
-    //                   |   v
-    //       ----(b)--->   B   -------> END
-
-    enum class NextState
-    {
-        Trivial,
-        Complex
-    };
-
-    auto result = scan_result { 0, text.data(), text.data() };
-
-    if (state.next == nullptr)
-        state.next = text.data();
-
-    // If state indicates that we previously started consuming a UTF-8 sequence but did not complete yet,
-    // attempt to finish that one first.
-    if (state.utf8.expectedLength != 0)
-    {
-        result = detail::scan_for_text_nonascii(state, text, maxColumnCount, receiver);
-        text = std::string_view(result.end, static_cast<size_t>(std::distance(result.end, text.data() + text.size())));
-    }
-
-    if (text.empty())
-        return result;
-
-    auto nextState = is_complex(text.front()) ? NextState::Complex : NextState::Trivial;
-    while (result.count < maxColumnCount && state.next != (text.data() + text.size()))
-    {
-        switch (nextState)
-        {
-            case NextState::Trivial: {
-                auto const count = detail::scan_for_text_ascii(text, maxColumnCount - result.count);
-                if (!count)
-                    return result;
-                receiver.receiveAsciiSequence(text.substr(0, count));
-                result.count += count;
-                state.next += count;
-                result.end += count;
-                nextState = NextState::Complex;
-                text.remove_prefix(count);
-                break;
-            }
-            case NextState::Complex: {
-                auto const sub = detail::scan_for_text_nonascii(state, text, maxColumnCount - result.count, receiver);
-                if (!sub.count)
-                    return result;
-                nextState = NextState::Trivial;
-                result.count += sub.count;
-                result.end = sub.end;
-                text.remove_prefix(static_cast<size_t>(std::distance(sub.start, sub.end)));
-                break;
-            }
-        }
-    }
+    return probed_scan(state, text, maxColumnCount, receiver, published_tables {});
+}
 
-    assert(result.start <= result.end);
-    assert(result.end <= state.next);
+scan_result scan_text(scan_state& state,
+                      std::string_view text,
+                      size_t maxColumnCount,
+                      codepoint_properties::tables_view const& tables) noexcept
+{
+    return scan_text(state, text, maxColumnCount, null_receiver::get(), tables);
+}
 
-    return result;
+scan_result scan_text(scan_state& state,
+                      std::string_view text,
+                      size_t maxColumnCount,
+                      grapheme_cluster_receiver& receiver,
+                      codepoint_properties::tables_view const& tables) noexcept
+{
+    return probed_scan(state, text, maxColumnCount, receiver, given_tables { tables });
 }
 
 } // namespace unicode
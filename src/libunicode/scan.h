@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <libunicode/codepoint_properties.h>
 #include <libunicode/utf8.h>
 
 #include <string_view>
@@ -83,6 +84,11 @@ namespace detail
                                        std::string_view text,
                                        size_t maxColumnCount,
                                        grapheme_cluster_receiver& receiver) noexcept;
+    scan_result scan_for_text_nonascii(scan_state& state,
+                                       std::string_view text,
+                                       size_t maxColumnCount,
+                                       grapheme_cluster_receiver& receiver,
+                                       codepoint_properties::tables_view const& tables) noexcept;
 } // namespace detail
 
 /// Scans a sequence of UTF-8 encoded bytes.
@@ -109,4 +115,17 @@ scan_result scan_text(scan_state& state,
                       size_t maxColumnCount,
                       grapheme_cluster_receiver& receiver) noexcept;
 
+/// Scans a sequence of UTF-8 encoded bytes the same way as above, but with widths and grapheme cluster
+/// boundaries according to the given tables, such as those of a specific Unicode version (see codepoint_versions).
+scan_result scan_text(scan_state& state,
+                      std::string_view text,
+                      size_t maxColumnCount,
+                      codepoint_properties::tables_view const& tables) noexcept;
+
+scan_result scan_text(scan_state& state,
+                      std::string_view text,
+                      size_t maxColumnCount,
+                      grapheme_cluster_receiver& receiver,
+                      codepoint_properties::tables_view const& tables) noexcept;
+
 } // namespace unicode
@@ -13,6 +13,8 @@
  */
 #pragma once
 
+#include <libunicode/profiler.h>
+
 #include <chrono>
 #include <ostream>
 #include <string>
@@ -20,10 +22,13 @@
 namespace support
 {
 
+/// Prints the time a scope took as "message ... N ms" to @p output (if not null),
+/// and records it as a profiler scope (if the profiler is enabled).
 class scoped_timer
 {
   public:
     scoped_timer(std::ostream* output, std::string message):
+        _scope { message },
         _start { std::chrono::steady_clock::now() }, _output { output }, _message { std::move(message) }
     {
         if (_output)
@@ -44,6 +49,7 @@ class scoped_timer
     }
 
   private:
+    profiler::scope _scope;
     std::chrono::time_point<std::chrono::steady_clock> _start;
     std::ostream* _output;
     std::string _message;
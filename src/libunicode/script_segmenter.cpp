@@ -11,6 +11,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <libunicode/instrumentation.h>
 #include <libunicode/script_segmenter.h>
 #include <libunicode/ucd.h>
 
@@ -37,29 +38,44 @@ namespace
 
 optional<script_segmenter::result> script_segmenter::consume()
 {
-    if (offset_ >= size_)
+    if (offset_ >= size_ && !runPending_)
         return nullopt;
 
     while (offset_ < size_)
     {
-        ScriptSet const nextScriptSet = getScriptsFor(currentChar());
-
-        if (!mergeSets(nextScriptSet, currentScriptSet_))
+        auto const script = process(currentChar());
+        offset_++;
+        if (script.has_value())
         {
-            // If merging failed, then we have found a script segmeent boundary.
-            auto const res = result { resolveScript(), offset_ };
-            currentScriptSet_ = nextScriptSet;
-            return res;
+            // The current codepoint starts the next script run and has been processed already.
+            runPending_ = true;
+            return result { script.value(), offset_ - 1 };
         }
-
-        offset_++;
     }
 
     auto const res = result { resolveScript(), offset_ };
     currentScriptSet_.clear();
+    runPending_ = false;
+    instrumentation::count(instrumentation::counter::script_runs);
     return res;
 }
 
+optional<Script> script_segmenter::process(char32_t codepoint)
+{
+    instrumentation::count(instrumentation::counter::script_codepoints);
+    ScriptSet const nextScriptSet = getScriptsFor(codepoint);
+
+    if (mergeSets(nextScriptSet, currentScriptSet_))
+        return nullopt;
+
+    // If merging failed, then we have found a script segmeent boundary.
+    instrumentation::count(instrumentation::counter::script_runs);
+    auto const script = resolveScript();
+    currentScriptSet_ = nextScriptSet;
+    mergeSets(nextScriptSet, currentScriptSet_);
+    return script;
+}
+
 bool script_segmenter::mergeSets(ScriptSet const& nextSet, ScriptSet& currentSet)
 {
     if (nextSet.empty() || currentSet.empty())
@@ -52,6 +52,16 @@ class script_segmenter
 
     std::optional<result> consume();
 
+    /// Incrementally feeds the next codepoint into the current script run,
+    /// independently of the data this segmenter was constructed with.
+    ///
+    /// @return the resolved script of the run that ended right before @p codepoint,
+    ///         or std::nullopt if @p codepoint continues the current run.
+    std::optional<Script> process(char32_t codepoint);
+
+    /// Returns the resolved script of the current script run.
+    [[nodiscard]] constexpr Script current_script() const noexcept { return resolveScript(); }
+
     using property_type = Script;
 
     bool consume(out<size_t> size, out<Script> script)
@@ -109,6 +119,7 @@ class script_segmenter
 
     ScriptSet currentScriptSet_ {};
     Script commonPreferredScript_ = Script::Common;
+    bool runPending_ = false; // whether consume() has processed the first codepoint of the next run already
 };
 
 } // namespace unicode
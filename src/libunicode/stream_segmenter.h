@@ -0,0 +1,253 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/generator.h>
+#include <libunicode/utf8.h>
+#include <libunicode/views.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace unicode
+{
+
+/// Segments UTF-8 text that arrives in arbitrary chunks (such as from a network socket),
+/// yielding each segment as soon as it is complete.
+///
+/// All segmentation state (an incomplete UTF-8 sequence, the segmentation rules' state) is carried
+/// from one chunk to the next. Segments lying within a single chunk are yielded as views into that chunk,
+/// only the bytes of the segment that is still open at the end of a chunk are retained.
+/// Segments exceeding the maximum segment size are split, bounding the retained memory.
+///
+/// Ill-formed UTF-8 sequences are segmented as U+FFFD, one for each maximal subpart, as with views::utf8_decode.
+///
+/// @code
+/// auto segmenter = unicode::grapheme_stream_segmenter {};
+/// while (auto const chunk = receive())
+///     for (std::string_view const cluster: segmenter.feed(chunk))
+///         ...
+/// for (std::string_view const cluster: segmenter.finish())
+///     ...
+/// @endcode
+template <typename Policy>
+class basic_stream_segmenter
+{
+  public:
+    using value_type = decltype(std::declval<Policy const&>().value(std::string_view {}));
+
+    /// @param maxSegmentSize maximum size of a segment in bytes, with longer segments being split.
+    explicit basic_stream_segmenter(size_t maxSegmentSize = 4096): _maxSegmentSize { std::max(maxSegmentSize, size_t { 4 }) }
+    {
+    }
+
+    /// Segments the next chunk of input, yielding all segments that are completed by it.
+    ///
+    /// The chunk must be kept alive while iterating, and the returned generator must be exhausted
+    /// before feeding the next chunk. Yielded segments spanning multiple chunks refer to internal storage
+    /// and are only valid until the generator is resumed.
+    generator<value_type> feed(std::string_view chunk);
+
+    /// Marks the end of input, yielding the last segment, if any, and resets the segmenter.
+    generator<value_type> finish();
+
+    /// Returns the number of bytes retained from previous chunks,
+    /// i.e. less than the maximum segment size plus an incomplete UTF-8 sequence.
+    [[nodiscard]] size_t buffered_size() const noexcept { return _carry.size(); }
+
+  private:
+    static constexpr auto ReplacementChar = char32_t { 0xFFFD };
+
+    struct decoded_codepoint
+    {
+        char32_t value;
+        std::ptrdiff_t start; // offset of the codepoint's first byte, relative to chunk
+        std::ptrdiff_t end;   // offset behind the codepoint's last byte, relative to chunk
+    };
+
+    // Codepoints completed by a single byte.
+    // Up to two, if the byte cuts short an ill-formed sequence and is a codepoint on its own.
+    struct decoded_codepoints
+    {
+        decoded_codepoint codepoints[2];
+        size_t count = 0;
+    };
+
+    // Incrementally decodes UTF-8 the same way as views::utf8_decode does.
+    decoded_codepoints decode(uint8_t byte, std::ptrdiff_t position) noexcept;
+
+    // Processes the given codepoint, returning the segment it completes, if any.
+    std::optional<value_type> process(decoded_codepoint codepoint, std::string_view chunk);
+
+    // Returns the bytes from the current segment's start up to the given offset (relative to chunk).
+    std::string_view text(std::ptrdiff_t end, std::string_view chunk);
+
+    // Drops the bytes of the segment that has just been yielded.
+    void release();
+
+    Policy _policy {};
+    detail::utf8_sequence_decoder _decoder {}; // the partially decoded codepoint
+    bool _started = false;
+
+    // Start offsets of the current segment and codepoint, relative to the current chunk.
+    // They are negative if the segment or codepoint started in a previous chunk.
+    std::ptrdiff_t _segmentStart = 0;
+    std::ptrdiff_t _codepointStart = 0;
+    std::ptrdiff_t _nextSegmentStart = 0;
+
+    // Bytes of the current segment that were received with previous chunks, i.e. starting at _segmentStart.
+    std::string _carry;
+    size_t _maxSegmentSize;
+};
+
+/// Streaming grapheme cluster segmentation, yielding the UTF-8 bytes of each grapheme cluster.
+using grapheme_stream_segmenter = basic_stream_segmenter<detail::grapheme_boundaries>;
+
+/// Streaming script segmentation, yielding each script_run along with its UTF-8 bytes.
+using script_stream_segmenter = basic_stream_segmenter<detail::script_boundaries>;
+
+// {{{ implementation
+template <typename Policy>
+generator<typename basic_stream_segmenter<Policy>::value_type> basic_stream_segmenter<Policy>::feed(std::string_view chunk)
+{
+    for (size_t i = 0; i < chunk.size(); ++i)
+    {
+        auto const decoded = decode(static_cast<uint8_t>(chunk[i]), static_cast<std::ptrdiff_t>(i));
+        for (size_t k = 0; k < decoded.count; ++k)
+        {
+            if (auto const segment = process(decoded.codepoints[k], chunk); segment.has_value())
+            {
+                co_yield segment.value();
+                release();
+            }
+        }
+    }
+
+    // Retain the bytes of the still open segment.
+    if (_segmentStart >= 0)
+        _carry.assign(chunk.substr(static_cast<size_t>(_segmentStart)));
+    else
+        _carry.append(chunk);
+    _segmentStart -= static_cast<std::ptrdiff_t>(chunk.size());
+    _codepointStart -= static_cast<std::ptrdiff_t>(chunk.size());
+}
+
+template <typename Policy>
+generator<typename basic_stream_segmenter<Policy>::value_type> basic_stream_segmenter<Policy>::finish()
+{
+    if (_decoder.pending)
+    {
+        // Incomplete UTF-8 sequence at the end of input.
+        _decoder = {};
+        if (auto const segment = process({ ReplacementChar, _codepointStart, 0 }, {}); segment.has_value())
+        {
+            co_yield segment.value();
+            release();
+        }
+    }
+
+    if (_started)
+    {
+        _policy.finish();
+        auto const segment = _policy.value(std::string_view(_carry));
+        co_yield segment;
+    }
+
+    _policy = {};
+    _started = false;
+    _segmentStart = 0;
+    _codepointStart = 0;
+    _carry.clear();
+}
+
+template <typename Policy>
+auto basic_stream_segmenter<Policy>::decode(uint8_t byte, std::ptrdiff_t position) noexcept -> decoded_codepoints
+{
+    auto result = decoded_codepoints {};
+
+    if (_decoder.pending)
+    {
+        if (_decoder.next(byte))
+        {
+            if (!_decoder.pending)
+                result.codepoints[result.count++] = { _decoder.codepoint, _codepointStart, position + 1 };
+            return result;
+        }
+        // Ill-formed sequence, cut short by this byte.
+        result.codepoints[result.count++] = { ReplacementChar, _codepointStart, position };
+    }
+
+    _codepointStart = position;
+    if (!_decoder.start(byte))
+        result.codepoints[result.count++] = { ReplacementChar, position, position + 1 };
+    else if (!_decoder.pending)
+        result.codepoints[result.count++] = { _decoder.codepoint, position, position + 1 };
+    return result;
+}
+
+template <typename Policy>
+auto basic_stream_segmenter<Policy>::process(decoded_codepoint codepoint, std::string_view chunk)
+    -> std::optional<value_type>
+{
+    if (!_started)
+    {
+        _policy.start(codepoint.value);
+        _started = true;
+        return std::nullopt;
+    }
+
+    if (static_cast<size_t>(codepoint.end - _segmentStart) > _maxSegmentSize)
+        _policy.finish(); // Forcibly split overly long segments.
+    else if (!_policy.breaks(codepoint.value))
+        return std::nullopt;
+
+    auto segment = _policy.value(text(codepoint.start, chunk));
+    _nextSegmentStart = codepoint.start;
+    _policy.start(codepoint.value);
+    return segment;
+}
+
+template <typename Policy>
+std::string_view basic_stream_segmenter<Policy>::text(std::ptrdiff_t end, std::string_view chunk)
+{
+    if (_segmentStart >= 0)
+        return chunk.substr(static_cast<size_t>(_segmentStart), static_cast<size_t>(end - _segmentStart));
+
+    if (end <= 0)
+        return std::string_view(_carry).substr(0, static_cast<size_t>(end - _segmentStart));
+
+    _carry.append(chunk.substr(0, static_cast<size_t>(end)));
+    return _carry;
+}
+
+template <typename Policy>
+void basic_stream_segmenter<Policy>::release()
+{
+    if (_segmentStart < 0)
+    {
+        if (_nextSegmentStart <= 0)
+            _carry.erase(0, static_cast<size_t>(_nextSegmentStart - _segmentStart));
+        else
+            _carry.clear();
+    }
+    _segmentStart = _nextSegmentStart;
+}
+// }}}
+
+} // namespace unicode
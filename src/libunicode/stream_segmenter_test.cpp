@@ -0,0 +1,197 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/convert.h>
+#include <libunicode/stream_segmenter.h>
+#include <libunicode/views.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using std::string_view;
+using std::u32string;
+using std::vector;
+
+using namespace std::string_view_literals;
+
+namespace views = unicode::views;
+
+namespace
+{
+auto const sample = "X\xF0\x9F\xA4\xA6\xF0\x9F\x8F\xBC\xE2\x80\x8D\xE2\x99\x82\xEF\xB8\x8F"
+                    "5\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA"
+                    "e\xCC\x81 \xCE\xBB \xE5\x90\x88\xE6\xB0\x97 \xC3"
+                    "a\x80"
+                    "\xE2\x82"sv;
+
+u32string decode(string_view text)
+{
+    auto result = u32string {};
+    for (char32_t const codepoint: text | views::utf8_decode)
+        result += codepoint;
+    return result;
+}
+
+template <typename Segmenter>
+auto segment_chunks(Segmenter& segmenter, vector<string_view> const& chunks)
+{
+    auto result = vector<std::pair<u32string, int>> {};
+    auto const append = [&](auto const& segment) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(segment)>, string_view>)
+            result.emplace_back(decode(segment), 0);
+        else
+            result.emplace_back(decode(segment.text), static_cast<int>(segment.script));
+    };
+    for (auto const chunk: chunks)
+        for (auto const& segment: segmenter.feed(chunk))
+            append(segment);
+    for (auto const& segment: segmenter.finish())
+        append(segment);
+    return result;
+}
+
+vector<std::pair<u32string, int>> expected_graphemes(string_view text)
+{
+    auto result = vector<std::pair<u32string, int>> {};
+    for (auto const cluster: text | views::utf8_decode | views::graphemes)
+        result.emplace_back(u32string(cluster.begin(), cluster.end()), 0);
+    return result;
+}
+} // namespace
+
+TEST_CASE("stream_segmenter.graphemes")
+{
+    auto const expected = expected_graphemes(sample);
+    REQUIRE(expected.size() == 15);
+
+    auto segmenter = unicode::grapheme_stream_segmenter {};
+    CHECK(segment_chunks(segmenter, { sample }) == expected);
+
+    // Split at any position, including within UTF-8 sequences.
+    for (size_t i = 0; i <= sample.size(); ++i)
+    {
+        INFO("split at " << i);
+        CHECK(segment_chunks(segmenter, { sample.substr(0, i), sample.substr(i) }) == expected);
+        CHECK(segmenter.buffered_size() == 0);
+    }
+
+    // Byte by byte.
+    auto bytes = vector<string_view> {};
+    for (size_t i = 0; i < sample.size(); ++i)
+        bytes.emplace_back(sample.substr(i, 1));
+    CHECK(segment_chunks(segmenter, bytes) == expected);
+
+    CHECK(segment_chunks(segmenter, {}).empty());
+    CHECK(segment_chunks(segmenter, { ""sv, ""sv }).empty());
+}
+
+TEST_CASE("stream_segmenter.ill_formed")
+{
+    // Overlong encodings, surrogates, codepoints above U+10FFFF and invalid lead bytes,
+    // as in the invalid UTF-8 corpus, each decoded as one U+FFFD per maximal subpart.
+    auto const text = "a\xC0\xAF" "b\xE0\x80\xAF" "c\xF0\x80\x80\xAF" "d\xED\xA0\x80" "e\xF4\x90\x80\x80"
+                      "f\xF5\x80\x80\x80" "g\xF7\xBF\xBF\xBF" "h\xED\x9F\xBF\xF4\x8F\xBF\xBF\xF0\x9F\x98"sv;
+    auto const expected = expected_graphemes(text);
+
+    auto replacements = size_t { 0 };
+    for (auto const& segment: expected)
+        replacements += static_cast<size_t>(std::ranges::count(segment.first, U'\uFFFD'));
+    REQUIRE(replacements == 2 + 3 + 4 + 3 + 4 + 4 + 4 + 1);
+
+    // Split at any position, including within (ill-formed) UTF-8 sequences.
+    auto segmenter = unicode::grapheme_stream_segmenter {};
+    for (size_t i = 0; i <= text.size(); ++i)
+    {
+        INFO("split at " << i);
+        CHECK(segment_chunks(segmenter, { text.substr(0, i), text.substr(i) }) == expected);
+    }
+
+    auto bytes = vector<string_view> {};
+    for (size_t i = 0; i < text.size(); ++i)
+        bytes.emplace_back(text.substr(i, 1));
+    CHECK(segment_chunks(segmenter, bytes) == expected);
+}
+
+TEST_CASE("stream_segmenter.zero_copy")
+{
+    // Segments within a single chunk are views into that chunk.
+    auto const chunk = "ab\xC3"sv;
+    auto segmenter = unicode::grapheme_stream_segmenter {};
+    auto segments = vector<string_view> {};
+    for (auto const segment: segmenter.feed(chunk))
+        segments.push_back(segment);
+    REQUIRE(segments.size() == 1);
+    CHECK(segments[0].data() == chunk.data());
+    CHECK(segmenter.buffered_size() == 2);
+
+    // Segments spanning chunks refer to internal storage, only valid until resuming.
+    auto copies = vector<std::string> {};
+    for (auto const segment: segmenter.feed("\xA9"sv))
+        copies.emplace_back(segment);
+    CHECK(copies == vector<std::string> { "b" });
+    CHECK(segmenter.buffered_size() == 2);
+}
+
+TEST_CASE("stream_segmenter.script_runs")
+{
+    auto const text = "\xCE\xBB \xE5\x90\x88\xE6\xB0\x97\xE9\x81\x93 \xCE\xBB;"sv;
+
+    auto expected = vector<std::pair<u32string, int>> {};
+    auto const text32 = unicode::convert_to<char32_t>(text);
+    for (auto const& run: std::u32string_view(text32) | views::script_runs)
+        expected.emplace_back(u32string(run.text.begin(), run.text.end()), static_cast<int>(run.script));
+    REQUIRE(expected.size() == 3);
+
+    auto segmenter = unicode::script_stream_segmenter {};
+    for (size_t i = 0; i <= text.size(); ++i)
+    {
+        INFO("split at " << i);
+        CHECK(segment_chunks(segmenter, { text.substr(0, i), text.substr(i) }) == expected);
+    }
+}
+
+TEST_CASE("stream_segmenter.bounded")
+{
+    // An endless grapheme cluster gets split once exceeding the maximum segment size.
+    auto const combining = "\xCC\x81"sv;
+    auto segmenter = unicode::grapheme_stream_segmenter { 16 };
+    auto sizes = vector<size_t> {};
+    size_t maxBuffered = 0;
+    for (auto const segment: segmenter.feed("e"sv))
+        sizes.push_back(segment.size());
+    for (int i = 0; i < 100; ++i)
+    {
+        for (auto const segment: segmenter.feed(combining.substr(0, 1)))
+            sizes.push_back(segment.size());
+        for (auto const segment: segmenter.feed(combining.substr(1)))
+            sizes.push_back(segment.size());
+        maxBuffered = std::max(maxBuffered, segmenter.buffered_size());
+    }
+    for (auto const segment: segmenter.finish())
+        sizes.push_back(segment.size());
+
+    CHECK(maxBuffered <= 16 + 3);
+    size_t total = 0;
+    for (auto const size: sizes)
+    {
+        CHECK(size <= 16);
+        total += size;
+    }
+    CHECK(total == 201);
+}
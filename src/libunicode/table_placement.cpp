@@ -0,0 +1,181 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/table_placement.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// clang-format off
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBUNICODE_TABLE_PLACEMENT_MMAP 1
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+// clang-format on
+
+namespace unicode
+{
+
+namespace
+{
+    using tables_view = codepoint_properties::tables_view;
+
+    auto constexpr BlockCount = (0x10FFFF + 1) / tables_view::block_size;
+    auto constexpr HugePageSize = size_t { 2 * 1024 * 1024 };
+    auto constexpr CacheLineSize = size_t { 64 };
+
+    // A table's address range.
+    struct table_range
+    {
+        void const* data;
+        size_t size;
+    };
+
+    // Returns the address ranges of the tables, as far as they are referenced.
+    std::array<table_range, 3> table_ranges(tables_view const& tables) noexcept
+    {
+        auto const blockCount = size_t { *std::max_element(tables.stage1, tables.stage1 + BlockCount) } + 1;
+        auto const stage2Size = blockCount * tables_view::block_size;
+        auto const propertyCount = size_t { *std::max_element(tables.stage2, tables.stage2 + stage2Size) } + 1;
+        return { {
+            { tables.stage1, BlockCount * sizeof(tables_view::stage1_element_type) },
+            { tables.stage2, stage2Size * sizeof(tables_view::stage2_element_type) },
+            { tables.stage3, propertyCount * sizeof(codepoint_properties) },
+        } };
+    }
+
+    size_t page_size() noexcept
+    {
+#if defined(LIBUNICODE_TABLE_PLACEMENT_MMAP)
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+    // Faults in all pages of the given address range.
+    void prefault(table_range range) noexcept
+    {
+        auto const pageSize = page_size();
+        auto const begin = reinterpret_cast<uintptr_t>(range.data) & ~(pageSize - 1);
+        auto const end = reinterpret_cast<uintptr_t>(range.data) + range.size;
+#if defined(LIBUNICODE_TABLE_PLACEMENT_MMAP) && defined(MADV_POPULATE_READ)
+        if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_POPULATE_READ) == 0)
+            return;
+#endif
+        for (auto page = begin; page < end; page += pageSize)
+            (void) *reinterpret_cast<char const volatile*>(std::max(page, reinterpret_cast<uintptr_t>(range.data)));
+    }
+
+#if defined(LIBUNICODE_TABLE_PLACEMENT_MMAP)
+    // Maps a read-write region of the given size (a multiple of HugePageSize), aligned to HugePageSize,
+    // and backed by huge pages where available.
+    char* map_huge_pages(size_t size) noexcept
+    {
+        auto constexpr Protection = PROT_READ | PROT_WRITE;
+    #if defined(MAP_HUGETLB)
+        // Reserved huge pages (see /proc/sys/vm/nr_hugepages).
+        auto const hugetlb = mmap(nullptr, size, Protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (hugetlb != MAP_FAILED)
+            return static_cast<char*>(hugetlb);
+    #endif
+
+        // Transparent huge pages, which require the region to be aligned.
+        auto const reserved = mmap(nullptr, size + HugePageSize, Protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED)
+            return nullptr;
+        auto const start = reinterpret_cast<uintptr_t>(reserved);
+        auto const aligned = (start + HugePageSize - 1) & ~(HugePageSize - 1);
+        if (aligned != start)
+            munmap(reserved, aligned - start);
+        if (auto const tail = start + size + HugePageSize - (aligned + size); tail != 0)
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+    #if defined(MADV_HUGEPAGE)
+        madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+    #endif
+        return reinterpret_cast<char*>(aligned);
+    }
+#endif
+} // namespace
+
+std::shared_ptr<codepoint_properties::table_set const> place_tables(
+    table_placement placement, std::shared_ptr<codepoint_properties::table_set const> base)
+{
+    if (!base)
+    {
+        base = std::make_shared<codepoint_properties::table_set const>(
+            codepoint_properties::table_set { codepoint_properties::configured_tables, {} });
+    }
+
+    auto const ranges = table_ranges(base->properties);
+
+#if defined(LIBUNICODE_TABLE_PLACEMENT_MMAP)
+    if (placement == table_placement::huge_pages)
+    {
+        // The tables, one after another, each starting at a cache line.
+        auto offsets = std::array<size_t, 3> {};
+        auto size = size_t { 0 };
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            offsets[i] = size;
+            size += (ranges[i].size + CacheLineSize - 1) & ~(CacheLineSize - 1);
+        }
+        size = (size + HugePageSize - 1) & ~(HugePageSize - 1);
+
+        struct placed_tables
+        {
+            std::shared_ptr<codepoint_properties::table_set const> base; // for the names
+            char* region = nullptr;
+            size_t size = 0;
+            codepoint_properties::table_set tables {};
+
+            ~placed_tables()
+            {
+                if (region)
+                    munmap(region, size);
+            }
+        };
+        auto placed = std::make_shared<placed_tables>();
+        if (auto const region = map_huge_pages(size))
+        {
+            placed->base = base;
+            placed->region = region;
+            placed->size = size;
+            for (size_t i = 0; i < ranges.size(); ++i)
+                std::memcpy(region + offsets[i], ranges[i].data, ranges[i].size);
+            mprotect(region, size, PROT_READ);
+
+            placed->tables = codepoint_properties::table_set {
+                tables_view {
+                    reinterpret_cast<tables_view::stage1_element_type const*>(region + offsets[0]),
+                    reinterpret_cast<tables_view::stage2_element_type const*>(region + offsets[1]),
+                    reinterpret_cast<codepoint_properties const*>(region + offsets[2]),
+                },
+                base->names,
+            };
+            return std::shared_ptr<codepoint_properties::table_set const>(placed, &placed->tables);
+        }
+    }
+#else
+    (void) placement;
+#endif
+
+    for (auto const& range: ranges)
+        prefault(range);
+    return base;
+}
+
+} // namespace unicode
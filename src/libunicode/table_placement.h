@@ -0,0 +1,50 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/codepoint_properties.h>
+
+#include <memory>
+
+namespace unicode
+{
+
+/// How place_tables() places the codepoint properties tables in memory.
+enum class table_placement
+{
+    /// Keeps the tables where they are, but faults in all of their pages up front.
+    prefault,
+
+    /// Copies the tables into a 2 MiB aligned region, backed by a huge page where available
+    /// (reserved huge pages, or else transparent huge pages), with all pages faulted in up front.
+    huge_pages,
+};
+
+/// Places the codepoint properties tables of @p base, or of the configured tables if nullptr,
+/// such that the first lookups neither page-fault nor miss the TLB more than necessary,
+/// e.g. for a terminal to render its first screen without delay.
+///
+/// This is opt-in, as it costs the time to fault in all pages (and to copy the tables) at once,
+/// and up to 2 MiB of memory. The names are left as they are.
+///
+/// @code
+/// codepoint_properties::publish(place_tables(table_placement::huge_pages));
+/// @endcode
+///
+/// @returns the placed tables, to be published via codepoint_properties::publish().
+///          Falls back to prefaulting where the tables cannot be copied into a huge page.
+[[nodiscard]] std::shared_ptr<codepoint_properties::table_set const> place_tables(
+    table_placement placement, std::shared_ptr<codepoint_properties::table_set const> base = nullptr);
+
+} // namespace unicode
@@ -0,0 +1,54 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/codepoint_overlay.h>
+#include <libunicode/table_placement.h>
+#include <libunicode/test_support.h>
+#include <libunicode/width.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using unicode::codepoint_properties;
+using unicode::table_placement;
+using unicode::test::same_tables;
+
+TEST_CASE("table_placement.prefault")
+{
+    auto const tables = unicode::place_tables(table_placement::prefault);
+    REQUIRE(tables);
+    CHECK(tables->properties.stage3 == codepoint_properties::configured_tables.stage3);
+}
+
+TEST_CASE("table_placement.huge_pages")
+{
+    auto const tables = unicode::place_tables(table_placement::huge_pages);
+    REQUIRE(tables);
+    CHECK(same_tables(tables->properties, codepoint_properties::configured_tables));
+
+    codepoint_properties::publish(tables);
+    CHECK(unicode::width(U'A') == 1);
+    CHECK(unicode::width(0x1F600) == 2);
+#if !defined(LIBUNICODE_NO_NAMES)
+    CHECK(codepoint_properties::name(U'A') == "LATIN CAPITAL LETTER A");
+#endif
+    codepoint_properties::publish(nullptr);
+    CHECK(codepoint_properties::reclaim() == 0);
+}
+
+TEST_CASE("table_placement.base")
+{
+    auto const overlay = unicode::codepoint_overlay {}.set_width(0xE000, 0xF8FF, 2).build();
+    auto const tables = unicode::place_tables(table_placement::huge_pages, overlay);
+    CHECK(same_tables(tables->properties, overlay->properties));
+    CHECK(tables->properties.get(0xE000).char_width == 2);
+}
@@ -13,16 +13,26 @@
  */
 #include <libunicode/codepoint_properties.h>
 #include <libunicode/codepoint_properties_loader.h>
+#include <libunicode/profiler.h>
 #include <libunicode/scoped_timer.h>
 #include <libunicode/ucd_ostream.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <ios>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 using namespace std::string_literals;
+using namespace std::string_view_literals;
 
 namespace
 {
@@ -37,26 +47,29 @@ std::string binstr(uint32_t n)
     return ss;
 }
 
+// Returns the name of the table's element type, as the generated tables must match the table views' types.
 template <typename T>
-std::string_view minimum_uint_t(std::vector<T> const& values)
+constexpr std::string_view uint_type_name() noexcept
 {
-    auto const v = std::max_element(values.begin(), values.end());
-    if (*v <= 0xFF)
+    static_assert(std::is_unsigned_v<T> && sizeof(T) <= 8);
+    if constexpr (sizeof(T) == 1)
         return "uint8_t";
-    if (*v <= 0xFFFF)
+    else if constexpr (sizeof(T) == 2)
         return "uint16_t";
-    if (*v <= 0xFFFFFFFF)
+    else if constexpr (sizeof(T) == 4)
         return "uint32_t";
-    return "uint64_t";
+    else
+        return "uint64_t";
 }
 
 template <typename T>
 void write_cxx_table(
     std::ostream& header, std::ostream& implementation, std::vector<T> const& table, std::string_view name, bool commentOnBlock)
 {
+    auto const _ = support::profiler::scope { name };
     auto constexpr ColumnCount = 16;
 
-    auto const elementTypeName = minimum_uint_t(table);
+    auto constexpr elementTypeName = uint_type_name<T>();
 
     header << "extern std::array<" << elementTypeName << ", " << table.size() << "> const " << name << ";\n";
     implementation << "std::array<" << elementTypeName << ", " << table.size() << "> const " << name << " {";
@@ -73,11 +86,15 @@ void write_cxx_table(
     implementation << "\n};\n\n";
 }
 
+// With @p minimal, only the properties kept by minimal_tables() are written, as designated initializers,
+// so that the output compiles with LIBUNICODE_MINIMAL_TABLES, which omits the other properties.
 void write_cxx_properties_table(std::ostream& header,
                                 std::ostream& implementation,
                                 std::vector<unicode::codepoint_properties> const& propertiesTable,
-                                std::string_view tableName)
+                                std::string_view tableName,
+                                bool minimal)
 {
+    auto const _ = support::profiler::scope { tableName };
     using namespace unicode;
     header << "extern std::array<codepoint_properties, " << propertiesTable.size() << "> const " << tableName << ";\n";
     implementation << "std::array<codepoint_properties, " << propertiesTable.size() << "> const " << tableName << "{{\n";
@@ -85,6 +102,15 @@ void write_cxx_properties_table(std::ostream& header,
     {
         // clang-format off
         auto const& properties = propertiesTable[i];
+        if (minimal)
+        {
+            implementation << "    {"
+                           << ".char_width = " << static_cast<unsigned>(properties.char_width) << ", "
+                           << ".flags = " << (!properties.flags ? "0"s : binstr(properties.flags)) << ", "
+                           << ".grapheme_cluster_break = Grapheme_Cluster_Break::" << properties.grapheme_cluster_break
+                           << "},\n";
+            continue;
+        }
         implementation << "    {"
                        << static_cast<unsigned>(properties.char_width) << ", "
                        << (!properties.flags ? "0"s : binstr(properties.flags)) << ", "
@@ -100,25 +126,63 @@ void write_cxx_properties_table(std::ostream& header,
     implementation << "}};\n\n";
 }
 
-void write_cxx_properties_table(std::ostream& header,
-                                std::ostream& implementation,
-                                std::vector<std::string> const& propertiesTable,
-                                std::string_view tableName)
+// Writes the names as string literal chunks along with an index, rather than an array of std::string_view,
+// which would require a relocation for each name when loading the (shared) library.
+//
+// Each index entry is composed of the name's offset within its chunk (bits 0..15), the chunk number (bits 16..23),
+// and the name's length (bits 24..31).
+void write_cxx_names_table(std::ostream& header, std::ostream& implementation, std::vector<std::string> const& names)
 {
-    using namespace unicode;
-    header << "extern std::array<std::string_view, " << propertiesTable.size() << "> const " << tableName << ";\n";
-    implementation << "std::array<std::string_view, " << propertiesTable.size() << "> const " << tableName << "{{\n";
-    for (size_t i = 0; i < propertiesTable.size(); ++i)
-        implementation << "    \"" << propertiesTable[i] << "\"sv,\n";
+    // Chunks are kept below MSVC's string literal size limit.
+    auto const _ = support::profiler::scope { "names" };
+    auto constexpr ChunkSize = size_t { 0xFFFF };
+    auto constexpr ColumnCount = 8;
+
+    auto chunks = std::vector<std::string> { std::string {} };
+    auto index = std::vector<uint32_t> {};
+    for (auto const& name: names)
+    {
+        if (name.size() > 0xFF)
+            throw std::length_error("Codepoint name too long: " + name);
+        if (chunks.back().size() + name.size() > ChunkSize)
+            chunks.emplace_back();
+        index.push_back(static_cast<uint32_t>(chunks.back().size()) | static_cast<uint32_t>((chunks.size() - 1) << 16)
+                        | static_cast<uint32_t>(name.size() << 24));
+        chunks.back() += name;
+    }
+    if (chunks.size() > 0xFF)
+        throw std::length_error("Too many codepoint names.");
+
+    header << "extern std::array<char const*, " << chunks.size() << "> const names_chunks;\n";
+    implementation << "std::array<char const*, " << chunks.size() << "> const names_chunks {{\n";
+    for (auto const& chunk: chunks)
+    {
+        implementation << (chunk.empty() ? "    \"\"" : "    ");
+        for (size_t i = 0; i < chunk.size(); i += 100)
+            implementation << "\"" << chunk.substr(i, 100) << "\"\n    ";
+        implementation << ",\n";
+    }
     implementation << "}};\n\n";
+
+    header << "extern std::array<uint32_t, " << index.size() << "> const names_stage3;\n";
+    implementation << "std::array<uint32_t, " << index.size() << "> const names_stage3 {";
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        if (i % ColumnCount == 0)
+            implementation << "\n    ";
+        implementation << "0x" << std::hex << std::setw(8) << std::setfill('0') << index[i] << std::dec << std::setfill(' ')
+                       << ',';
+    }
+    implementation << "\n};\n\n";
 }
 
 void write_cxx_tables(unicode::codepoint_properties_table const& tables,
-                      unicode::codepoint_names_table const& namesTables,
+                      unicode::codepoint_names_table const* namesTables,
                       std::ostream& header,
                       std::ostream& implementation,
                       std::ostream& namesFile,
-                      std::string_view namespaceName)
+                      std::string_view namespaceName,
+                      bool minimal)
 {
     auto const _ = support::scoped_timer(&std::cout, "Writing C++ table files");
 
@@ -151,29 +215,120 @@ void write_cxx_tables(unicode::codepoint_properties_table const& tables,
     implementation << "{\n\n";
     write_cxx_table(header, implementation, tables.stage1, "stage1", false);
     write_cxx_table(header, implementation, tables.stage2, "stage2", true);
-    write_cxx_properties_table(header, implementation, tables.stage3, "properties");
+    write_cxx_properties_table(header, implementation, tables.stage3, "properties", minimal);
     implementation << "} // end namespace " << namespaceName << "\n";
 
-    namesFile << disclaimer;
-    namesFile << "#include <libunicode/codepoint_properties_data.h>\n";
-    namesFile << "\n";
-    namesFile << "#include <array>\n";
-    namesFile << "#include <string_view>\n";
-    namesFile << "#include <cstdint>\n";
-    namesFile << "\n";
-    namesFile << "using namespace unicode;\n";
-    namesFile << "using namespace std::string_view_literals;\n";
-    namesFile << "\n";
-    namesFile << "namespace " << namespaceName << "\n";
-    namesFile << "{\n\n";
-    write_cxx_table(header, namesFile, namesTables.stage1, "names_stage1", false);
-    write_cxx_table(header, namesFile, namesTables.stage2, "names_stage2", true);
-    write_cxx_properties_table(header, namesFile, namesTables.stage3, "names_stage3");
-    namesFile << "} // end namespace " << namespaceName << "\n";
+    if (namesTables)
+    {
+        namesFile << disclaimer;
+        namesFile << "#include <libunicode/codepoint_properties_data.h>\n";
+        namesFile << "\n";
+        namesFile << "#include <array>\n";
+        namesFile << "#include <string_view>\n";
+        namesFile << "#include <cstdint>\n";
+        namesFile << "\n";
+        namesFile << "using namespace unicode;\n";
+        namesFile << "\n";
+        namesFile << "namespace " << namespaceName << "\n";
+        namesFile << "{\n\n";
+        write_cxx_table(header, namesFile, namesTables->stage1, "names_stage1", false);
+        write_cxx_table(header, namesFile, namesTables->stage2, "names_stage2", true);
+        write_cxx_names_table(header, namesFile, namesTables->stage3);
+        namesFile << "} // end namespace " << namespaceName << "\n";
+    }
 
     header << "\n} // end namespace " << namespaceName << "\n";
 }
 
+// Reduces the properties to those needed for width computation and grapheme cluster segmentation,
+// and rebuilds the tables, which deduplicate much better then.
+unicode::codepoint_properties_table minimal_tables(unicode::codepoint_properties_table const& tables)
+{
+    auto const _ = support::scoped_timer(&std::cout, "Creating minimal tables");
+
+    auto codepoints = std::vector<unicode::codepoint_properties>(unicode::codepoint_properties::tables_view::block_size
+                                                                 * tables.stage1.size());
+    for (size_t i = 0; i < codepoints.size(); ++i)
+    {
+        auto const& properties = tables.get(static_cast<uint32_t>(i));
+        codepoints[i].char_width = properties.char_width;
+        codepoints[i].flags = properties.flags & unicode::codepoint_properties::FlagExtendedPictographic;
+        codepoints[i].grapheme_cluster_break = properties.grapheme_cluster_break;
+    }
+
+    auto output = unicode::codepoint_properties_table {};
+    support::generate(codepoints.data(), codepoints.size(), output, [](auto const& begin, auto const& end, auto value) noexcept {
+        return std::find(begin, end, value);
+    });
+    return output;
+}
+
+// Codepoint frequency profile, i.e. the weight of each codepoint when laying out the tables.
+using frequency_profile = std::vector<uint64_t>;
+
+// Approximates the codepoints seen in terminal output: mostly US-ASCII, then Latin and other alphabets,
+// punctuation and box drawing, CJK and Hangul text and emoji.
+frequency_profile builtin_frequencies()
+{
+    struct range
+    {
+        char32_t first;
+        char32_t last;
+        uint64_t weight; // per codepoint
+    };
+    static auto constexpr Ranges = std::array {
+        range { 0x0000, 0x001F, 10'000 },   // C0 controls
+        range { 0x0020, 0x007E, 1'000'000 }, // US-ASCII
+        range { 0x00A0, 0x00FF, 10'000 },    // Latin-1 Supplement
+        range { 0x0100, 0x024F, 2'000 },     // Latin Extended-A and -B
+        range { 0x0300, 0x036F, 1'000 },     // Combining Diacritical Marks
+        range { 0x0370, 0x04FF, 2'000 },     // Greek and Cyrillic
+        range { 0x2000, 0x206F, 5'000 },     // General Punctuation
+        range { 0x2190, 0x21FF, 2'000 },     // Arrows
+        range { 0x2500, 0x259F, 5'000 },     // Box Drawing and Block Elements
+        range { 0x25A0, 0x27BF, 1'000 },     // Geometric Shapes, Miscellaneous Symbols and Dingbats
+        range { 0x3000, 0x30FF, 3'000 },     // CJK Symbols and Punctuation, Hiragana and Katakana
+        range { 0x4E00, 0x9FFF, 100 },       // CJK Unified Ideographs
+        range { 0xAC00, 0xD7A3, 100 },       // Hangul Syllables
+        range { 0xE000, 0xF8FF, 500 },       // Private Use Area, e.g. Powerline symbols
+        range { 0xFE00, 0xFE0F, 1'000 },     // Variation Selectors
+        range { 0xFF00, 0xFFEF, 500 },       // Halfwidth and Fullwidth Forms
+        range { 0x1F300, 0x1F64F, 500 },     // Miscellaneous Symbols and Pictographs, Emoticons
+        range { 0x1F680, 0x1F6FF, 500 },     // Transport and Map Symbols
+        range { 0x1F900, 0x1F9FF, 500 },     // Supplemental Symbols and Pictographs
+    };
+
+    auto frequencies = frequency_profile(0x110'000);
+    for (auto const& range: Ranges)
+        std::fill(frequencies.begin() + range.first, frequencies.begin() + range.last + 1, range.weight);
+    return frequencies;
+}
+
+// Loads a frequency profile, consisting of lines of the form "U+XXXX count", and comments starting with '#'.
+frequency_profile load_frequencies(std::string const& fileName)
+{
+    auto file = std::ifstream(fileName);
+    if (!file)
+        throw std::runtime_error("Could not open frequency profile: " + fileName);
+
+    auto frequencies = frequency_profile(0x110'000);
+    auto line = std::string {};
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        auto input = std::istringstream(line);
+        auto prefix = std::string(2, '\0');
+        uint32_t codepoint = 0;
+        uint64_t count = 0;
+        if (!input.read(prefix.data(), 2) || prefix != "U+" || !(input >> std::hex >> codepoint >> std::dec >> count)
+            || codepoint >= frequencies.size())
+            throw std::runtime_error("Invalid frequency profile line: " + line);
+        frequencies[codepoint] += count;
+    }
+    return frequencies;
+}
+
 char const* consumeParamterOrDefault(int& i, int argc, char const* argv[], char const* defaultValue) noexcept
 {
     if (argc > i)
@@ -184,11 +339,40 @@ char const* consumeParamterOrDefault(int& i, int argc, char const* argv[], char
 
 } // namespace
 
-// Usage: unicode_tablgen UCD_directory CPP_OUTPUTFILE NAMESPACE
+// Usage: unicode_tablgen [--minimal] [--no-names] [--frequencies=FILE] [--profile=FILE]
+//                        UCD_directory CPP_HEADER CPP_OUTPUTFILE CPP_NAMES_OUTPUTFILE NAMESPACE
+//
+// --minimal           Only emits the properties needed for width computation and grapheme cluster segmentation.
+// --no-names          Omits the codepoint names tables.
+// --frequencies=FILE  Lays out the properties tables by the given codepoint frequency profile
+//                     (as written by libunicode_benchmark --frequency-profile or uc-inspect --frequency-profile=FILE stats)
+//                     instead of the built-in one.
+// --profile=FILE      Writes the time spent per step as Chrome trace JSON to FILE, and a summary to stdout.
 int main(int argc, char const* argv[])
 {
-    // clang-format off
     int i = 1;
+    auto minimal = false;
+    auto withNames = true;
+    auto frequenciesFileName = std::string {};
+    auto profileFileName = std::string {};
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] == '-'; ++i)
+    {
+        if (argv[i] == "--minimal"sv)
+            minimal = true;
+        else if (argv[i] == "--no-names"sv)
+            withNames = false;
+        else if (std::string_view(argv[i]).starts_with("--frequencies="))
+            frequenciesFileName = argv[i] + "--frequencies="sv.size();
+        else if (std::string_view(argv[i]).starts_with("--profile="))
+            profileFileName = argv[i] + "--profile="sv.size();
+        else
+        {
+            std::cerr << "Unknown option: " << argv[i] << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    // clang-format off
     auto const ucdDataDirectory = consumeParamterOrDefault(i, argc, argv, "_ucd/ucd-15.0.0");
     auto const cxxHeaderFileName = consumeParamterOrDefault(i, argc, argv, "codepoint_properties_data.h");
     auto const cxxImplementationFileName = consumeParamterOrDefault(i, argc, argv, "codepoint_properties_data.cpp");
@@ -196,12 +380,36 @@ int main(int argc, char const* argv[])
     auto const namespaceName = consumeParamterOrDefault(i, argc, argv, "unicode::precompiled");
     // clang-format on
 
+    support::profiler::enable(!profileFileName.empty());
+
     auto headerFile = std::ofstream(cxxHeaderFileName);
     auto implementationFile = std::ofstream(cxxImplementationFileName);
-    auto namesFile = std::ofstream(cxxNamesFileName);
+    auto namesFile = withNames ? std::ofstream(cxxNamesFileName) : std::ofstream {};
     auto const [props, names] = unicode::load_from_directory(ucdDataDirectory, &std::clog);
 
-    write_cxx_tables(props, names, headerFile, implementationFile, namesFile, namespaceName);
+    auto tables = minimal ? minimal_tables(props) : props;
+    {
+        auto const _ = support::scoped_timer(&std::cout, "Reordering tables by codepoint frequency");
+        auto const frequencies = frequenciesFileName.empty() ? builtin_frequencies() : load_frequencies(frequenciesFileName);
+        support::reorder(tables, [&](uint32_t codepoint) { return frequencies[codepoint]; });
+    }
+
+    write_cxx_tables(tables,
+                     withNames ? &names : nullptr,
+                     headerFile,
+                     implementationFile,
+                     namesFile,
+                     namespaceName,
+                     minimal);
+
+    if (!profileFileName.empty())
+    {
+        auto profileFile = std::ofstream(profileFileName);
+        if (!profileFile)
+            throw std::runtime_error("Could not write profile: " + profileFileName);
+        support::profiler::write_chrome_trace(profileFile);
+        support::profiler::write_summary(std::cout);
+    }
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,32 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/codepoint_properties.h>
+
+// Helpers shared by the unit tests.
+
+namespace unicode::test
+{
+
+/// Tests whether both tables hold the same properties for every codepoint.
+inline bool same_tables(codepoint_properties::tables_view const& a, codepoint_properties::tables_view const& b)
+{
+    for (char32_t codepoint = 0; codepoint <= 0x10FFFF; ++codepoint)
+        if (a.get(codepoint) != b.get(codepoint))
+            return false;
+    return true;
+}
+
+} // namespace unicode::test
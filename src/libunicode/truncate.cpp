@@ -0,0 +1,301 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/scan.h>
+#include <libunicode/truncate.h>
+#include <libunicode/utf8.h>
+#include <libunicode/width.h>
+
+#include <algorithm>
+#include <limits>
+
+using std::max;
+using std::min;
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    auto constexpr ReplacementCharacter = char32_t { 0xFFFD };
+    auto constexpr VS16 = char32_t { 0xFE0F };
+    auto constexpr Unlimited = std::numeric_limits<size_t>::max();
+
+    // Tests if given UTF-8 byte is a single US-ASCII text codepoint. This excludes control characters.
+    constexpr bool is_ascii_text(char ch) noexcept
+    {
+        return static_cast<uint8_t>(ch) >= 0x20 && static_cast<uint8_t>(ch) < 0x80;
+    }
+
+    constexpr bool is_continuation(char ch) noexcept
+    {
+        return (static_cast<uint8_t>(ch) & 0b1100'0000) == 0b1000'0000;
+    }
+
+    constexpr bool is_regional_indicator(char32_t codepoint) noexcept
+    {
+        return 0x1F1E6 <= codepoint && codepoint <= 0x1F1FF;
+    }
+
+    // Decodes the codepoint starting at @p input and moves @p input behind it.
+    // Invalid or incomplete UTF-8 sequences are decoded as U+FFFD, consuming their maximal subpart.
+    char32_t decode_next(char const*& input, char const* end) noexcept
+    {
+        return detail::decode_utf8_sequence(input, end).value_or(ReplacementCharacter);
+    }
+
+    // Decodes the codepoint ending right before @p input and moves @p input to its first byte.
+    char32_t decode_previous(char const*& input, char const* begin) noexcept
+    {
+        auto const end = input;
+        auto start = input - 1;
+        while (start != begin && is_continuation(*start) && end - start < 4)
+            --start;
+
+        auto cursor = start;
+        auto const codepoint = decode_next(cursor, end);
+        if (cursor != end)
+        {
+            // Not a well-formed sequence, consume only the last byte.
+            input = end - 1;
+            return ReplacementCharacter;
+        }
+
+        input = start;
+        return codepoint;
+    }
+
+    struct forward_result
+    {
+        char const* cut;   // end of the longest prefix that fits into the given budget
+        size_t cutColumns; // number of columns of that prefix
+        size_t columns;    // number of columns of the whole text (only valid if not overflowing)
+        bool overflow;     // whether or not the text exceeds the given maximum number of columns
+    };
+
+    // Walks the text forward, cluster by cluster, tracking the longest prefix that fits into @p budget.
+    // Stops as soon as the text is known to exceed @p maxColumns.
+    forward_result scan_forward(string_view text, size_t budget, size_t maxColumns) noexcept
+    {
+        char const* input = text.data();
+        char const* const end = input + text.size();
+
+        auto result = forward_result { input, 0, 0, false };
+        auto state = grapheme_segmenter_state {};
+        size_t columns = 0;      // columns of all completed grapheme clusters
+        size_t clusterWidth = 0; // columns of the currently open grapheme cluster
+        bool clusterOpen = false;
+
+        // Completes the currently open grapheme cluster, that ends at @p boundary.
+        auto const complete = [&](char const* boundary) noexcept -> bool {
+            if (!clusterOpen)
+                return true;
+            if (columns + clusterWidth > maxColumns)
+                return false;
+            columns += clusterWidth;
+            if (columns <= budget)
+            {
+                result.cut = boundary;
+                result.cutColumns = columns;
+            }
+            return true;
+        };
+
+        while (input != end)
+        {
+            if (is_ascii_text(*input)
+                && (!clusterOpen || grapheme_process_breakable(static_cast<char32_t>(*input), state)))
+            {
+                if (!complete(input))
+                {
+                    result.overflow = true;
+                    return result;
+                }
+
+                // Every US-ASCII character is a grapheme cluster on its own, except the last one,
+                // which may still be extended by the codepoints following it.
+                auto const remaining = maxColumns - columns;
+                auto const limit = min(remaining, static_cast<size_t>(end - input)) + 2;
+                auto const count = detail::scan_for_text_ascii(string_view(input, static_cast<size_t>(end - input)), limit);
+                auto const completed = count - 1;
+
+                if (budget > columns)
+                {
+                    auto const fitting = min(budget - columns, completed);
+                    result.cut = input + fitting;
+                    result.cutColumns = columns + fitting;
+                }
+
+                if (completed > remaining)
+                {
+                    result.overflow = true;
+                    return result;
+                }
+
+                columns += completed;
+                input += completed;
+                grapheme_process_init(static_cast<char32_t>(*input), state);
+                clusterOpen = true;
+                clusterWidth = 1;
+                ++input;
+                continue;
+            }
+
+            auto const codepointStart = input;
+            auto const codepoint = decode_next(input, end);
+            if (!clusterOpen || grapheme_process_breakable(codepoint, state))
+            {
+                if (!complete(codepointStart))
+                {
+                    result.overflow = true;
+                    return result;
+                }
+                grapheme_process_init(codepoint, state);
+                clusterOpen = true;
+                clusterWidth = width(codepoint);
+            }
+            else if (codepoint == VS16)
+                clusterWidth = 2; // Increase width on VS16 but do not decrease on VS15.
+            else
+                clusterWidth = max(clusterWidth, static_cast<size_t>(width(codepoint)));
+        }
+
+        if (!complete(end))
+        {
+            result.overflow = true;
+            return result;
+        }
+
+        result.columns = columns;
+        return result;
+    }
+
+    // Tests if there is a grapheme cluster boundary between @p a and @p b,
+    // with @p aStart pointing to the first byte of @p a.
+    bool breakable_backward(char32_t a, char32_t b, char const* aStart, char const* begin) noexcept
+    {
+        if (a < 0x80 && b < 0x80)
+            return !(a == '\r' && b == '\n');
+
+        if (is_regional_indicator(a) && is_regional_indicator(b))
+        {
+            // GB12/GB13: Only break if there is an even number of regional indicators before b.
+            size_t count = 1;
+            while (aStart != begin)
+            {
+                auto cursor = aStart;
+                if (!is_regional_indicator(decode_previous(cursor, begin)))
+                    break;
+                aStart = cursor;
+                ++count;
+            }
+            return count % 2 == 0;
+        }
+
+        return grapheme_segmenter::breakable(a, b);
+    }
+
+    struct backward_result
+    {
+        char const* start; // start of the longest suffix that fits into the given budget
+        size_t columns;    // number of columns of that suffix
+    };
+
+    // Walks the text backwards, cluster by cluster, until either @p limit is reached
+    // or the next cluster would not fit into @p budget anymore.
+    backward_result scan_backward(string_view text, char const* limit, size_t budget) noexcept
+    {
+        char const* input = text.data() + text.size();
+        auto result = backward_result { input, 0 };
+
+        while (input != limit)
+        {
+            auto first = decode_previous(input, limit);
+            auto clusterWidth = static_cast<size_t>(width(first));
+            bool forceWide = false;
+
+            while (input != limit)
+            {
+                auto cursor = input;
+                auto const previous = decode_previous(cursor, limit);
+                if (breakable_backward(previous, first, cursor, limit))
+                    break;
+                forceWide = forceWide || first == VS16;
+                clusterWidth = max(clusterWidth, static_cast<size_t>(width(previous)));
+                first = previous;
+                input = cursor;
+            }
+
+            if (forceWide)
+                clusterWidth = 2;
+
+            if (result.columns + clusterWidth > budget)
+                break;
+
+            result.columns += clusterWidth;
+            result.start = input;
+        }
+
+        return result;
+    }
+
+    size_t columns_of(string_view text) noexcept
+    {
+        return scan_forward(text, 0, Unlimited).columns;
+    }
+} // namespace
+
+truncation_result truncate_to_columns(string_view text, size_t maxColumns, string_view ellipsis) noexcept
+{
+    auto const ellipsisColumns = columns_of(ellipsis);
+    auto const withEllipsis = ellipsisColumns <= maxColumns;
+    auto const budget = withEllipsis ? maxColumns - ellipsisColumns : maxColumns;
+
+    auto const scan = scan_forward(text, budget, maxColumns);
+    if (!scan.overflow)
+        return { text, {}, {}, scan.columns, false };
+
+    auto const head = string_view(text.data(), static_cast<size_t>(scan.cut - text.data()));
+    if (!withEllipsis)
+        return { head, {}, {}, scan.cutColumns, true };
+
+    return { head, ellipsis, {}, scan.cutColumns + ellipsisColumns, true };
+}
+
+truncation_result truncate_middle_to_columns(string_view text, size_t maxColumns, string_view ellipsis) noexcept
+{
+    auto const ellipsisColumns = columns_of(ellipsis);
+    auto const withEllipsis = ellipsisColumns <= maxColumns;
+    auto const available = withEllipsis ? maxColumns - ellipsisColumns : maxColumns;
+    auto const headBudget = available - available / 2;
+
+    auto const scan = scan_forward(text, headBudget, maxColumns);
+    if (!scan.overflow)
+        return { text, {}, {}, scan.columns, false };
+
+    // The tail may use whatever the head could not fill up (e.g. due to a wide character at the cut).
+    auto const tailScan = scan_backward(text, scan.cut, available - scan.cutColumns);
+
+    auto const head = string_view(text.data(), static_cast<size_t>(scan.cut - text.data()));
+    auto const tail = string_view(tailScan.start, static_cast<size_t>(text.data() + text.size() - tailScan.start));
+    auto const columns = scan.cutColumns + tailScan.columns;
+
+    if (!withEllipsis)
+        return { head, {}, tail, columns, true };
+
+    return { head, ellipsis, tail, columns + ellipsisColumns, true };
+}
+
+} // namespace unicode
@@ -0,0 +1,72 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace unicode
+{
+
+/// Holds the result of a call to truncate_to_columns() or truncate_middle_to_columns().
+///
+/// All members are views into either the input text or the passed ellipsis,
+/// so that no allocation is needed. The text to display is the concatenation
+/// of head, ellipsis and tail (in that order).
+struct truncation_result
+{
+    /// Leading part of the input text. This is the whole input text if it was not truncated.
+    std::string_view head;
+
+    /// The ellipsis to display right after head. Empty if the input was not truncated.
+    std::string_view ellipsis;
+
+    /// Trailing part of the input text to display after the ellipsis.
+    /// Only used by middle-elision, empty otherwise.
+    std::string_view tail;
+
+    /// Number of columns the concatenation of head, ellipsis and tail occupies.
+    size_t columns = 0;
+
+    /// Indicates whether or not the input text had to be truncated.
+    bool truncated = false;
+};
+
+/// Truncates a UTF-8 string at its end to fit into @p maxColumns columns.
+///
+/// If the text does not fit, it is cut at the last grapheme cluster boundary
+/// that still leaves room for @p ellipsis. Grapheme clusters (such as ZWJ emoji sequences
+/// or combining character sequences) are never split.
+///
+/// If the ellipsis itself does not fit into @p maxColumns, the text is truncated without ellipsis.
+///
+/// The input is processed in a single forward pass that stops as soon as
+/// the text is known to exceed @p maxColumns. Control characters are treated as zero-width.
+truncation_result truncate_to_columns(std::string_view text,
+                                      size_t maxColumns,
+                                      std::string_view ellipsis = "\xE2\x80\xA6") noexcept;
+
+/// Truncates a UTF-8 string in the middle to fit into @p maxColumns columns.
+///
+/// Same as truncate_to_columns(), but keeps the beginning and the end of the text,
+/// eliding the middle part. The head receives the extra column if the available
+/// columns cannot be split evenly.
+///
+/// The tail is determined by iterating grapheme clusters backwards from the end of the text,
+/// so that only the bytes that end up being displayed are inspected.
+truncation_result truncate_middle_to_columns(std::string_view text,
+                                             size_t maxColumns,
+                                             std::string_view ellipsis = "\xE2\x80\xA6") noexcept;
+
+} // namespace unicode
@@ -0,0 +1,187 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/convert.h>
+#include <libunicode/truncate.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+auto constexpr FamilyEmoji = U"\U0001F468\u200D\U0001F469\u200D\U0001F467\u200D\U0001F466"sv;
+auto constexpr FlagDE = U"\U0001F1E9\U0001F1EA"sv;
+auto constexpr FlagFR = U"\U0001F1EB\U0001F1F7"sv;
+auto constexpr Ellipsis = "\xE2\x80\xA6"sv;
+
+template <typename T>
+auto u8(T text)
+{
+    return unicode::convert_to<char>(text);
+}
+
+string joined(unicode::truncation_result const& result)
+{
+    return string(result.head) + string(result.ellipsis) + string(result.tail);
+}
+
+} // namespace
+
+TEST_CASE("truncate.ascii.fits")
+{
+    auto const result = unicode::truncate_to_columns("Hello"sv, 5);
+    CHECK(!result.truncated);
+    CHECK(result.head == "Hello");
+    CHECK(result.ellipsis.empty());
+    CHECK(result.tail.empty());
+    CHECK(result.columns == 5);
+}
+
+TEST_CASE("truncate.ascii.truncated")
+{
+    auto const result = unicode::truncate_to_columns("Hello, World"sv, 8);
+    CHECK(result.truncated);
+    CHECK(result.head == "Hello, ");
+    CHECK(result.ellipsis == Ellipsis);
+    CHECK(result.columns == 8);
+}
+
+TEST_CASE("truncate.ascii.custom_ellipsis")
+{
+    auto const result = unicode::truncate_to_columns("Hello, World"sv, 8, "..."sv);
+    CHECK(result.truncated);
+    CHECK(joined(result) == "Hello...");
+    CHECK(result.columns == 8);
+}
+
+TEST_CASE("truncate.ellipsis_too_wide")
+{
+    auto const result = unicode::truncate_to_columns("Hello"sv, 2, "..."sv);
+    CHECK(result.truncated);
+    CHECK(result.head == "He");
+    CHECK(result.ellipsis.empty());
+    CHECK(result.columns == 2);
+}
+
+TEST_CASE("truncate.zero_columns")
+{
+    auto const result = unicode::truncate_to_columns("Hello"sv, 0);
+    CHECK(result.truncated);
+    CHECK(joined(result).empty());
+    CHECK(result.columns == 0);
+}
+
+TEST_CASE("truncate.emoji.not_split")
+{
+    // "ab" + family emoji (2 columns) + "cd" does not fit into 4 columns,
+    // and the emoji does not fit into the 3 columns left for text either.
+    auto const text = "ab" + u8(FamilyEmoji) + "cd";
+    auto const result = unicode::truncate_to_columns(text, 4);
+    CHECK(result.truncated);
+    CHECK(result.head == "ab");
+    CHECK(result.columns == 3);
+
+    auto const wider = unicode::truncate_to_columns(text, 5);
+    CHECK(wider.head == "ab" + u8(FamilyEmoji));
+    CHECK(wider.columns == 5);
+}
+
+TEST_CASE("truncate.combining.not_split")
+{
+    // The combining acute accent must stay with its base character,
+    // even though the base character is US-ASCII.
+    auto const text = u8(U"e\u0301e\u0301e\u0301"sv);
+    auto const result = unicode::truncate_to_columns(text, 2);
+    CHECK(result.truncated);
+    CHECK(result.head == u8(U"e\u0301"sv));
+    CHECK(result.columns == 2);
+
+    auto const fits = unicode::truncate_to_columns(text, 3);
+    CHECK(!fits.truncated);
+    CHECK(fits.columns == 3);
+}
+
+TEST_CASE("truncate.invalid_utf8")
+{
+    auto const result = unicode::truncate_to_columns("ab\xFF"
+                                                     "cd"sv,
+                                                     3);
+    CHECK(result.truncated);
+    CHECK(result.head == "ab");
+    CHECK(result.columns == 3);
+}
+
+TEST_CASE("truncate.invalid_utf8.maximal_subpart")
+{
+    // Each byte of an overlong encoding is ill-formed on its own (Unicode, Table 3-7).
+    auto const result = unicode::truncate_to_columns("\xE0\x80\x80"
+                                                     "ab"sv,
+                                                     80);
+    CHECK(!result.truncated);
+    CHECK(result.columns == 5);
+}
+
+TEST_CASE("truncate.middle.fits")
+{
+    auto const result = unicode::truncate_middle_to_columns("abc"sv, 3);
+    CHECK(!result.truncated);
+    CHECK(result.head == "abc");
+    CHECK(result.tail.empty());
+    CHECK(result.columns == 3);
+}
+
+TEST_CASE("truncate.middle.ascii")
+{
+    auto const odd = unicode::truncate_middle_to_columns("0123456789"sv, 5);
+    CHECK(odd.truncated);
+    CHECK(odd.head == "01");
+    CHECK(odd.ellipsis == Ellipsis);
+    CHECK(odd.tail == "89");
+    CHECK(odd.columns == 5);
+
+    // The head receives the extra column.
+    auto const even = unicode::truncate_middle_to_columns("0123456789"sv, 6);
+    CHECK(even.head == "012");
+    CHECK(even.tail == "89");
+    CHECK(even.columns == 6);
+}
+
+TEST_CASE("truncate.middle.emoji_tail")
+{
+    auto const text = "abcdef" + u8(FamilyEmoji);
+    auto const result = unicode::truncate_middle_to_columns(text, 5);
+    CHECK(result.truncated);
+    CHECK(result.head == "ab");
+    CHECK(result.tail == u8(FamilyEmoji));
+    CHECK(result.columns == 5);
+}
+
+TEST_CASE("truncate.middle.regional_indicators")
+{
+    // The tail must pair up the regional indicators from the start, not from the end.
+    auto const text = "0123456789" + u8(FlagDE) + u8(FlagFR);
+    auto const result = unicode::truncate_middle_to_columns(text, 8);
+    CHECK(result.truncated);
+    CHECK(result.head == "0123");
+    CHECK(result.tail == u8(FlagFR));
+    CHECK(result.columns == 7);
+}
@@ -0,0 +1,97 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+/// SystemTap-compatible USDT probes (provider "libunicode"), for tracing with bpftrace, perf or SystemTap:
+///
+/// @code
+/// bpftrace -e 'usdt:/usr/lib/libunicode.so:libunicode:scan_text_exit { @columns = hist(arg1); }'
+/// @endcode
+///
+/// Probes are compiled in with LIBUNICODE_USDT=ON (defining LIBUNICODE_USDT) on Linux x86-64 and AArch64,
+/// and compile to nothing otherwise. Like <sys/sdt.h>, which this is compatible with but does not require,
+/// each probe site is a single NOP and a .note.stapsdt ELF note that tracers use to attach to it.
+/// There are no semaphores, so arguments are computed even if no tracer is attached;
+/// probe sites therefore only pass values that are at hand anyway.
+///
+/// Probes are only placed in libunicode's own code. Public headers call into the library for them instead,
+/// if it was built with probes, as indicated to its users by LIBUNICODE_HAS_USDT.
+///
+/// Probes:
+///
+/// - scan_text_entry(char const* text, size_t size, size_t maxColumnCount)
+/// - scan_text_exit(size_t bytes, size_t columns)
+/// - tables_load_begin(char const* ucdDirectory)
+/// - tables_load_end(size_t propertyCount, size_t nameCount)
+/// - tables_publish(codepoint_properties::table_set const* tables, size_t retiredCount)
+/// - run_segment(size_t start, size_t end)
+
+#include <type_traits>
+
+// clang-format off
+#if defined(LIBUNICODE_USDT) && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) \
+    && (defined(__GNUC__) || defined(__clang__))
+    #define LIBUNICODE_USDT_ENABLED 1
+#endif
+
+#if defined(LIBUNICODE_USDT_ENABLED)
+    // Argument size in bytes, to be negative if signed, as expected by the tracers (%n negates it).
+    #define LIBUNICODE_USDT_ARG_SIZE(x) \
+        ((std::is_signed_v<std::decay_t<decltype(x)>> ? 1 : -1) * static_cast<int>(sizeof(x)))
+
+    #define LIBUNICODE_USDT_ARG(n, x) \
+        [_size##n] "n"(LIBUNICODE_USDT_ARG_SIZE(x)), [_arg##n] "nor"(x)
+
+    #define LIBUNICODE_USDT_NOTE(name, args)                                                     \
+        "990: nop\n"                                                                             \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                            \
+        ".balign 4\n"                                                                            \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                                       \
+        "991: .asciz \"stapsdt\"\n"                                                              \
+        "992: .balign 4\n"                                                                       \
+        "993: .8byte 990b\n"                                                                     \
+        ".8byte _.stapsdt.base\n"                                                                \
+        ".8byte 0\n"                                                                             \
+        ".asciz \"libunicode\"\n"                                                                \
+        ".asciz \"" #name "\"\n"                                                                 \
+        ".asciz \"" args "\"\n"                                                                  \
+        "994: .balign 4\n"                                                                       \
+        ".popsection\n"                                                                          \
+        ".ifndef _.stapsdt.base\n"                                                               \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"                  \
+        ".weak _.stapsdt.base\n"                                                                 \
+        ".hidden _.stapsdt.base\n"                                                               \
+        "_.stapsdt.base: .space 1\n"                                                             \
+        ".size _.stapsdt.base, 1\n"                                                              \
+        ".popsection\n"                                                                          \
+        ".endif\n"
+
+    #define LIBUNICODE_PROBE(name) \
+        __asm__ __volatile__(LIBUNICODE_USDT_NOTE(name, ""))
+    #define LIBUNICODE_PROBE1(name, a1) \
+        __asm__ __volatile__(LIBUNICODE_USDT_NOTE(name, "%n[_size1]@%[_arg1]") :: LIBUNICODE_USDT_ARG(1, a1))
+    #define LIBUNICODE_PROBE2(name, a1, a2)                                                            \
+        __asm__ __volatile__(LIBUNICODE_USDT_NOTE(name, "%n[_size1]@%[_arg1] %n[_size2]@%[_arg2]")   \
+                             :: LIBUNICODE_USDT_ARG(1, a1), LIBUNICODE_USDT_ARG(2, a2))
+    #define LIBUNICODE_PROBE3(name, a1, a2, a3)                                                       \
+        __asm__ __volatile__(                                                                         \
+            LIBUNICODE_USDT_NOTE(name, "%n[_size1]@%[_arg1] %n[_size2]@%[_arg2] %n[_size3]@%[_arg3]") \
+            :: LIBUNICODE_USDT_ARG(1, a1), LIBUNICODE_USDT_ARG(2, a2), LIBUNICODE_USDT_ARG(3, a3))
+#else
+    #define LIBUNICODE_PROBE(name) do {} while (0)
+    #define LIBUNICODE_PROBE1(name, a1) do {} while (0)
+    #define LIBUNICODE_PROBE2(name, a1, a2) do {} while (0)
+    #define LIBUNICODE_PROBE3(name, a1, a2, a3) do {} while (0)
+#endif
+// clang-format on
@@ -15,6 +15,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -88,6 +92,44 @@ inline std::string to_utf8(std::u32string_view const& characters)
     return to_utf8(characters.data(), characters.size());
 }
 
+/// Returns the number of bytes the given UTF-32 string occupies when encoded as UTF-8.
+constexpr inline size_t utf8_length(std::u32string_view characters) noexcept
+{
+    size_t length = 0;
+    for (auto const character: characters)
+        length += character <= 0x7F ? 1 : character <= 0x07FF ? 2 : character <= 0xFFFF ? 3 : 4;
+    return length;
+}
+
+/// Converts a UTF-32 string into UTF-8, writing into the given buffer without allocating.
+///
+/// Conversion stops before the first codepoint that does not entirely fit into @p output,
+/// i.e. an output of utf8_length() bytes is always sufficient.
+///
+/// @return number of bytes written.
+inline size_t to_utf8(std::u32string_view characters, std::span<char> output) noexcept
+{
+    size_t written = 0;
+    for (auto const character: characters)
+    {
+        uint8_t bytes[4];
+        auto const len = to_utf8(character, bytes);
+        if (len > output.size() - written)
+            break;
+        std::memcpy(output.data() + written, bytes, len);
+        written += len;
+    }
+    return written;
+}
+
+/// Converts a UTF-32 string into an UTF-8 string, allocated from the given memory resource.
+inline std::pmr::string to_utf8(std::u32string_view characters, std::pmr::memory_resource* resource)
+{
+    auto s = std::pmr::string(utf8_length(characters), '\0', resource);
+    to_utf8(characters, std::span<char>(s));
+    return s;
+}
+
 struct utf8_decoder_state
 {
     char32_t character = 0;
@@ -165,4 +207,190 @@ inline std::basic_string<T> from_utf8(std::string_view bytes)
     return s;
 }
 
+namespace detail
+{
+    /// Incrementally decodes a single UTF-8 sequence, accepting well-formed sequences only,
+    /// as defined by Unicode (Table 3-7), that is, rejecting overlong encodings, surrogates,
+    /// and codepoints above U+10FFFF.
+    ///
+    /// A byte rejected by next() ends the maximal subpart of an ill-formed sequence
+    /// and is not consumed, i.e. it may start the next sequence.
+    struct utf8_sequence_decoder
+    {
+        char32_t codepoint = 0; // the (partially) decoded codepoint
+        unsigned pending = 0;   // number of continuation bytes still expected
+        uint8_t lo = 0x80;      // range of the next valid continuation byte
+        uint8_t hi = 0xBF;
+
+        /// Starts a new sequence with the given byte.
+        ///
+        /// @return false if the byte cannot start a well-formed sequence,
+        ///         true otherwise, with the codepoint being complete if no bytes are pending.
+        constexpr bool start(uint8_t lead) noexcept
+        {
+            lo = 0x80;
+            hi = 0xBF;
+            if (lead < 0x80)
+            {
+                codepoint = lead;
+                pending = 0;
+                return true;
+            }
+            if (lead < 0xC2 || lead > 0xF4)
+            {
+                pending = 0;
+                return false;
+            }
+            if (lead < 0xE0)
+            {
+                codepoint = lead & 0x1F;
+                pending = 1;
+            }
+            else if (lead < 0xF0)
+            {
+                codepoint = lead & 0x0F;
+                pending = 2;
+                if (lead == 0xE0)
+                    lo = 0xA0; // overlong
+                else if (lead == 0xED)
+                    hi = 0x9F; // surrogates
+            }
+            else
+            {
+                codepoint = lead & 0x07;
+                pending = 3;
+                if (lead == 0xF0)
+                    lo = 0x90; // overlong
+                else if (lead == 0xF4)
+                    hi = 0x8F; // above U+10FFFF
+            }
+            return true;
+        }
+
+        /// Continues the pending sequence with the given byte.
+        ///
+        /// @return false if the byte does not continue the sequence, which is then ill-formed.
+        constexpr bool next(uint8_t byte) noexcept
+        {
+            if (byte < lo || byte > hi)
+            {
+                pending = 0;
+                return false;
+            }
+            codepoint = (codepoint << 6) | (byte & 0x3F);
+            lo = 0x80;
+            hi = 0xBF;
+            --pending;
+            return true;
+        }
+    };
+
+    /// Decodes the UTF-8 sequence at @p input, moving @p input behind it,
+    /// or behind the maximal subpart if the sequence is ill-formed or incomplete.
+    ///
+    /// @return the decoded codepoint, or std::nullopt if the sequence is ill-formed or incomplete.
+    template <typename Iterator, typename Sentinel>
+    constexpr std::optional<char32_t> decode_utf8_sequence(Iterator& input, Sentinel end) noexcept
+    {
+        auto decoder = utf8_sequence_decoder {};
+        if (!decoder.start(static_cast<uint8_t>(*input++)))
+            return std::nullopt;
+        while (decoder.pending)
+        {
+            if (input == end || !decoder.next(static_cast<uint8_t>(*input)))
+                return std::nullopt;
+            ++input;
+        }
+        return decoder.codepoint;
+    }
+
+    /// Invokes @p callback for each codepoint decoded from @p bytes, skipping ill-formed sequences,
+    /// as long as @p callback returns true.
+    template <typename Callback>
+    void decode_utf8(std::string_view bytes, Callback callback)
+    {
+        auto state = utf8_decoder_state {};
+        for (auto const byte: bytes)
+        {
+            auto const result = from_utf8(state, static_cast<uint8_t>(byte));
+            if (auto const* success = std::get_if<Success>(&result); success && !callback(success->value))
+                return;
+        }
+    }
+} // namespace detail
+
+/// Decodes UTF-8 into the given buffer without allocating, skipping ill-formed sequences.
+///
+/// Decoding stops as soon as @p output is full, i.e. an output of @p bytes.size() codepoints is always sufficient.
+///
+/// @return number of codepoints written.
+inline size_t from_utf8(std::string_view bytes, std::span<char32_t> output) noexcept
+{
+    size_t count = 0;
+    if (!output.empty())
+        detail::decode_utf8(bytes, [&](char32_t codepoint) noexcept {
+            output[count++] = codepoint;
+            return count != output.size();
+        });
+    return count;
+}
+
+/// Decodes UTF-8 into a UTF-32 string, allocated from the given memory resource, skipping ill-formed sequences.
+inline std::pmr::u32string from_utf8(std::string_view bytes, std::pmr::memory_resource* resource)
+{
+    auto s = std::pmr::u32string(resource);
+    detail::decode_utf8(bytes, [&](char32_t codepoint) {
+        s.push_back(codepoint);
+        return true;
+    });
+    return s;
+}
+
+/// Holds the result of a call to utf8_validate().
+struct utf8_validation_result
+{
+    /// Indicates whether or not the input is well-formed UTF-8.
+    bool ok;
+
+    /// Byte offset to the start of the first ill-formed UTF-8 sequence, or the input size if ok.
+    size_t firstErrorOffset;
+};
+
+/// Validates the given bytes to be well-formed UTF-8, as defined by Unicode (Table 3-7),
+/// that is, also rejecting overlong encodings, surrogates, and codepoints above U+10FFFF.
+///
+/// The best available SIMD implementation is selected at runtime (AVX-512 or AVX2 on x86-64,
+/// falling back to an SSE2/NEON accelerated US-ASCII fast path).
+utf8_validation_result utf8_validate(std::string_view bytes) noexcept;
+
+/// Replaces ill-formed UTF-8 sequences with U+FFFD, following the WHATWG Encoding Standard,
+/// i.e. each maximal subpart of an ill-formed sequence is replaced by a single U+FFFD.
+///
+/// @param bytes    the UTF-8 input to sanitize
+/// @param storage  buffer to write the sanitized text into, only used if the input is not valid UTF-8.
+///
+/// @return @p bytes itself if it is well-formed UTF-8 (no copy is made),
+///         or a view to @p storage, holding the sanitized text otherwise.
+std::string_view utf8_sanitize(std::string_view bytes, std::string& storage);
+
+/// Replaces ill-formed UTF-8 sequences with U+FFFD, as described above, returning a copy.
+std::string utf8_sanitize(std::string_view bytes);
+
+namespace detail
+{
+    enum class utf8_validator
+    {
+        Scalar,
+        Baseline, // SSE2 or NEON, if enabled, scalar otherwise
+        AVX2,
+        AVX512,
+    };
+
+    /// Tests if the given validator is supported by the build and the CPU at hand.
+    bool is_supported(utf8_validator validator) noexcept;
+
+    /// Returns the offset of the first ill-formed sequence (or the input size) using the given validator.
+    size_t utf8_validate(std::string_view bytes, utf8_validator validator) noexcept;
+} // namespace detail
+
 } // namespace unicode
@@ -15,36 +15,50 @@
 #include <libunicode/grapheme_segmenter.h>
 #include <libunicode/utf8.h>
 
+#include <memory>
+#include <memory_resource>
 #include <ostream>
+#include <string>
 #include <string_view>
 
 namespace unicode
 {
 
-struct utf8_grapheme_segmenter
+/// Segments UTF-8 text into grapheme clusters, with the iterators' current grapheme cluster
+/// being allocated by the given allocator.
+template <typename Allocator = std::allocator<char32_t>>
+struct basic_utf8_grapheme_segmenter
 {
     class iterator;
 
-    explicit utf8_grapheme_segmenter(std::string_view text) noexcept;
-    utf8_grapheme_segmenter(utf8_grapheme_segmenter const&) noexcept = default;
-    utf8_grapheme_segmenter(utf8_grapheme_segmenter&&) noexcept = default;
-    utf8_grapheme_segmenter& operator=(utf8_grapheme_segmenter const&) noexcept = default;
-    utf8_grapheme_segmenter& operator=(utf8_grapheme_segmenter&&) noexcept = default;
+    explicit basic_utf8_grapheme_segmenter(std::string_view text, Allocator const& allocator = Allocator()) noexcept;
+    basic_utf8_grapheme_segmenter(basic_utf8_grapheme_segmenter const&) noexcept = default;
+    basic_utf8_grapheme_segmenter(basic_utf8_grapheme_segmenter&&) noexcept = default;
+    basic_utf8_grapheme_segmenter& operator=(basic_utf8_grapheme_segmenter const&) noexcept = default;
+    basic_utf8_grapheme_segmenter& operator=(basic_utf8_grapheme_segmenter&&) noexcept = default;
 
     iterator begin() const noexcept;
     iterator end() const noexcept;
 
   private:
     std::string_view _text;
+    Allocator _allocator;
 };
 
-class utf8_grapheme_segmenter::iterator
+using utf8_grapheme_segmenter = basic_utf8_grapheme_segmenter<>;
+
+/// Grapheme cluster segmenter whose iterators allocate their current grapheme cluster
+/// from a std::pmr::memory_resource.
+using pmr_utf8_grapheme_segmenter = basic_utf8_grapheme_segmenter<std::pmr::polymorphic_allocator<char32_t>>;
+
+template <typename Allocator>
+class basic_utf8_grapheme_segmenter<Allocator>::iterator
 {
   public:
-    using value_type = std::u32string;
+    using value_type = std::basic_string<char32_t, std::char_traits<char32_t>, Allocator>;
 
-    iterator(char const* data, char const* end) noexcept;
-    iterator(iterator const&) = default;
+    iterator(char const* data, char const* end, Allocator const& allocator = Allocator()) noexcept;
+    iterator(iterator const& other);
     iterator(iterator&&) noexcept = default;
     iterator& operator=(iterator const&) = default;
     iterator& operator=(iterator&&) noexcept = default;
@@ -58,6 +72,12 @@ class utf8_grapheme_segmenter::iterator
     bool operator==(iterator const& other) const noexcept;
     bool operator!=(iterator const& other) const noexcept;
 
+    friend std::ostream& operator<<(std::ostream& os, iterator const& i)
+    {
+        os << '"' << unicode::convert_to<char>(std::u32string_view(i.value())) << '"';
+        return os;
+    }
+
     // private:
     char32_t consumeCodepoint() noexcept;
     void consumeGraphemeCluster() noexcept;
@@ -73,25 +93,38 @@ class utf8_grapheme_segmenter::iterator
     value_type _cluster {};
 };
 
-// {{{ utf8_grapheme_segmenter implementation
-inline utf8_grapheme_segmenter::utf8_grapheme_segmenter(std::string_view text) noexcept: _text { text }
+// {{{ basic_utf8_grapheme_segmenter implementation
+template <typename Allocator>
+inline basic_utf8_grapheme_segmenter<Allocator>::basic_utf8_grapheme_segmenter(std::string_view text,
+                                                                               Allocator const& allocator) noexcept:
+    _text { text }, _allocator { allocator }
 {
 }
 
-inline utf8_grapheme_segmenter::iterator utf8_grapheme_segmenter::begin() const noexcept
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::begin() const noexcept -> iterator
 {
-    return iterator { _text.data(), _text.data() + _text.size() };
+    return iterator { _text.data(), _text.data() + _text.size(), _allocator };
 }
 
-inline utf8_grapheme_segmenter::iterator utf8_grapheme_segmenter::end() const noexcept
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::end() const noexcept -> iterator
 {
-    return iterator { _text.data() + _text.size(), _text.data() + _text.size() };
+    return iterator { _text.data() + _text.size(), _text.data() + _text.size(), _allocator };
 }
 // }}}
 
 // {{{ iterator implementation
-inline utf8_grapheme_segmenter::iterator::iterator(char const* data, char const* end) noexcept:
-    _start { data }, _clusterStart { data }, _nextCodepointStart { data }, _nextUtf8 { data }, _end { end }
+template <typename Allocator>
+inline basic_utf8_grapheme_segmenter<Allocator>::iterator::iterator(char const* data,
+                                                                    char const* end,
+                                                                    Allocator const& allocator) noexcept:
+    _start { data },
+    _clusterStart { data },
+    _nextCodepointStart { data },
+    _nextUtf8 { data },
+    _end { end },
+    _cluster { allocator }
 {
     if (data != end)
     {
@@ -100,17 +133,35 @@ inline utf8_grapheme_segmenter::iterator::iterator(char const* data, char const*
     }
 }
 
-inline utf8_grapheme_segmenter::iterator::value_type const& utf8_grapheme_segmenter::iterator::value() const noexcept
+// Copies propagate the allocator, unlike std::pmr containers' default copy construction.
+template <typename Allocator>
+inline basic_utf8_grapheme_segmenter<Allocator>::iterator::iterator(iterator const& other):
+    _start { other._start },
+    _clusterStart { other._clusterStart },
+    _nextCodepointStart { other._nextCodepointStart },
+    _nextUtf8 { other._nextUtf8 },
+    _end { other._end },
+    _utf8_decoder_state { other._utf8_decoder_state },
+    _result { other._result },
+    _nextCodepoint { other._nextCodepoint },
+    _cluster { other._cluster, other._cluster.get_allocator() }
+{
+}
+
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::iterator::value() const noexcept -> value_type const&
 {
     return _cluster;
 }
 
-inline utf8_grapheme_segmenter::iterator::value_type const& utf8_grapheme_segmenter::iterator::operator*() const noexcept
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::iterator::operator*() const noexcept -> value_type const&
 {
     return _cluster;
 }
 
-inline char32_t utf8_grapheme_segmenter::iterator::consumeCodepoint() noexcept
+template <typename Allocator>
+inline char32_t basic_utf8_grapheme_segmenter<Allocator>::iterator::consumeCodepoint() noexcept
 {
     auto constexpr ReplacementChar = char32_t { 0xFFFD };
     _nextCodepointStart = _nextUtf8;
@@ -135,7 +186,8 @@ inline char32_t utf8_grapheme_segmenter::iterator::consumeCodepoint() noexcept
     return result;
 }
 
-inline void utf8_grapheme_segmenter::iterator::consumeGraphemeCluster() noexcept
+template <typename Allocator>
+inline void basic_utf8_grapheme_segmenter<Allocator>::iterator::consumeGraphemeCluster() noexcept
 {
     _clusterStart = _nextCodepointStart;
     _cluster.clear();
@@ -148,37 +200,32 @@ inline void utf8_grapheme_segmenter::iterator::consumeGraphemeCluster() noexcept
     }
 }
 
-inline utf8_grapheme_segmenter::iterator& utf8_grapheme_segmenter::iterator::operator++() noexcept
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::iterator::operator++() noexcept -> iterator&
 {
     consumeGraphemeCluster();
     return *this;
 }
 
-inline utf8_grapheme_segmenter::iterator utf8_grapheme_segmenter::iterator::operator++(int) noexcept
+template <typename Allocator>
+inline auto basic_utf8_grapheme_segmenter<Allocator>::iterator::operator++(int) noexcept -> iterator
 {
     auto tmp(*this);
     ++*this;
     return tmp;
 }
 
-inline bool utf8_grapheme_segmenter::iterator::operator==(iterator const& other) const noexcept
+template <typename Allocator>
+inline bool basic_utf8_grapheme_segmenter<Allocator>::iterator::operator==(iterator const& other) const noexcept
 {
     return _clusterStart == other._clusterStart;
 }
 
-inline bool utf8_grapheme_segmenter::iterator::operator!=(iterator const& other) const noexcept
+template <typename Allocator>
+inline bool basic_utf8_grapheme_segmenter<Allocator>::iterator::operator!=(iterator const& other) const noexcept
 {
     return !(*this == other);
 }
 // }}}
 
 } // namespace unicode
-
-namespace std
-{
-inline ostream& operator<<(ostream& os, unicode::utf8_grapheme_segmenter::iterator const& i)
-{
-    os << '"' << unicode::convert_to<char>(std::u32string_view(i.value())) << '"';
-    return os;
-}
-} // namespace std
@@ -17,7 +17,11 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <array>
+#include <memory_resource>
+#include <string>
 #include <string_view>
+#include <type_traits>
 
 using namespace std::string_literals;
 using namespace std::string_view_literals;
@@ -88,3 +92,26 @@ TEST_CASE("utf8_grapheme_segmenter.mixed")
     test_utf8_grapheme_cluster_segmentation(U"├"sv, U"─"sv, U" "sv, U"Y"sv, U"e"sv, U"s"sv);
     test_utf8_grapheme_cluster_segmentation(U"X"sv, U"\U0001F926\U0001F3FC\u200D\u2642\uFE0F"sv, U"5"sv);
 }
+
+static_assert(std::is_same_v<unicode::utf8_grapheme_segmenter::iterator::value_type, std::u32string>);
+static_assert(std::is_same_v<unicode::pmr_utf8_grapheme_segmenter::iterator::value_type, std::pmr::u32string>);
+
+TEST_CASE("utf8_grapheme_segmenter.memory_resource")
+{
+    // Fails any allocation beyond the fixed buffer, rather than falling back to the heap.
+    auto buffer = std::array<std::byte, 1024> {};
+    auto arena = std::pmr::monotonic_buffer_resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    auto const text = "X\xF0\x9F\xA4\xA6\xF0\x9F\x8F\xBC\xE2\x80\x8D\xE2\x99\x82\xEF\xB8\x8F" "5"sv;
+    auto const grapheme_segmenter = unicode::pmr_utf8_grapheme_segmenter(text, &arena);
+    auto i = grapheme_segmenter.begin();
+    CHECK(*i++ == U"X"sv);
+    CHECK(i.value().get_allocator().resource() == &arena);
+    CHECK(*i == U"\U0001F926\U0001F3FC\u200D\u2642\uFE0F"sv);
+    CHECK(static_cast<void const*>(i.value().data()) >= buffer.data());
+    CHECK(static_cast<void const*>(i.value().data()) < buffer.data() + buffer.size());
+    ++i;
+    CHECK(*i == U"5"sv);
+    ++i;
+    CHECK(i == grapheme_segmenter.end());
+}
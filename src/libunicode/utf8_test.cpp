@@ -260,3 +260,92 @@ TEST_CASE("utf8.iter", "[utf8]")
     REQUIRE(holds_alternative<Success>(result));
     REQUIRE(get<Success>(result).value == U'\U0001F600');
 }
+
+namespace
+{
+
+auto const allValidators = std::array {
+    detail::utf8_validator::Scalar,
+    detail::utf8_validator::Baseline,
+    detail::utf8_validator::AVX2,
+    detail::utf8_validator::AVX512,
+};
+
+// Validates the given text with every validator supported on this machine,
+// placing it at various offsets to cross SIMD block boundaries.
+void checkValidate(string_view text, size_t expectedOffset)
+{
+    for (size_t const padding: std::array<size_t, 8> { 0, 1, 15, 31, 61, 63, 64, 100 })
+    {
+        for (auto const* filler: { "a", "\xC3\xA4", "\xE2\x82\xAC", "\xF0\x9F\x98\x80" })
+        {
+            auto input = string {};
+            while (input.size() < padding)
+                input += filler;
+            auto const prefix = input.size();
+            input += text;
+            auto const expected = expectedOffset == text.size() ? input.size() : prefix + expectedOffset;
+
+            for (auto const validator: allValidators)
+            {
+                if (!detail::is_supported(validator))
+                    continue;
+                INFO(fmt::format("validator {} padding {} filler {}", static_cast<int>(validator), padding, filler));
+                CHECK(detail::utf8_validate(input, validator) == expected);
+            }
+            CHECK(utf8_validate(input).ok == (expectedOffset == text.size()));
+            CHECK(utf8_validate(input).firstErrorOffset == expected);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("utf8.validate.valid", "[utf8]")
+{
+    checkValidate("", 0);
+    checkValidate("Hello, World!", 13);
+    checkValidate("\xC2\x80\xDF\xBF\xE0\xA0\x80\xED\x9F\xBF\xEE\x80\x80\xEF\xBF\xBF", 16);
+    checkValidate("\xF0\x90\x80\x80\xF4\x8F\xBF\xBF", 8);
+    checkValidate(string(200, 'x') + "\xE2\x80\xA6" + string(100, 'y'), 303);
+}
+
+TEST_CASE("utf8.validate.invalid", "[utf8]")
+{
+    checkValidate("\x80", 0);                    // lone continuation byte
+    checkValidate("a\xC0\xAF", 1);               // overlong 2-byte
+    checkValidate("ab\xC1\xBF", 2);              // overlong 2-byte
+    checkValidate("\xE0\x80\x80", 0);            // overlong 3-byte
+    checkValidate("\xED\xA0\x80", 0);            // surrogate
+    checkValidate("\xF0\x80\x80\x80", 0);        // overlong 4-byte
+    checkValidate("\xF4\x90\x80\x80", 0);        // above U+10FFFF
+    checkValidate("\xF5\x80\x80\x80", 0);        // invalid lead byte
+    checkValidate("\xFF", 0);                    // invalid lead byte
+    checkValidate("ab\xE2\x82", 2);              // truncated at end
+    checkValidate("\xE2\x82zzzz", 0);            // truncated by ASCII
+    checkValidate("\xC3\xA4\xC3\xA4\xC3", 4);    // truncated at end
+    checkValidate("\xF0\x9F\x98\x80\x80", 4);    // excess continuation byte
+    checkValidate("\xE2\x82\xAC\xE2\xE2\x82\xAC", 3); // truncated by lead byte
+}
+
+TEST_CASE("utf8.sanitize", "[utf8]")
+{
+    auto storage = string {};
+
+    auto const valid = "Hello \xE2\x80\xA6"sv;
+    auto const result = utf8_sanitize(valid, storage);
+    CHECK(result.data() == valid.data()); // zero-copy
+    CHECK(storage.empty());
+
+    // Example from the Unicode Standard (U+FFFD Substitution of Maximal Subparts).
+    auto const invalid = "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64"sv;
+    CHECK(utf8_sanitize(invalid, storage)
+          == "a\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD"
+             "b\xEF\xBF\xBD"
+             "c\xEF\xBF\xBD\xEF\xBF\xBD"
+             "d");
+
+    CHECK(utf8_sanitize("\xED\xA0\x80"sv) == "\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD");
+    CHECK(utf8_sanitize("ab\xF0\x9F\x98"sv) == "ab\xEF\xBF\xBD");
+    CHECK(utf8_sanitize("abc"sv) == "abc");
+}
@@ -0,0 +1,466 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/intrinsics.h>
+#include <libunicode/utf8.h>
+
+#include <cstring>
+
+// clang-format off
+#if defined(USE_INTRINSICS) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define LIBUNICODE_UTF8_VALIDATE_AVX 1
+    #include <immintrin.h>
+#endif
+// clang-format on
+
+using std::string;
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    auto constexpr ReplacementCharacter = string_view { "\xEF\xBF\xBD" };
+
+    [[maybe_unused]] int countTrailingZeroBits(unsigned int value) noexcept
+    {
+#if defined(_WIN32)
+        unsigned long r = 0;
+        _BitScanForward(&r, value);
+        return static_cast<int>(r);
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+
+    // Checks the UTF-8 sequence at @p input to be well-formed (Unicode, Table 3-7).
+    //
+    // @return the length of the sequence, or 0 if ill-formed, in which case
+    //         @p subpart receives the length of the maximal subpart of that sequence.
+    unsigned check_sequence(uint8_t const* input, uint8_t const* end, unsigned& subpart) noexcept
+    {
+        auto cursor = input;
+        auto const wellFormed = detail::decode_utf8_sequence(cursor, end).has_value();
+        auto const length = static_cast<unsigned>(cursor - input);
+        if (wellFormed)
+            return length;
+
+        subpart = length;
+        return 0;
+    }
+
+    size_t validate_scalar(uint8_t const* data, size_t pos, size_t size) noexcept
+    {
+        while (pos < size)
+        {
+            if (data[pos] < 0x80)
+            {
+                // Skip US-ASCII a word at a time.
+                while (pos + 8 <= size)
+                {
+                    uint64_t word = 0;
+                    std::memcpy(&word, data + pos, sizeof(word));
+                    if (word & 0x8080'8080'8080'8080llu)
+                        break;
+                    pos += 8;
+                }
+                while (pos < size && data[pos] < 0x80)
+                    ++pos;
+                continue;
+            }
+
+            unsigned subpart = 0;
+            auto const length = check_sequence(data + pos, data + size, subpart);
+            if (!length)
+                return pos;
+            pos += length;
+        }
+        return size;
+    }
+
+    // Returns the start of the sequence that @p pos may be in the middle of,
+    // given that all bytes before @p pos are well-formed (except for an incomplete sequence at the end).
+    size_t sequence_start(uint8_t const* data, size_t pos) noexcept
+    {
+        for (size_t k = 1; k <= 3 && k <= pos; ++k)
+        {
+            auto const value = data[pos - k];
+            if (value >= 0xC0)
+                return pos - k;
+            if (value < 0x80)
+                break;
+        }
+        return pos;
+    }
+
+    size_t validate_baseline(uint8_t const* data, size_t size) noexcept
+    {
+#if defined(USE_INTRINSICS)
+        size_t pos = 0;
+        while (pos + sizeof(intrinsics::m128i) <= size)
+        {
+            auto const batch = intrinsics::load_unaligned((intrinsics::m128i const*) (data + pos));
+            auto const mask = static_cast<unsigned>(intrinsics::movemask_epi8(batch));
+            if (!mask)
+            {
+                pos += sizeof(intrinsics::m128i);
+                continue;
+            }
+
+            pos += static_cast<size_t>(countTrailingZeroBits(mask));
+            while (pos < size && data[pos] >= 0x80)
+            {
+                unsigned subpart = 0;
+                auto const length = check_sequence(data + pos, data + size, subpart);
+                if (!length)
+                    return pos;
+                pos += length;
+            }
+        }
+        return validate_scalar(data, pos, size);
+#else
+        return validate_scalar(data, 0, size);
+#endif
+    }
+
+#if defined(LIBUNICODE_UTF8_VALIDATE_AVX)
+    // The vectorized validators implement the lookup algorithm described in:
+    // John Keiser, Daniel Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte" (2021).
+    //
+    // The first two bytes of each sequence are classified by three 16-entry lookup tables (indexed by
+    // the high nibble of the previous byte, the low nibble of the previous byte, and the high nibble of the current byte),
+    // whose intersection yields the error class. Missing or excess continuation bytes of 3- and 4-byte sequences
+    // are caught by comparing the expected continuation bytes (derived from the bytes two and three positions back)
+    // against the actual ones.
+    //
+    // Upon error, the exact offset is determined by the scalar validator,
+    // restarting at the beginning of the sequence the affected block starts in.
+
+    // clang-format off
+    auto constexpr TooShort = uint8_t { 1 << 0 };    // 11______ 0_______ or 11______ 11______
+    auto constexpr TooLong = uint8_t { 1 << 1 };     // 0_______ 10______
+    auto constexpr Overlong3 = uint8_t { 1 << 2 };   // 11100000 100_____
+    auto constexpr TooLarge = uint8_t { 1 << 3 };    // 11110100 1001____ (and above)
+    auto constexpr Surrogate = uint8_t { 1 << 4 };   // 11101101 101_____
+    auto constexpr Overlong2 = uint8_t { 1 << 5 };   // 1100000_ 10______
+    auto constexpr TooLarge1000 = uint8_t { 1 << 6 }; // 11110101 1000____ (and above)
+    auto constexpr Overlong4 = uint8_t { 1 << 6 };   // 11110000 1000____
+    auto constexpr TwoConts = uint8_t { 1 << 7 };    // 10______ 10______
+    auto constexpr Carry = uint8_t { TooShort | TooLong | TwoConts };
+
+    alignas(16) constexpr uint8_t Byte1High[16] = {
+        // 0_______ ________ <ASCII in byte 1>
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        // 10______ ________ <continuation in byte 1>
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        // 1100____ ________ <two byte lead in byte 1>
+        TooShort | Overlong2,
+        // 1101____ ________ <two byte lead in byte 1>
+        TooShort,
+        // 1110____ ________ <three byte lead in byte 1>
+        TooShort | Overlong3 | Surrogate,
+        // 1111____ ________ <four+ byte lead in byte 1>
+        TooShort | TooLarge | TooLarge1000 | Overlong4,
+    };
+
+    alignas(16) constexpr uint8_t Byte1Low[16] = {
+        // ____0000 ________
+        Carry | Overlong3 | Overlong2 | Overlong4,
+        // ____0001 ________
+        Carry | Overlong2,
+        // ____001_ ________
+        Carry, Carry,
+        // ____0100 ________
+        Carry | TooLarge,
+        // ____0101 ________ and ____011_ ________
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        // ____1___ ________
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        // ____1101 ________
+        Carry | TooLarge | TooLarge1000 | Surrogate,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+    };
+
+    alignas(16) constexpr uint8_t Byte2High[16] = {
+        // ________ 0_______ <ASCII in byte 2>
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        // ________ 1000____
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+        // ________ 1001____
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+        // ________ 101_____
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        // ________ 11______
+        TooShort, TooShort, TooShort, TooShort,
+    };
+    // clang-format on
+
+    // Maximum values of the last bytes of a block that do not start an incomplete sequence.
+    alignas(64) constexpr uint8_t IncompleteMax[64] = {
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+    };
+
+    // {{{ AVX2
+    #define LIBUNICODE_TARGET_AVX2 __attribute__((target("avx2")))
+
+    LIBUNICODE_TARGET_AVX2 inline __m256i avx2_table(uint8_t const* table) noexcept
+    {
+        return _mm256_broadcastsi128_si256(_mm_load_si128((__m128i const*) table));
+    }
+
+    template <int N>
+    LIBUNICODE_TARGET_AVX2 inline __m256i avx2_prev(__m256i input, __m256i previous) noexcept
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+    }
+
+    LIBUNICODE_TARGET_AVX2 inline __m256i avx2_high_nibbles(__m256i input) noexcept
+    {
+        return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    LIBUNICODE_TARGET_AVX2 inline __m256i avx2_check_block(__m256i input, __m256i previous) noexcept
+    {
+        auto const prev1 = avx2_prev<1>(input, previous);
+        auto const byte1High = _mm256_shuffle_epi8(avx2_table(Byte1High), avx2_high_nibbles(prev1));
+        auto const byte1Low =
+            _mm256_shuffle_epi8(avx2_table(Byte1Low), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+        auto const byte2High = _mm256_shuffle_epi8(avx2_table(Byte2High), avx2_high_nibbles(input));
+        auto const specialCases = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        auto const prev2 = avx2_prev<2>(input, previous);
+        auto const prev3 = avx2_prev<3>(input, previous);
+        auto const isThirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+        auto const isFourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        auto const mustBeContinuation =
+            _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+        return _mm256_xor_si256(mustBeContinuation, specialCases);
+    }
+
+    LIBUNICODE_TARGET_AVX2 size_t validate_avx2(uint8_t const* data, size_t size) noexcept
+    {
+        auto const incompleteMax = _mm256_loadu_si256((__m256i const*) (IncompleteMax + 32));
+        auto previous = _mm256_setzero_si256();
+        auto previousIncomplete = _mm256_setzero_si256();
+        size_t pos = 0;
+
+        for (; pos + 32 <= size; pos += 32)
+        {
+            auto const input = _mm256_loadu_si256((__m256i const*) (data + pos));
+            // An incomplete sequence at the end of the previous block is only an error
+            // if this block is US-ASCII only, otherwise it is covered by the checks on this block.
+            auto error = previousIncomplete;
+            if (_mm256_movemask_epi8(input) != 0)
+            {
+                error = avx2_check_block(input, previous);
+                previousIncomplete = _mm256_subs_epu8(input, incompleteMax);
+            }
+            if (!_mm256_testz_si256(error, error))
+                return validate_scalar(data, sequence_start(data, pos), size);
+            previous = input;
+        }
+
+        return validate_scalar(data, sequence_start(data, pos), size);
+    }
+    // }}}
+
+    // {{{ AVX-512
+    #define LIBUNICODE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+    // The lookup tables repeated for each 128-bit lane, loaded as a whole rather than broadcast
+    // by _mm512_broadcast_i32x4(), which GCC 12 warns about with -Wmaybe-uninitialized at -O2.
+    struct alignas(64) avx512_lookup_table
+    {
+        uint8_t bytes[64]; // NOLINT(modernize-avoid-c-arrays)
+    };
+
+    constexpr avx512_lookup_table repeat_lanes(uint8_t const (&table)[16]) noexcept // NOLINT(modernize-avoid-c-arrays)
+    {
+        auto result = avx512_lookup_table {};
+        for (size_t i = 0; i < sizeof(result.bytes); ++i)
+            result.bytes[i] = table[i % 16];
+        return result;
+    }
+
+    constexpr auto Byte1High512 = repeat_lanes(Byte1High);
+    constexpr auto Byte1Low512 = repeat_lanes(Byte1Low);
+    constexpr auto Byte2High512 = repeat_lanes(Byte2High);
+
+    LIBUNICODE_TARGET_AVX512 inline __m512i avx512_table(avx512_lookup_table const& table) noexcept
+    {
+        return _mm512_loadu_si512(table.bytes);
+    }
+
+    template <int N>
+    LIBUNICODE_TARGET_AVX512 inline __m512i avx512_prev(__m512i input, __m512i previous) noexcept
+    {
+        // Lane i of the permutation holds lane i-1 of the concatenation of previous and input.
+        auto const shifted = _mm512_permutex2var_epi64(previous, _mm512_set_epi64(13, 12, 11, 10, 9, 8, 7, 6), input);
+        return _mm512_alignr_epi8(input, shifted, 16 - N);
+    }
+
+    LIBUNICODE_TARGET_AVX512 inline __m512i avx512_high_nibbles(__m512i input) noexcept
+    {
+        return _mm512_and_si512(_mm512_srli_epi16(input, 4), _mm512_set1_epi8(0x0F));
+    }
+
+    LIBUNICODE_TARGET_AVX512 inline __m512i avx512_check_block(__m512i input, __m512i previous) noexcept
+    {
+        auto const prev1 = avx512_prev<1>(input, previous);
+        auto const byte1High = _mm512_shuffle_epi8(avx512_table(Byte1High512), avx512_high_nibbles(prev1));
+        auto const byte1Low =
+            _mm512_shuffle_epi8(avx512_table(Byte1Low512), _mm512_and_si512(prev1, _mm512_set1_epi8(0x0F)));
+        auto const byte2High = _mm512_shuffle_epi8(avx512_table(Byte2High512), avx512_high_nibbles(input));
+        auto const specialCases = _mm512_and_si512(_mm512_and_si512(byte1High, byte1Low), byte2High);
+
+        auto const prev2 = avx512_prev<2>(input, previous);
+        auto const prev3 = avx512_prev<3>(input, previous);
+        auto const isThirdByte = _mm512_subs_epu8(prev2, _mm512_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+        auto const isFourthByte = _mm512_subs_epu8(prev3, _mm512_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        auto const mustBeContinuation =
+            _mm512_and_si512(_mm512_or_si512(isThirdByte, isFourthByte), _mm512_set1_epi8(static_cast<char>(0x80)));
+
+        return _mm512_xor_si512(mustBeContinuation, specialCases);
+    }
+
+    LIBUNICODE_TARGET_AVX512 size_t validate_avx512(uint8_t const* data, size_t size) noexcept
+    {
+        auto const incompleteMax = _mm512_load_si512((__m512i const*) IncompleteMax);
+        auto previous = _mm512_setzero_si512();
+        auto previousIncomplete = _mm512_setzero_si512();
+        size_t pos = 0;
+
+        for (; pos + 64 <= size; pos += 64)
+        {
+            auto const input = _mm512_loadu_si512((__m512i const*) (data + pos));
+            // An incomplete sequence at the end of the previous block is only an error
+            // if this block is US-ASCII only, otherwise it is covered by the checks on this block.
+            auto error = previousIncomplete;
+            if (_mm512_movepi8_mask(input) != 0)
+            {
+                error = avx512_check_block(input, previous);
+                previousIncomplete = _mm512_subs_epu8(input, incompleteMax);
+            }
+            if (_mm512_test_epi8_mask(error, error) != 0)
+                return validate_scalar(data, sequence_start(data, pos), size);
+            previous = input;
+        }
+
+        return validate_scalar(data, sequence_start(data, pos), size);
+    }
+    // }}}
+#endif
+
+    using validate_function = size_t (*)(uint8_t const*, size_t) noexcept;
+
+    validate_function select_validator() noexcept
+    {
+#if defined(LIBUNICODE_UTF8_VALIDATE_AVX)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw"))
+            return validate_avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return validate_avx2;
+#endif
+        return validate_baseline;
+    }
+
+    size_t validate(string_view bytes) noexcept
+    {
+        static auto const validator = select_validator();
+        return validator(reinterpret_cast<uint8_t const*>(bytes.data()), bytes.size());
+    }
+
+    // Returns the number of bytes of the maximal subpart of the ill-formed sequence at @p pos.
+    size_t maximal_subpart(string_view bytes, size_t pos) noexcept
+    {
+        auto const data = reinterpret_cast<uint8_t const*>(bytes.data());
+        unsigned subpart = 1;
+        check_sequence(data + pos, data + bytes.size(), subpart);
+        return subpart;
+    }
+} // namespace
+
+bool detail::is_supported(utf8_validator validator) noexcept
+{
+    switch (validator)
+    {
+        case utf8_validator::Scalar:
+        case utf8_validator::Baseline: return true;
+#if defined(LIBUNICODE_UTF8_VALIDATE_AVX)
+        case utf8_validator::AVX2: __builtin_cpu_init(); return __builtin_cpu_supports("avx2");
+        case utf8_validator::AVX512: __builtin_cpu_init(); return __builtin_cpu_supports("avx512bw");
+#endif
+        default: return false;
+    }
+}
+
+size_t detail::utf8_validate(string_view bytes, utf8_validator validator) noexcept
+{
+    auto const data = reinterpret_cast<uint8_t const*>(bytes.data());
+    switch (validator)
+    {
+        case utf8_validator::Baseline: return validate_baseline(data, bytes.size());
+#if defined(LIBUNICODE_UTF8_VALIDATE_AVX)
+        case utf8_validator::AVX2: return validate_avx2(data, bytes.size());
+        case utf8_validator::AVX512: return validate_avx512(data, bytes.size());
+#endif
+        default: return validate_scalar(data, 0, bytes.size());
+    }
+}
+
+utf8_validation_result utf8_validate(string_view bytes) noexcept
+{
+    auto const offset = validate(bytes);
+    return { offset == bytes.size(), offset };
+}
+
+string_view utf8_sanitize(string_view bytes, string& storage)
+{
+    auto error = validate(bytes);
+    if (error == bytes.size())
+        return bytes;
+
+    storage.clear();
+    storage.reserve(bytes.size() + ReplacementCharacter.size());
+
+    size_t pos = 0;
+    while (error != bytes.size())
+    {
+        storage.append(bytes.substr(pos, error - pos));
+        storage.append(ReplacementCharacter);
+        pos = error + maximal_subpart(bytes, error);
+        error = pos + validate(bytes.substr(pos));
+    }
+    storage.append(bytes.substr(pos));
+
+    return storage;
+}
+
+string utf8_sanitize(string_view bytes)
+{
+    auto storage = string {};
+    auto const result = utf8_sanitize(bytes, storage);
+    if (result.data() == bytes.data())
+        return string(bytes);
+    return storage;
+}
+
+} // namespace unicode
@@ -0,0 +1,480 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/script_segmenter.h>
+#include <libunicode/ucd.h>
+#include <libunicode/utf8.h>
+#include <libunicode/width.h>
+#include <libunicode/word_segmenter.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <utility>
+
+/// Lazy C++20 range adaptors for decoding and segmenting text in a single pass,
+/// without materializing any intermediate buffers, such as:
+///
+/// @code
+/// for (auto const [cluster, width]: line | unicode::views::utf8_decode | unicode::views::graphemes
+///                                         | unicode::views::with_width)
+///     ...
+/// @endcode
+namespace unicode
+{
+
+/// A script run, as yielded by views::script_runs.
+template <typename Codepoints>
+struct script_run
+{
+    Script script;
+    Codepoints text;
+};
+
+/// A grapheme cluster along with the number of columns it occupies, as yielded by views::with_width.
+template <typename Cluster>
+struct grapheme_with_width
+{
+    Cluster cluster;
+    unsigned width;
+};
+
+/// Returns the number of columns the given grapheme cluster occupies.
+///
+/// That is, the width of its widest codepoint, or 2 if it contains VS16 (U+FE0F).
+template <std::ranges::input_range Cluster>
+unsigned grapheme_cluster_width(Cluster&& cluster) noexcept
+{
+    auto constexpr VS16 = char32_t { 0xFE0F };
+    auto result = 0u;
+    auto first = true;
+    for (char32_t const codepoint: cluster)
+    {
+        if (first)
+            result = width(codepoint);
+        else if (codepoint == VS16)
+            result = 2; // Increase width on VS16 but do not decrease on VS15.
+        else
+            result = std::max(result, width(codepoint));
+        first = false;
+    }
+    return result;
+}
+
+namespace detail
+{
+    template <typename First, typename Second>
+    struct composed_adaptor;
+
+    /// Base class of the range adaptor closure objects in unicode::views,
+    /// making them applicable via the pipe operator, as well as composable with each other.
+    template <typename Adaptor>
+    struct range_adaptor_closure
+    {
+        template <std::ranges::viewable_range R>
+            requires std::invocable<Adaptor const&, R>
+        friend constexpr auto operator|(R&& range, Adaptor const& adaptor)
+        {
+            return adaptor(std::forward<R>(range));
+        }
+
+        template <typename Other>
+            requires std::derived_from<Other, range_adaptor_closure<Other>>
+        friend constexpr auto operator|(Adaptor const& first, Other const& second)
+        {
+            return composed_adaptor<Adaptor, Other> { first, second };
+        }
+    };
+
+    template <typename First, typename Second>
+    struct composed_adaptor: range_adaptor_closure<composed_adaptor<First, Second>>
+    {
+        First first;
+        Second second;
+
+        constexpr composed_adaptor(First a, Second b): first { std::move(a) }, second { std::move(b) } {}
+
+        template <std::ranges::viewable_range R>
+        constexpr auto operator()(R&& range) const
+        {
+            return second(first(std::forward<R>(range)));
+        }
+    };
+
+    // {{{ segmentation policies for segment_view
+    struct grapheme_boundaries
+    {
+        grapheme_segmenter_state state {};
+
+        void start(char32_t codepoint) noexcept { grapheme_process_init(codepoint, state); }
+        bool breaks(char32_t codepoint) noexcept { return grapheme_process_breakable(codepoint, state); }
+        void finish() noexcept {}
+
+        template <typename Codepoints>
+        Codepoints value(Codepoints text) const noexcept
+        {
+            return text;
+        }
+    };
+
+    // Grapheme cluster boundaries, also measuring the width of each grapheme cluster while segmenting.
+    struct grapheme_width_boundaries
+    {
+        grapheme_segmenter_state state {};
+        unsigned columns = 0;
+
+        void start(char32_t codepoint) noexcept
+        {
+            grapheme_process_init(codepoint, state);
+            columns = width(codepoint);
+        }
+
+        bool breaks(char32_t codepoint) noexcept
+        {
+            if (grapheme_process_breakable(codepoint, state))
+                return true;
+            if (codepoint == 0xFE0F)
+                columns = 2; // Increase width on VS16 but do not decrease on VS15.
+            else
+                columns = std::max(columns, width(codepoint));
+            return false;
+        }
+
+        void finish() noexcept {}
+
+        template <typename Codepoints>
+        grapheme_with_width<Codepoints> value(Codepoints text) const noexcept
+        {
+            return { std::move(text), columns };
+        }
+    };
+
+    struct word_boundaries
+    {
+        bool delimiter = false;
+
+        void start(char32_t codepoint) noexcept { delimiter = word_segmenter::isDelimiter(codepoint); }
+        bool breaks(char32_t codepoint) noexcept { return word_segmenter::isDelimiter(codepoint) != delimiter; }
+        void finish() noexcept {}
+
+        template <typename Codepoints>
+        Codepoints value(Codepoints text) const noexcept
+        {
+            return text;
+        }
+    };
+
+    // Drives script_segmenter::process(), which has processed the first codepoint of the next run already
+    // when reporting the end of the current one.
+    struct script_boundaries
+    {
+        script_segmenter segmenter { std::u32string_view {} };
+        Script script = Script::Common; // resolved script of the current run, once complete
+        bool processed = false;         // whether the run's first codepoint has been processed by breaks() already
+
+        void start(char32_t codepoint)
+        {
+            if (!processed)
+                segmenter.process(codepoint);
+            processed = false;
+        }
+
+        bool breaks(char32_t codepoint)
+        {
+            auto const completed = segmenter.process(codepoint);
+            if (!completed.has_value())
+                return false;
+            script = completed.value();
+            processed = true;
+            return true;
+        }
+
+        void finish() noexcept { script = segmenter.current_script(); }
+
+        template <typename Codepoints>
+        script_run<Codepoints> value(Codepoints text) const noexcept
+        {
+            return { script, std::move(text) };
+        }
+    };
+    // }}}
+
+    /// View over the segments of the underlying range of codepoints, as determined by @p Policy.
+    template <std::ranges::view V, typename Policy>
+        requires std::ranges::forward_range<V> && std::convertible_to<std::ranges::range_reference_t<V>, char32_t>
+    class segment_view: public std::ranges::view_interface<segment_view<V, Policy>>
+    {
+      public:
+        class iterator;
+
+        segment_view()
+            requires std::default_initializable<V>
+        = default;
+
+        constexpr explicit segment_view(V base): _base { std::move(base) } {}
+
+        constexpr V base() const&
+            requires std::copy_constructible<V>
+        {
+            return _base;
+        }
+
+        constexpr iterator begin() { return iterator { std::ranges::begin(_base), std::ranges::end(_base) }; }
+        constexpr std::default_sentinel_t end() const noexcept { return {}; }
+
+      private:
+        V _base = V();
+    };
+
+    template <std::ranges::view V, typename Policy>
+        requires std::ranges::forward_range<V> && std::convertible_to<std::ranges::range_reference_t<V>, char32_t>
+    class segment_view<V, Policy>::iterator
+    {
+      public:
+        using base_iterator = std::ranges::iterator_t<V>;
+        using base_sentinel = std::ranges::sentinel_t<V>;
+        using segment_type = std::ranges::subrange<base_iterator>;
+
+        using value_type = decltype(std::declval<Policy const&>().value(segment_type {}));
+        using difference_type = std::ptrdiff_t;
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() = default;
+
+        constexpr iterator(base_iterator first, base_sentinel end):
+            _first { first }, _last { std::move(first) }, _end { std::move(end) }
+        {
+            advance();
+        }
+
+        constexpr value_type operator*() const { return _policy.value(segment_type { _first, _last }); }
+
+        constexpr iterator& operator++()
+        {
+            _first = _last;
+            advance();
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+
+        friend constexpr bool operator==(iterator const& a, iterator const& b) { return a._first == b._first; }
+        friend constexpr bool operator==(iterator const& a, std::default_sentinel_t) { return a._first == a._end; }
+
+      private:
+        // Moves _last to the end of the segment starting at _first.
+        constexpr void advance()
+        {
+            if (_last == _end)
+                return;
+
+            _policy.start(*_last);
+            ++_last;
+            while (_last != _end)
+            {
+                if (_policy.breaks(*_last))
+                    return;
+                ++_last;
+            }
+            _policy.finish();
+        }
+
+        base_iterator _first {};
+        base_iterator _last {};
+        base_sentinel _end {};
+        Policy _policy {};
+    };
+} // namespace detail
+
+/// View decoding the underlying range of UTF-8 bytes into codepoints.
+///
+/// Ill-formed UTF-8 sequences (including overlong encodings, surrogates and codepoints above U+10FFFF)
+/// are decoded as U+FFFD, one for each maximal subpart.
+template <std::ranges::view V>
+    requires std::ranges::forward_range<V> && std::same_as<std::ranges::range_value_t<V>, char>
+class utf8_decode_view: public std::ranges::view_interface<utf8_decode_view<V>>
+{
+  public:
+    class iterator;
+
+    utf8_decode_view()
+        requires std::default_initializable<V>
+    = default;
+
+    constexpr explicit utf8_decode_view(V base): _base { std::move(base) } {}
+
+    constexpr V base() const&
+        requires std::copy_constructible<V>
+    {
+        return _base;
+    }
+
+    constexpr iterator begin() { return iterator { std::ranges::begin(_base), std::ranges::end(_base) }; }
+    constexpr std::default_sentinel_t end() const noexcept { return {}; }
+
+  private:
+    V _base = V();
+};
+
+template <std::ranges::view V>
+    requires std::ranges::forward_range<V> && std::same_as<std::ranges::range_value_t<V>, char>
+class utf8_decode_view<V>::iterator
+{
+  public:
+    using base_iterator = std::ranges::iterator_t<V>;
+    using base_sentinel = std::ranges::sentinel_t<V>;
+
+    using value_type = char32_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+
+    iterator() = default;
+
+    constexpr iterator(base_iterator current, base_sentinel end):
+        _current { current }, _next { std::move(current) }, _end { std::move(end) }
+    {
+        decode();
+    }
+
+    constexpr char32_t operator*() const noexcept { return _codepoint; }
+
+    /// Returns the underlying iterator to the first byte of the current codepoint.
+    constexpr base_iterator const& base() const noexcept { return _current; }
+
+    constexpr iterator& operator++()
+    {
+        _current = _next;
+        decode();
+        return *this;
+    }
+
+    constexpr iterator operator++(int)
+    {
+        auto result = *this;
+        ++*this;
+        return result;
+    }
+
+    friend constexpr bool operator==(iterator const& a, iterator const& b) { return a._current == b._current; }
+    friend constexpr bool operator==(iterator const& a, std::default_sentinel_t) { return a._current == a._end; }
+
+  private:
+    // Decodes the codepoint starting at _current, moving _next behind it.
+    constexpr void decode()
+    {
+        auto constexpr ReplacementChar = char32_t { 0xFFFD };
+
+        if (_next == _end)
+            return;
+
+        _codepoint = detail::decode_utf8_sequence(_next, _end).value_or(ReplacementChar);
+    }
+
+    base_iterator _current {};
+    base_iterator _next {};
+    base_sentinel _end {};
+    char32_t _codepoint = 0;
+};
+
+/// View over the grapheme clusters of the underlying range of codepoints,
+/// each being a subrange of the underlying range.
+template <typename V>
+using grapheme_view = detail::segment_view<V, detail::grapheme_boundaries>;
+
+/// View over the words and the whitespace between them, of the underlying range of codepoints,
+/// as segmented by word_segmenter.
+template <typename V>
+using word_view = detail::segment_view<V, detail::word_boundaries>;
+
+/// View over the script runs of the underlying range of codepoints, as segmented by script_segmenter.
+template <typename V>
+using script_run_view = detail::segment_view<V, detail::script_boundaries>;
+
+namespace views
+{
+    namespace detail
+    {
+        template <template <typename> typename View>
+        struct view_adaptor: unicode::detail::range_adaptor_closure<view_adaptor<View>>
+        {
+            template <std::ranges::viewable_range R>
+            constexpr auto operator()(R&& range) const
+            {
+                return View<std::views::all_t<R>>(std::views::all(std::forward<R>(range)));
+            }
+        };
+
+        template <typename T>
+        struct is_grapheme_view: std::false_type
+        {
+        };
+
+        template <typename V>
+        struct is_grapheme_view<grapheme_view<V>>: std::true_type
+        {
+        };
+
+        struct with_width_adaptor: unicode::detail::range_adaptor_closure<with_width_adaptor>
+        {
+            template <std::ranges::viewable_range R>
+            constexpr auto operator()(R&& range) const
+            {
+                using view_type = std::views::all_t<R>;
+                if constexpr (is_grapheme_view<view_type>::value)
+                {
+                    // Measures the grapheme clusters while segmenting them, rather than decoding them twice.
+                    auto base = view_type(std::views::all(std::forward<R>(range))).base();
+                    using base_type = decltype(base);
+                    return unicode::detail::segment_view<base_type, unicode::detail::grapheme_width_boundaries>(
+                        std::move(base));
+                }
+                else
+                    return std::views::transform(std::forward<R>(range), [](auto cluster) {
+                        auto const columns = grapheme_cluster_width(cluster);
+                        return grapheme_with_width<decltype(cluster)> { std::move(cluster), columns };
+                    });
+            }
+        };
+    } // namespace detail
+
+    /// Decodes a range of UTF-8 bytes into codepoints.
+    inline constexpr detail::view_adaptor<utf8_decode_view> utf8_decode {};
+
+    /// Segments a range of codepoints into grapheme clusters.
+    inline constexpr detail::view_adaptor<grapheme_view> graphemes {};
+
+    /// Segments a range of codepoints into words and the whitespace between them.
+    inline constexpr detail::view_adaptor<word_view> words {};
+
+    /// Segments a range of codepoints into script_run%s.
+    inline constexpr detail::view_adaptor<script_run_view> script_runs {};
+
+    /// Pairs each grapheme cluster of a range of grapheme clusters with its width, see grapheme_with_width.
+    inline constexpr detail::with_width_adaptor with_width {};
+} // namespace views
+
+} // namespace unicode
@@ -0,0 +1,184 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/convert.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/script_segmenter.h>
+#include <libunicode/views.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string_view;
+using std::u32string;
+using std::u32string_view;
+using std::vector;
+
+using namespace std::string_view_literals;
+
+namespace views = unicode::views;
+
+namespace
+{
+template <std::ranges::input_range R>
+u32string collect(R&& codepoints)
+{
+    auto result = u32string {};
+    for (char32_t const codepoint: codepoints)
+        result += codepoint;
+    return result;
+}
+
+template <std::ranges::input_range R>
+vector<u32string> collect_segments(R&& segments)
+{
+    auto result = vector<u32string> {};
+    for (auto const& segment: segments)
+        result.emplace_back(collect(segment));
+    return result;
+}
+} // namespace
+
+static_assert(std::ranges::forward_range<decltype("abc"sv | views::utf8_decode)>);
+static_assert(std::ranges::view<decltype("abc"sv | views::utf8_decode | views::graphemes)>);
+
+TEST_CASE("views.utf8_decode")
+{
+    CHECK(collect(""sv | views::utf8_decode).empty());
+    CHECK(collect("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"sv | views::utf8_decode) == U"aé€\U0001F600");
+
+    // Ill-formed sequences are decoded as U+FFFD, one for each maximal subpart.
+    CHECK(collect("\xC3" "a\x80"sv | views::utf8_decode) == U"\uFFFDa\uFFFD");
+    CHECK(collect("\xE2\x82"sv | views::utf8_decode) == U"\uFFFD");
+    CHECK(collect("\xE2\x82\xF0\x9F\x98\x80"sv | views::utf8_decode) == U"\uFFFD\U0001F600");
+
+    // Sequences that are not well-formed as per Unicode (Table 3-7).
+    CHECK(collect("\xC0\xAF"sv | views::utf8_decode) == U"\uFFFD\uFFFD");                     // overlong
+    CHECK(collect("\xE0\x80\xAF"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD");           // overlong
+    CHECK(collect("\xF0\x80\x80\xAF"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD\uFFFD");  // overlong
+    CHECK(collect("\xED\xA0\x80"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD");           // surrogate
+    CHECK(collect("\xF4\x90\x80\x80"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD\uFFFD");  // > U+10FFFF
+    CHECK(collect("\xF5\x80\x80\x80"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD\uFFFD");  // invalid lead
+    CHECK(collect("\xF7\xBF\xBF\xBF"sv | views::utf8_decode) == U"\uFFFD\uFFFD\uFFFD\uFFFD");  // invalid lead
+    CHECK(collect("\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF"sv | views::utf8_decode) == U"\uD7FF\uE000\U0010FFFF");
+
+    // The same number of U+FFFD as inserted by utf8_sanitize(), on the invalid UTF-8 corpus' sequences.
+    for (auto const invalid: { "\xFF"sv, "\xC0\xAF"sv, "\xE2\x82"sv, "\xED\xA0\x80"sv, "\x80\x80"sv, "\xF4\x90\x80\x80"sv })
+    {
+        auto const text = std::string("a") + std::string(invalid) + "z";
+        CHECK(collect(text | views::utf8_decode) == collect(unicode::utf8_sanitize(text) | views::utf8_decode));
+    }
+
+    // The underlying iterator points to the first byte of the current codepoint.
+    auto const text = "a\xC3\xA9z"sv;
+    auto decoded = text | views::utf8_decode;
+    auto i = std::ranges::next(decoded.begin());
+    CHECK(*i == U'é');
+    CHECK(i.base() == text.begin() + 1);
+    CHECK(std::ranges::next(i).base() == text.begin() + 3);
+}
+
+TEST_CASE("views.graphemes")
+{
+    auto const text = "X\xF0\x9F\xA4\xA6\xF0\x9F\x8F\xBC\xE2\x80\x8D\xE2\x99\x82\xEF\xB8\x8F"
+                      "5\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA"
+                      "e\xCC\x81"sv;
+    auto const expected = vector<u32string> {
+        U"X", U"\U0001F926\U0001F3FC‍♂️", U"5", U"\U0001F1E9\U0001F1EA", U"é",
+    };
+    CHECK(collect_segments(text | views::utf8_decode | views::graphemes) == expected);
+
+    // Same as grapheme_segmenter on materialized UTF-32.
+    auto const text32 = unicode::convert_to<char32_t>(text);
+    auto materialized = vector<u32string> {};
+    for (auto segmenter = unicode::grapheme_segmenter(text32); segmenter.codepointsAvailable() || !(*segmenter).empty();
+         ++segmenter)
+        materialized.emplace_back(*segmenter);
+    CHECK(materialized == expected);
+
+    // Adaptors compose, with each other as well as with the standard ones.
+    auto const clusters = views::utf8_decode | views::graphemes;
+    CHECK(collect_segments(text | clusters | std::views::take(2)) == vector<u32string> { expected[0], expected[1] });
+    CHECK(collect_segments(text | clusters | std::views::filter([](auto cluster) { return std::ranges::distance(cluster) > 1; }))
+          == vector<u32string> { expected[1], expected[3], expected[4] });
+}
+
+TEST_CASE("views.words")
+{
+    auto const words = collect_segments(U"Hello,  World\tfoo"sv | views::words);
+    CHECK(words == vector<u32string> { U"Hello,", U"  ", U"World", U"\t", U"foo" });
+
+    CHECK(collect_segments(" a"sv | views::utf8_decode | views::words) == vector<u32string> { U" ", U"a" });
+    CHECK(collect_segments(U""sv | views::words).empty());
+}
+
+TEST_CASE("views.script_runs")
+{
+    auto const text = U"λ 合気道 λ;"sv;
+
+    auto runs = vector<std::pair<unicode::Script, u32string>> {};
+    for (auto const& run: text | views::script_runs)
+        runs.emplace_back(run.script, collect(run.text));
+
+    auto expected = vector<std::pair<unicode::Script, u32string>> {};
+    auto segmenter = unicode::script_segmenter { text };
+    size_t offset = 0;
+    while (auto const result = segmenter.consume())
+    {
+        expected.emplace_back(result->script, u32string(text.substr(offset, result->size - offset)));
+        offset = result->size;
+    }
+
+    REQUIRE(runs.size() == 3);
+    CHECK(runs == expected);
+    CHECK(runs[0] == std::pair { unicode::Script::Greek, u32string(U"λ ") });
+    CHECK(runs[1] == std::pair { unicode::Script::Han, u32string(U"合気道 ") });
+    CHECK(runs[2] == std::pair { unicode::Script::Greek, u32string(U"λ;") });
+}
+
+TEST_CASE("views.with_width")
+{
+    // Takes the grapheme clusters fitting into the first 4 columns.
+    auto const text = "a\xE4\xBD\xA0\xE2\x9D\xA4\xEF\xB8\x8F"
+                      "b"sv;
+    size_t columns = 0;
+    auto const fitting = [&](auto const& cluster) {
+        columns += cluster.width;
+        return columns <= 4;
+    };
+
+    auto widths = vector<unsigned> {};
+    auto clusters = vector<u32string> {};
+    for (auto const& [cluster, width]:
+         text | views::utf8_decode | views::graphemes | views::with_width | std::views::take_while(fitting))
+    {
+        clusters.emplace_back(collect(cluster));
+        widths.push_back(width);
+    }
+    CHECK(clusters == vector<u32string> { U"a", U"你" });
+    CHECK(widths == vector<unsigned> { 1, 2 });
+
+    // Also applicable to any range of grapheme clusters.
+    auto const precomputed = vector<u32string_view> { U"a", U"你", U"❤️" };
+    widths.clear();
+    for (auto const& [cluster, width]: precomputed | views::with_width)
+        widths.push_back(width);
+    CHECK(widths == vector<unsigned> { 1, 2, 2 });
+
+    CHECK(unicode::grapheme_cluster_width(U"❤️"sv) == 2);
+    CHECK(unicode::grapheme_cluster_width(U""sv) == 0);
+}
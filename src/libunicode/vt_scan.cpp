@@ -0,0 +1,478 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/scan.h>
+#include <libunicode/utf8.h>
+#include <libunicode/vt_scan.h>
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using std::string_view;
+
+namespace unicode
+{
+
+namespace
+{
+    using mode = vt_scan_state::mode;
+
+    auto constexpr BEL = uint8_t { 0x07 };
+    auto constexpr CAN = uint8_t { 0x18 };
+    auto constexpr SUB = uint8_t { 0x1A };
+    auto constexpr ESC = uint8_t { 0x1B };
+    auto constexpr C1Lead = uint8_t { 0xC2 };
+    auto constexpr Unlimited = std::numeric_limits<size_t>::max();
+
+    // Bytes of an ESC carried over from the previous input.
+    char constexpr CarriedEscape[] = { '\033' }; // NOLINT(modernize-avoid-c-arrays)
+
+    constexpr uint8_t byte(char ch) noexcept
+    {
+        return static_cast<uint8_t>(ch);
+    }
+
+    constexpr bool is_c1(uint8_t value) noexcept
+    {
+        return 0x80 <= value && value <= 0x9F;
+    }
+
+    constexpr bool is_cancel(uint8_t value) noexcept
+    {
+        return value == CAN || value == SUB;
+    }
+
+    // Finds the next UTF-8 encoded C1 control character (or a trailing C1 lead byte).
+    char const* find_c1(char const* input, char const* end) noexcept
+    {
+        while (input != end)
+        {
+            auto const p = static_cast<char const*>(std::memchr(input, C1Lead, static_cast<size_t>(end - input)));
+            if (!p)
+                return end;
+            if (p + 1 == end || is_c1(byte(p[1])))
+                return p;
+            input = p + 2;
+        }
+        return end;
+    }
+
+    class vt_scanner
+    {
+      public:
+        vt_scanner(vt_scan_state& state, string_view text, std::span<vt_event> events) noexcept:
+            _state { state },
+            _input { text.data() },
+            _end { text.data() + text.size() },
+            _sequenceStart { text.data() },
+            _nextC1 { find_c1(_input, _end) },
+            _events { events }
+        {
+            assert(events.size() >= MinimumVTEventBatchSize);
+        }
+
+        vt_scan_result run() noexcept
+        {
+            // Each step emits at most two events, and one more may be needed to flush an incomplete sequence.
+            while (_input != _end && _events.size() - _eventCount >= MinimumVTEventBatchSize)
+                step();
+
+            if (inSequence() && _input != _sequenceStart)
+                emit(_state.sequenceType, _sequenceStart, _input, 0, false);
+
+            return { _eventCount, _input };
+        }
+
+      private:
+        [[nodiscard]] bool inSequence() const noexcept
+        {
+            return _state.current != mode::Ground && _state.current != mode::GroundC1Lead;
+        }
+
+        void step() noexcept
+        {
+            switch (_state.current)
+            {
+                case mode::Ground: ground(); break;
+                case mode::GroundC1Lead: groundC1Lead(); break;
+                case mode::Escape:
+                case mode::EscapeIntermediate: escape(); break;
+                case mode::ControlSequence: controlSequence(); break;
+                case mode::ControlString: controlString(); break;
+                case mode::ControlStringEscape: controlStringEscape(); break;
+                case mode::ControlStringC1Lead: controlStringC1Lead(); break;
+            }
+        }
+
+        void ground() noexcept
+        {
+            auto const ch = byte(*_input);
+            if (ch == ESC)
+            {
+                if (controlSequenceFastPath())
+                    return;
+                beginSequence(vt_event_type::Escape, mode::Escape, _input);
+                ++_input;
+                return;
+            }
+
+            if (ch < 0x20)
+            {
+                resetText();
+                auto const start = _input;
+                skipControls();
+                emit(vt_event_type::Control, start, _input, 0, true);
+                return;
+            }
+
+            if (_nextC1 < _input)
+                _nextC1 = find_c1(_input, _end);
+
+            if (_input == _nextC1)
+            {
+                if (_input + 1 == _end)
+                {
+                    // Cannot tell yet whether this is a C1 control or a regular codepoint.
+                    _state.current = mode::GroundC1Lead;
+                    ++_input;
+                    return;
+                }
+                c1(_input, _input + 2, byte(_input[1]));
+                return;
+            }
+
+            text();
+        }
+
+        // Scans a complete "ESC [ ... F" control sequence (by far the most common one, e.g. SGR) in one go.
+        bool controlSequenceFastPath() noexcept
+        {
+            auto p = _input + 1;
+            if (p == _end || *p != '[')
+                return false;
+
+            ++p;
+            while (p != _end && 0x20 <= byte(*p) && byte(*p) <= 0x3F)
+                ++p;
+
+            if (p == _end || byte(*p) < 0x40 || byte(*p) > 0x7E)
+                return false;
+
+            ++p;
+            resetText();
+            emit(vt_event_type::ControlSequence, _input, p, 0, true);
+            _input = p;
+            return true;
+        }
+
+        void groundC1Lead() noexcept
+        {
+            _state.current = mode::Ground;
+            if (auto const ch = byte(*_input); is_c1(ch))
+            {
+                c1(_input, _input + 1, ch);
+                return;
+            }
+
+            // Not a C1 control, so feed the lead byte to the text scanner.
+            from_utf8(_state.text.utf8, C1Lead);
+        }
+
+        void text() noexcept
+        {
+            auto const stop = _nextC1;
+            if (_state.text.utf8.expectedLength == 0 && byte(*_input) < 0x80)
+            {
+                // Fast path for US-ASCII text, directly using the SIMD scanner.
+                auto const count = detail::scan_for_text_ascii(string_view(_input, static_cast<size_t>(stop - _input)), Unlimited);
+                auto const start = _input;
+                _input += count;
+                if (_input == stop || byte(*_input) < 0x80)
+                {
+                    emit(vt_event_type::Text, start, _input, count, true);
+                    return;
+                }
+
+                // Continue the same text run with the non-ASCII remainder.
+                _state.text.next = _input;
+                auto const result = scan_text(_state.text, string_view(_input, static_cast<size_t>(stop - _input)), Unlimited);
+                emit(vt_event_type::Text, start, result.end, count + result.count, true);
+                _input = _state.text.next;
+                return;
+            }
+
+            // When resuming an incomplete UTF-8 sequence, scan_text() reports a start pointing into the previous input.
+            auto const resuming = _state.text.utf8.expectedLength != 0;
+
+            _state.text.next = _input;
+            auto const result = scan_text(_state.text, string_view(_input, static_cast<size_t>(_nextC1 - _input)), Unlimited);
+            assert(_input < _state.text.next);
+
+            auto const start = resuming ? _input : result.start;
+            auto const end = resuming && result.end < start ? start : result.end;
+            if (start != end || result.count)
+                emit(vt_event_type::Text, start, end, result.count, true);
+
+            _input = _state.text.next;
+        }
+
+        void c1(char const* from, char const* to, uint8_t value) noexcept
+        {
+            switch (value)
+            {
+                case 0x9B: beginSequence(vt_event_type::ControlSequence, mode::ControlSequence, from); break;
+                case 0x9D: beginSequence(vt_event_type::OperatingSystemCommand, mode::ControlString, from); break;
+                case 0x90: // DCS
+                case 0x98: // SOS
+                case 0x9E: // PM
+                case 0x9F: // APC
+                    beginSequence(vt_event_type::ControlString, mode::ControlString, from);
+                    break;
+                default:
+                    resetText();
+                    emit(vt_event_type::Control, from, to, 0, true);
+                    break;
+            }
+            _input = to;
+        }
+
+        void escape() noexcept
+        {
+            auto const ch = byte(*_input);
+            if (interrupted(ch))
+                return;
+
+            ++_input;
+            if (ch <= 0x2F)
+            {
+                _state.current = mode::EscapeIntermediate;
+                return;
+            }
+
+            if (ch == 0x7F)
+                return;
+
+            if (_state.current == mode::Escape)
+            {
+                switch (ch)
+                {
+                    case '[': enter(vt_event_type::ControlSequence, mode::ControlSequence); return;
+                    case ']': enter(vt_event_type::OperatingSystemCommand, mode::ControlString); return;
+                    case 'P': // DCS
+                    case 'X': // SOS
+                    case '^': // PM
+                    case '_': // APC
+                        enter(vt_event_type::ControlString, mode::ControlString);
+                        return;
+                    default: break;
+                }
+            }
+
+            completeSequence(_input);
+        }
+
+        void controlSequence() noexcept
+        {
+            // Parameter and intermediate bytes.
+            while (_input != _end && 0x20 <= byte(*_input) && byte(*_input) <= 0x3F)
+                ++_input;
+
+            if (_input == _end)
+                return;
+
+            auto const ch = byte(*_input);
+            if (interrupted(ch))
+                return;
+
+            ++_input;
+            if (ch != 0x7F)
+                completeSequence(_input);
+        }
+
+        void controlString() noexcept
+        {
+            auto const acceptsBell = _state.sequenceType == vt_event_type::OperatingSystemCommand;
+            while (_input != _end)
+            {
+                auto const ch = byte(*_input++);
+                switch (ch)
+                {
+                    case ESC:
+                        if (_input == _end)
+                        {
+                            // Whether the ESC belongs to this string is only known with the next input.
+                            if (_input - 1 != _sequenceStart)
+                                emit(_state.sequenceType, _sequenceStart, _input - 1, 0, false);
+                            _sequenceStart = _input;
+                            _state.current = mode::ControlStringEscape;
+                            return;
+                        }
+                        if (*_input == '\\')
+                        {
+                            ++_input;
+                            completeSequence(_input);
+                            return;
+                        }
+                        // Any other escape sequence cancels the control string.
+                        completeSequence(_input - 1);
+                        beginSequence(vt_event_type::Escape, mode::Escape, _input - 1);
+                        return;
+                    case C1Lead:
+                        if (_input == _end)
+                        {
+                            _state.current = mode::ControlStringC1Lead;
+                            return;
+                        }
+                        if (byte(*_input) == 0x9C) // ST
+                        {
+                            ++_input;
+                            completeSequence(_input);
+                            return;
+                        }
+                        break;
+                    case BEL:
+                        if (acceptsBell)
+                        {
+                            completeSequence(_input);
+                            return;
+                        }
+                        break;
+                    case CAN:
+                    case SUB: completeSequence(_input); return;
+                    default: break;
+                }
+            }
+        }
+
+        void controlStringEscape() noexcept
+        {
+            auto const escape = string_view(CarriedEscape, sizeof(CarriedEscape));
+            if (*_input == '\\')
+            {
+                _events[_eventCount++] = vt_event { _state.sequenceType, false, 0, escape };
+                ++_input;
+                completeSequence(_input);
+                return;
+            }
+
+            // The ESC received with the previous input cancels the control string and starts a new escape sequence.
+            emit(vt_event_type::Cancel, _input, _input, 0, true);
+            beginSequence(vt_event_type::Escape, mode::Escape, _input);
+            _events[_eventCount++] = vt_event { vt_event_type::Escape, false, 0, escape };
+        }
+
+        void controlStringC1Lead() noexcept
+        {
+            _state.current = mode::ControlString;
+            if (byte(*_input) == 0x9C) // ST
+            {
+                ++_input;
+                completeSequence(_input);
+            }
+        }
+
+        // Handles bytes that interrupt an escape or control sequence.
+        // Returns true if the byte at the current input position was handled.
+        bool interrupted(uint8_t ch) noexcept
+        {
+            if (ch == ESC)
+            {
+                completeSequence(_input);
+                beginSequence(vt_event_type::Escape, mode::Escape, _input);
+                ++_input;
+                return true;
+            }
+
+            if (is_cancel(ch))
+            {
+                ++_input;
+                completeSequence(_input);
+                return true;
+            }
+
+            if (ch < 0x20)
+            {
+                // C0 controls embedded into a sequence are executed immediately.
+                if (_input != _sequenceStart)
+                    emit(_state.sequenceType, _sequenceStart, _input, 0, false);
+                auto const start = _input;
+                skipControls();
+                emit(vt_event_type::Control, start, _input, 0, true);
+                _sequenceStart = _input;
+                return true;
+            }
+
+            if (ch >= 0x80)
+            {
+                // Malformed sequence. Complete it and process the byte in ground state.
+                completeSequence(_input);
+                return true;
+            }
+
+            return false;
+        }
+
+        void skipControls() noexcept
+        {
+            while (_input != _end && byte(*_input) < 0x20 && byte(*_input) != ESC
+                   && (!inSequence() || !is_cancel(byte(*_input))))
+                ++_input;
+        }
+
+        void beginSequence(vt_event_type type, mode next, char const* start) noexcept
+        {
+            resetText();
+            _sequenceStart = start;
+            enter(type, next);
+        }
+
+        void enter(vt_event_type type, mode next) noexcept
+        {
+            _state.sequenceType = type;
+            _state.current = next;
+        }
+
+        void completeSequence(char const* end) noexcept
+        {
+            emit(_state.sequenceType, _sequenceStart, end, 0, true);
+            _state.current = mode::Ground;
+        }
+
+        void resetText() noexcept
+        {
+            _state.text.utf8 = {};
+            _state.text.lastCodepointHint = 0;
+        }
+
+        void emit(vt_event_type type, char const* start, char const* end, size_t columns, bool complete) noexcept
+        {
+            _events[_eventCount++] = vt_event { type, complete, columns, string_view(start, static_cast<size_t>(end - start)) };
+        }
+
+        vt_scan_state& _state;
+        char const* _input;
+        char const* const _end;
+        char const* _sequenceStart;
+        char const* _nextC1;
+        std::span<vt_event> _events;
+        size_t _eventCount = 0;
+    };
+} // namespace
+
+vt_scan_result scan_vt(vt_scan_state& state, string_view text, std::span<vt_event> events) noexcept
+{
+    return vt_scanner(state, text, events).run();
+}
+
+} // namespace unicode
@@ -0,0 +1,141 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <libunicode/scan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace unicode
+{
+
+/// Classifies a span of bytes as emitted by scan_vt().
+enum class vt_event_type : uint8_t
+{
+    /// Printable text, as scanned by scan_text().
+    Text,
+
+    /// One or more consecutive C0 control characters (except ESC), or a single C1 control character.
+    Control,
+
+    /// Escape sequence: ESC, intermediate bytes (0x20..0x2F) and a final byte (0x30..0x7E).
+    Escape,
+
+    /// Control sequence: CSI, parameter and intermediate bytes (0x20..0x3F) and a final byte (0x40..0x7E).
+    ControlSequence,
+
+    /// Operating system command: OSC, followed by its payload, terminated by ST or BEL.
+    OperatingSystemCommand,
+
+    /// DCS, SOS, PM or APC, followed by its payload, terminated by ST.
+    ControlString,
+
+    /// Ends the incomplete OSC or control string of the preceding events without completing it, with no bytes.
+    ///
+    /// Emitted when the ESC at the end of the previous input does not start the ST terminating the string,
+    /// but an escape sequence cancelling it.
+    Cancel,
+};
+
+/// A single event emitted by scan_vt(), referring to a span of the scanned input.
+struct vt_event
+{
+    vt_event_type type;
+
+    /// Indicates whether or not this event ends the sequence.
+    ///
+    /// A sequence may be split into multiple events of the same kind if it spans multiple calls to scan_vt(),
+    /// or if C0 control characters are embedded into an escape or control sequence.
+    /// The type of the final (complete) event is authoritative, as the type may only be known after
+    /// the introducer has been fully seen (e.g. ESC followed by '[' in the next call).
+    /// Text and control events are always complete.
+    bool complete;
+
+    /// Number of columns of a text event. Zero for all other event types.
+    size_t columns;
+
+    /// The bytes this event refers to, which are part of the input passed to scan_vt().
+    ///
+    /// A text event that completes a UTF-8 sequence started in the previous call
+    /// therefore begins with the remaining bytes of that sequence.
+    /// The only exception is an ESC at the end of the previous input within an OSC or control string,
+    /// which is emitted as event of its own with the next input, referring to static storage,
+    /// once it is known whether it starts the terminating ST or a new escape sequence.
+    std::string_view bytes;
+};
+
+/// Holds the state to keep through a consecutive sequence of calls to scan_vt().
+struct vt_scan_state
+{
+    enum class mode : uint8_t
+    {
+        Ground,
+        GroundC1Lead,
+        Escape,
+        EscapeIntermediate,
+        ControlSequence,
+        ControlString,
+        ControlStringEscape, // ESC at the end of the previous input within a control string
+        ControlStringC1Lead,
+    };
+
+    /// State of the text scanner used for the text runs between control characters.
+    scan_state text {};
+
+    mode current = mode::Ground;
+
+    /// Type of the sequence currently being scanned, if not in ground state.
+    vt_event_type sequenceType = vt_event_type::Text;
+};
+
+/// Holds the result of a call to scan_vt().
+struct vt_scan_result
+{
+    /// Number of events written into the event buffer.
+    size_t eventCount;
+
+    /// Pointer to one byte after the last processed byte.
+    /// This is the end of the input, unless the event buffer was exhausted.
+    char const* next;
+};
+
+/// Minimum number of events the event buffer passed to scan_vt() must be able to hold.
+constexpr size_t MinimumVTEventBatchSize = 3;
+
+/// Scans a sequence of UTF-8 encoded bytes as written to a terminal, that is,
+/// text interleaved with C0/C1 control characters and escape, control sequences, and control strings.
+///
+/// In contrast to scan_text(), this function does not stop at control characters,
+/// but emits an event for each text run and each control character or sequence,
+/// so that a single call can process a full read from the PTY.
+///
+/// Text runs are scanned with scan_text() and thus benefit from the SIMD fast path for US-ASCII.
+/// C1 control characters are recognized in their UTF-8 encoded form (U+0080..U+009F).
+///
+/// Incomplete sequences at the end of the input are emitted as incomplete events and are continued
+/// in the next call with the help of the passed state. Incomplete UTF-8 sequences are resumed
+/// the same way as with scan_text().
+///
+/// @param state   scanner state to be kept between consecutive calls
+/// @param text    input bytes to scan
+/// @param events  event buffer to write to, holding at least MinimumVTEventBatchSize elements.
+///
+/// @return number of events written and the position to resume scanning from,
+///         which is the end of the input unless the event buffer got exhausted.
+vt_scan_result scan_vt(vt_scan_state& state, std::string_view text, std::span<vt_event> events) noexcept;
+
+} // namespace unicode
@@ -0,0 +1,230 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <libunicode/vt_scan.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+using std::string_view;
+using std::vector;
+
+using namespace std::string_view_literals;
+
+using unicode::vt_event;
+using unicode::vt_event_type;
+
+namespace
+{
+
+vector<vt_event> scan(unicode::vt_scan_state& state, string_view text)
+{
+    auto events = std::array<vt_event, 16> {};
+    auto collected = vector<vt_event> {};
+    while (!text.empty())
+    {
+        auto const result = unicode::scan_vt(state, text, events);
+        collected.insert(collected.end(), events.begin(), events.begin() + static_cast<long>(result.eventCount));
+        text.remove_prefix(static_cast<size_t>(result.next - text.data()));
+    }
+    return collected;
+}
+
+vector<vt_event> scan(string_view text)
+{
+    auto state = unicode::vt_scan_state {};
+    return scan(state, text);
+}
+
+void checkEvent(vt_event const& event, vt_event_type type, string_view bytes, bool complete = true)
+{
+    CHECK(event.type == type);
+    CHECK(event.bytes == bytes);
+    CHECK(event.complete == complete);
+}
+
+} // namespace
+
+TEST_CASE("vt_scan.text")
+{
+    auto const events = scan("Hello"sv);
+    REQUIRE(events.size() == 1);
+    checkEvent(events[0], vt_event_type::Text, "Hello");
+    CHECK(events[0].columns == 5);
+}
+
+TEST_CASE("vt_scan.sgr")
+{
+    auto const events = scan("\033[1;31mred\033[0m\r\n"sv);
+    REQUIRE(events.size() == 4);
+    checkEvent(events[0], vt_event_type::ControlSequence, "\033[1;31m");
+    checkEvent(events[1], vt_event_type::Text, "red");
+    CHECK(events[1].columns == 3);
+    checkEvent(events[2], vt_event_type::ControlSequence, "\033[0m");
+    checkEvent(events[3], vt_event_type::Control, "\r\n");
+}
+
+TEST_CASE("vt_scan.escape")
+{
+    auto const events = scan("\033(B\0337"sv);
+    REQUIRE(events.size() == 2);
+    checkEvent(events[0], vt_event_type::Escape, "\033(B");
+    checkEvent(events[1], vt_event_type::Escape, "\0337");
+}
+
+TEST_CASE("vt_scan.osc")
+{
+    auto const events = scan("\033]0;title\a\033]2;\xC3\xA4\033\\x"sv);
+    REQUIRE(events.size() == 3);
+    checkEvent(events[0], vt_event_type::OperatingSystemCommand, "\033]0;title\a");
+    checkEvent(events[1], vt_event_type::OperatingSystemCommand, "\033]2;\xC3\xA4\033\\");
+    checkEvent(events[2], vt_event_type::Text, "x");
+}
+
+TEST_CASE("vt_scan.dcs")
+{
+    auto const events = scan("\033Pq#0\a;1\033\\"sv);
+    REQUIRE(events.size() == 1);
+    checkEvent(events[0], vt_event_type::ControlString, "\033Pq#0\a;1\033\\");
+}
+
+TEST_CASE("vt_scan.c1")
+{
+    auto const events = scan("\xC2\x9B"
+                             "1mx\xC2\x85\xC2\xA9"sv);
+    REQUIRE(events.size() == 4);
+    checkEvent(events[0], vt_event_type::ControlSequence, "\xC2\x9B"
+                                                          "1m");
+    checkEvent(events[1], vt_event_type::Text, "x");
+    checkEvent(events[2], vt_event_type::Control, "\xC2\x85");
+    checkEvent(events[3], vt_event_type::Text, "\xC2\xA9");
+    CHECK(events[3].columns == 1);
+}
+
+TEST_CASE("vt_scan.embedded_control")
+{
+    auto const events = scan("\033[1\n2m"sv);
+    REQUIRE(events.size() == 3);
+    checkEvent(events[0], vt_event_type::ControlSequence, "\033[1", false);
+    checkEvent(events[1], vt_event_type::Control, "\n");
+    checkEvent(events[2], vt_event_type::ControlSequence, "2m");
+}
+
+TEST_CASE("vt_scan.cancel")
+{
+    auto const events = scan("\033[1\030a"sv);
+    REQUIRE(events.size() == 2);
+    checkEvent(events[0], vt_event_type::ControlSequence, "\033[1\030");
+    checkEvent(events[1], vt_event_type::Text, "a");
+}
+
+TEST_CASE("vt_scan.split_sequence")
+{
+    auto state = unicode::vt_scan_state {};
+    auto const first = scan(state, "ab\033"sv);
+    REQUIRE(first.size() == 2);
+    checkEvent(first[0], vt_event_type::Text, "ab");
+    checkEvent(first[1], vt_event_type::Escape, "\033", false);
+
+    auto const second = scan(state, "[3"sv);
+    REQUIRE(second.size() == 1);
+    checkEvent(second[0], vt_event_type::ControlSequence, "[3", false);
+
+    auto const third = scan(state, "1mA"sv);
+    REQUIRE(third.size() == 2);
+    checkEvent(third[0], vt_event_type::ControlSequence, "1m");
+    checkEvent(third[1], vt_event_type::Text, "A");
+}
+
+TEST_CASE("vt_scan.split_c1")
+{
+    auto state = unicode::vt_scan_state {};
+    auto const first = scan(state, "a\xC2"sv);
+    REQUIRE(first.size() == 1);
+    checkEvent(first[0], vt_event_type::Text, "a");
+
+    auto const second = scan(state, "\x9B"
+                                    "0m"sv);
+    REQUIRE(second.size() == 1);
+    checkEvent(second[0], vt_event_type::ControlSequence, "\x9B"
+                                                          "0m");
+}
+
+TEST_CASE("vt_scan.split_control_string_escape")
+{
+    auto state = unicode::vt_scan_state {};
+    auto const first = scan(state, "\033]0;title\033"sv);
+    REQUIRE(first.size() == 1);
+    checkEvent(first[0], vt_event_type::OperatingSystemCommand, "\033]0;title", false);
+
+    // ST
+    auto const second = scan(state, "\\x"sv);
+    REQUIRE(second.size() == 3);
+    checkEvent(second[0], vt_event_type::OperatingSystemCommand, "\033", false);
+    checkEvent(second[1], vt_event_type::OperatingSystemCommand, "\\");
+    checkEvent(second[2], vt_event_type::Text, "x");
+
+    // Cancelled by another escape sequence.
+    auto const third = scan(state, "\033Pq\033"sv);
+    REQUIRE(third.size() == 1);
+    checkEvent(third[0], vt_event_type::ControlString, "\033Pq", false);
+
+    auto const fourth = scan(state, "[1mA"sv);
+    REQUIRE(fourth.size() == 4);
+    checkEvent(fourth[0], vt_event_type::Cancel, "");
+    checkEvent(fourth[1], vt_event_type::Escape, "\033", false);
+    checkEvent(fourth[2], vt_event_type::ControlSequence, "[1m");
+    checkEvent(fourth[3], vt_event_type::Text, "A");
+
+    // Nothing but the ESC.
+    auto const fifth = scan(state, "\033Pq"sv);
+    REQUIRE(fifth.size() == 1);
+    CHECK(scan(state, "\033"sv).empty());
+    auto const sixth = scan(state, "7"sv);
+    REQUIRE(sixth.size() == 3);
+    checkEvent(sixth[0], vt_event_type::Cancel, "");
+    checkEvent(sixth[1], vt_event_type::Escape, "\033", false);
+    checkEvent(sixth[2], vt_event_type::Escape, "7");
+}
+
+TEST_CASE("vt_scan.split_utf8")
+{
+    auto state = unicode::vt_scan_state {};
+    auto const first = scan(state, "a\xF0\x9F"sv);
+    REQUIRE(first.size() == 1);
+    checkEvent(first[0], vt_event_type::Text, "a");
+
+    auto const second = scan(state, "\x98\x80\033[m"sv);
+    REQUIRE(second.size() == 2);
+    checkEvent(second[0], vt_event_type::Text, "\x98\x80");
+    CHECK(second[0].columns == 2);
+    checkEvent(second[1], vt_event_type::ControlSequence, "\033[m");
+}
+
+TEST_CASE("vt_scan.batch_exhausted")
+{
+    auto state = unicode::vt_scan_state {};
+    auto events = std::array<vt_event, unicode::MinimumVTEventBatchSize> {};
+    auto const text = "a\rb\rc\r"sv;
+
+    auto const result = unicode::scan_vt(state, text, events);
+    CHECK(result.eventCount == 1);
+    CHECK(result.next == text.data() + 1);
+
+    // Feeding the rest must yield the remaining events.
+    auto const rest = scan(state, text.substr(1));
+    CHECK(rest.size() == 5);
+}
@@ -23,4 +23,9 @@ unsigned width(char32_t codepoint) noexcept
     return codepoint_properties::get(codepoint).char_width;
 }
 
+unsigned width(char32_t codepoint, codepoint_properties::tables_view const& tables) noexcept
+{
+    return tables.get(codepoint).char_width;
+}
+
 } // namespace unicode
@@ -13,10 +13,16 @@
  */
 #pragma once
 
+#include <libunicode/codepoint_properties.h>
+
 namespace unicode
 {
 
 /// Returns the number of text columns the given codepoint would need to be displayed.
 unsigned width(char32_t codepoint) noexcept;
 
+/// Returns the number of text columns the given codepoint would need to be displayed,
+/// according to the given tables, such as those of a specific Unicode version (see codepoint_versions).
+unsigned width(char32_t codepoint, codepoint_properties::tables_view const& tables) noexcept;
+
 } // namespace unicode
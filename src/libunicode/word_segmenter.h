@@ -64,17 +64,8 @@ class word_segmenter
 
     constexpr bool operator!=(word_segmenter const& rhs) const noexcept { return !(*this == rhs); }
 
-  private:
-    constexpr word_segmenter(iterator begin, iterator end):
-        _left { begin },
-        _right { begin },
-        _state { begin != end ? (isDelimiter(*_right) ? State::NoWord : State::Word) : State::NoWord },
-        _end { end }
-    {
-        ++*this;
-    }
-
-    constexpr bool isDelimiter(char_type character) const noexcept
+    /// Tests whether the given codepoint separates words.
+    static constexpr bool isDelimiter(char_type character) noexcept
     {
         switch (character)
         {
@@ -86,6 +77,16 @@ class word_segmenter
         }
     }
 
+  private:
+    constexpr word_segmenter(iterator begin, iterator end):
+        _left { begin },
+        _right { begin },
+        _state { begin != end ? (isDelimiter(*_right) ? State::NoWord : State::Word) : State::NoWord },
+        _end { end }
+    {
+        ++*this;
+    }
+
     // private fields
     //
     enum class State
@@ -0,0 +1,396 @@
+/**
+ * This file is part of the "libunicode" project
+ *   Copyright (c) 2023 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// clang-format off
+#if defined(__unix__) || defined(__APPLE__)
+    #define LIBUNICODE_TOOLS_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+// clang-format on
+
+/// Bounded-memory input handling for the command line tools.
+///
+/// Input is split into chunks of about chunk_size bytes, each ending after a line feed, which is always
+/// a grapheme cluster boundary. Lines longer than chunk_size are split at a codepoint boundary instead.
+/// Regular files are memory-mapped, anything else (such as pipes) is read chunk by chunk.
+namespace tools
+{
+
+inline constexpr size_t chunk_size = 256 * 1024;
+
+/// A piece of the input.
+struct chunk
+{
+    std::string_view text;
+    size_t byteOffset = 0;                        ///< offset of text in the whole input
+    std::shared_ptr<std::string const> storage {}; ///< owns text, unless it is memory-mapped
+};
+
+/// @returns the length of the longest prefix of @p text of at most @p limit bytes, ending at a chunk boundary.
+inline size_t chunk_length(std::string_view text, size_t limit) noexcept
+{
+    if (text.size() <= limit)
+        return text.size();
+    if (auto const lineFeed = text.substr(0, limit).rfind('\n'); lineFeed != std::string_view::npos)
+        return lineFeed + 1;
+    // Backs up over at most three UTF-8 continuation bytes.
+    auto length = limit;
+    for (int i = 0; i < 3 && length > 0 && (static_cast<uint8_t>(text[length]) & 0xC0) == 0x80; ++i)
+        --length;
+    return length;
+}
+
+/// Sequential source of input chunks, from a file, standard input, or memory.
+class input
+{
+  public:
+    /// Opens the given file, or standard input if @p path is empty or "-".
+    ///
+    /// @throws std::runtime_error if the file cannot be opened.
+    explicit input(std::string const& path)
+    {
+        if (path.empty() || path == "-")
+        {
+            _stream = &std::cin;
+            return;
+        }
+#if defined(LIBUNICODE_TOOLS_MMAP)
+        if (auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); fd != -1)
+        {
+            struct stat st {};
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+            {
+                auto const size = static_cast<size_t>(st.st_size);
+                if (auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED)
+                {
+                    madvise(data, size, MADV_SEQUENTIAL);
+                    _mapped = std::string_view(static_cast<char const*>(data), size);
+                }
+            }
+            ::close(fd);
+            if (_mapped)
+                return;
+        }
+#endif
+        _file = std::make_unique<std::ifstream>(path, std::ios::binary);
+        if (!_file->good())
+            throw std::runtime_error("Could not open file: " + path);
+        _stream = _file.get();
+    }
+
+    /// Uses the given text, which must outlive this input.
+    static input from_memory(std::string_view text) { return input { text }; }
+
+    input(input const&) = delete;
+    input& operator=(input const&) = delete;
+
+    ~input()
+    {
+#if defined(LIBUNICODE_TOOLS_MMAP)
+        if (_mapped)
+            munmap(const_cast<char*>(_mapped->data()), _mapped->size());
+#endif
+    }
+
+    /// @returns whether the input is memory-mapped.
+    [[nodiscard]] bool mapped() const noexcept { return _mapped.has_value(); }
+
+    /// Drops the memory-mapped pages up to the end of @p processed from memory (they are read again if needed),
+    /// so that the resident memory stays bounded for files of any size.
+    void release([[maybe_unused]] chunk const& processed) noexcept
+    {
+#if defined(LIBUNICODE_TOOLS_MMAP)
+        if (!_mapped)
+            return;
+        static auto const pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto const end = (processed.byteOffset + processed.text.size()) / pageSize * pageSize;
+        if (end > _released)
+            madvise(const_cast<char*>(_mapped->data()) + _released, end - _released, MADV_DONTNEED);
+        _released = std::max(_released, end);
+#endif
+    }
+
+    /// @returns the number of bytes returned by next() so far.
+    [[nodiscard]] size_t bytes_read() const noexcept { return _offset; }
+
+    /// @returns the next chunk, or std::nullopt at the end of the input.
+    std::optional<chunk> next()
+    {
+        if (_mapped || !_stream)
+        {
+            auto const text = _mapped ? *_mapped : _memory;
+            if (_offset == text.size())
+                return std::nullopt;
+            auto const length = chunk_length(text.substr(_offset), chunk_size);
+            auto result = chunk { text.substr(_offset, length), _offset };
+            _offset += length;
+            return result;
+        }
+
+        // Reads one byte more than a chunk, to find the same chunk boundaries as in a memory-mapped file.
+        auto buffer = std::string(std::move(_pending));
+        auto const filled = buffer.size();
+        buffer.resize(std::max(chunk_size + 1, filled));
+        _stream->read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        buffer.resize(filled + static_cast<size_t>(_stream->gcount()));
+        if (buffer.empty())
+            return std::nullopt;
+
+        auto const length = chunk_length(buffer, chunk_size);
+        _pending = buffer.substr(length);
+        buffer.resize(length);
+        auto storage = std::make_shared<std::string const>(std::move(buffer));
+        auto result = chunk { *storage, _offset, storage };
+        _offset += length;
+        return result;
+    }
+
+  private:
+    explicit input(std::string_view text): _memory { text } {}
+
+    std::optional<std::string_view> _mapped;
+    std::string_view _memory;
+    std::unique_ptr<std::ifstream> _file;
+    std::istream* _stream = nullptr;
+    std::string _pending; // bytes read past the previous chunk's end
+    size_t _offset = 0;
+    size_t _released = 0; // page-aligned end of the released mapped pages
+};
+
+/// Text output of a chunk, with offsets relative to the chunk start to be made absolute when written.
+///
+/// This allows formatting a chunk's output before the amount of (say) codepoints preceding it is known.
+class chunk_output
+{
+  public:
+    template <typename... Args>
+    void format(fmt::format_string<Args...> formatString, Args&&... args)
+    {
+        fmt::format_to(std::back_inserter(_text), formatString, std::forward<Args>(args)...);
+    }
+
+    void append(std::string_view text) { _text += text; }
+
+    /// Appends @p offset plus the base offset passed to write(), formatted by @p formatString (e.g. "{:>3}"),
+    /// which must have static storage duration, such as a string literal.
+    void offset(size_t offset, fmt::format_string<size_t> formatString = "{}")
+    {
+        _offsets.push_back(relative_offset { _text.size(), offset, formatString });
+    }
+
+    void write(std::ostream& output, size_t baseOffset) const
+    {
+        auto position = size_t { 0 };
+        for (auto const& entry: _offsets)
+        {
+            output.write(_text.data() + position, static_cast<std::streamsize>(entry.position - position));
+            output << fmt::format(entry.formatString, baseOffset + entry.offset);
+            position = entry.position;
+        }
+        output.write(_text.data() + position, static_cast<std::streamsize>(_text.size() - position));
+    }
+
+  private:
+    struct relative_offset
+    {
+        size_t position;
+        size_t offset;
+        fmt::format_string<size_t> formatString;
+    };
+
+    std::string _text;
+    std::vector<relative_offset> _offsets;
+};
+
+/// Processes all chunks of @p source with @p process on @p threadCount worker threads,
+/// passing the results to @p consume in input order.
+///
+/// The workers take the chunks by index from an atomic counter. At most two chunks per thread are in flight
+/// at any time, and chunks are released once consumed, so that memory use is bounded regardless of the input size.
+/// An exception thrown by @p process is rethrown by this function once the workers have stopped.
+template <typename Process, typename Consume>
+void process_chunks(input& source, unsigned threadCount, Process process, Consume consume)
+{
+    using result_type = std::invoke_result_t<Process&, chunk const&>;
+
+    if (threadCount <= 1)
+    {
+        while (auto const c = source.next())
+        {
+            consume(process(*c));
+            source.release(*c);
+        }
+        return;
+    }
+
+    struct slot
+    {
+        chunk piece;
+        std::optional<result_type> result {};
+        std::exception_ptr error {};
+    };
+
+    // Chunk i is kept in window[i % window.size()] from being read until being consumed.
+    auto window = std::vector<slot>(2 * threadCount);
+    auto mutex = std::mutex {};
+    auto changed = std::condition_variable {};
+    auto produced = size_t { 0 }; // guarded by mutex
+    auto exhausted = false;       // guarded by mutex
+    auto consumed = size_t { 0 };
+    auto nextIndex = std::atomic<size_t> { 0 };
+
+    auto const work = [&]() {
+        while (true)
+        {
+            auto const index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+            auto lock = std::unique_lock { mutex };
+            changed.wait(lock, [&] { return index < produced || exhausted; });
+            if (index >= produced)
+                return;
+            auto& current = window[index % window.size()];
+            lock.unlock();
+
+            auto result = std::optional<result_type> {};
+            auto error = std::exception_ptr {};
+            try
+            {
+                result.emplace(process(current.piece));
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            current.result = std::move(result);
+            current.error = std::move(error);
+            lock.unlock();
+            changed.notify_all();
+        }
+    };
+
+    auto workers = std::vector<std::thread> {};
+    auto const stop = [&]() {
+        {
+            auto const _ = std::lock_guard { mutex };
+            exhausted = true;
+        }
+        changed.notify_all();
+        for (auto& worker: workers)
+            worker.join();
+    };
+
+    auto const consumeFront = [&]() {
+        auto& front = window[consumed % window.size()];
+        {
+            auto lock = std::unique_lock { mutex };
+            changed.wait(lock, [&] { return front.result || front.error; });
+        }
+        if (front.error)
+            std::rethrow_exception(front.error);
+        consume(std::move(*front.result));
+        source.release(front.piece);
+        front = slot {};
+        ++consumed;
+    };
+
+    try
+    {
+        for (unsigned i = 0; i < threadCount; ++i)
+            workers.emplace_back(work);
+        while (auto c = source.next())
+        {
+            if (consumed + window.size() == produced)
+                consumeFront();
+            {
+                auto const _ = std::lock_guard { mutex };
+                window[produced % window.size()] = slot { std::move(*c) };
+                ++produced;
+            }
+            changed.notify_all();
+        }
+        {
+            auto const _ = std::lock_guard { mutex };
+            exhausted = true;
+        }
+        changed.notify_all();
+        while (consumed < produced)
+            consumeFront();
+    }
+    catch (...)
+    {
+        stop();
+        throw;
+    }
+    stop();
+}
+
+/// @returns the default number of worker threads.
+inline unsigned default_thread_count() noexcept
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Throughput report as printed with --stats.
+struct input_stats
+{
+    size_t bytes = 0;
+    size_t chunks = 0;
+    std::vector<std::pair<std::string_view, size_t>> counts; ///< e.g. codepoints, grapheme clusters
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    void write(std::ostream& output, bool mapped, unsigned threadCount) const
+    {
+        auto const seconds =
+            std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+        output << fmt::format("{} bytes in {} chunks ({}, {} thread{}), {:.3f} s, {:.1f} MB/s\n",
+                              bytes,
+                              chunks,
+                              mapped ? "mmap" : "read",
+                              threadCount,
+                              threadCount == 1 ? "" : "s",
+                              seconds,
+                              static_cast<double>(bytes) / seconds / 1e6);
+        for (auto const& [name, count]: counts)
+            output << fmt::format("{}: {}\n", name, count);
+    }
+};
+
+} // namespace tools
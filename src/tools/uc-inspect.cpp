@@ -15,21 +15,32 @@
 #include <libunicode/convert.h>
 #include <libunicode/grapheme_segmenter.h>
 #include <libunicode/run_segmenter.h>
+#include <libunicode/scan.h>
+#include <libunicode/script_segmenter.h>
 #include <libunicode/ucd.h>
+#include <libunicode/ucd_fmt.h>
 #include <libunicode/ucd_ostream.h>
 #include <libunicode/utf8.h>
+#include <libunicode/views.h>
 #include <libunicode/width.h>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
 #include <array>
+#include <charconv>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <memory>
+#include <limits>
+#include <map>
 #include <numeric>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "chunked_input.h"
 
 using namespace std::string_literals;
 using namespace std::string_view_literals;
@@ -38,23 +49,15 @@ using std::array;
 using std::basic_string;
 using std::basic_string_view;
 using std::cerr;
-using std::cin;
 using std::cout;
 using std::get;
 using std::holds_alternative;
-using std::ifstream;
-using std::ios;
-using std::istream;
-using std::istreambuf_iterator;
-using std::make_unique;
 using std::optional;
 using std::pair;
 using std::string;
 using std::string_view;
 using std::u32string;
 using std::u32string_view;
-using std::unique_ptr;
-using std::variant;
 
 // {{{ escape(...)
 namespace
@@ -113,32 +116,27 @@ inline string escape(string const& s)
 {
     return escape(begin(s), end(s));
 }
-
-} // namespace
 // }}}
 
-// TODO
-// void grapheme_clusters(istream& _in)
-// {
-//     while (_in.good())
-//     {
-//     }
-// }
+// Output of a chunk, with codepoint offsets relative to the chunk.
+struct chunk_result
+{
+    tools::chunk_output output;
+    size_t codepoints = 0;
+    size_t segments = 0; // grapheme clusters, or (script) runs
+};
 
-void codepoints(istream& in) // {{{
+chunk_result codepoints(tools::chunk const& chunk) // {{{
 {
-    auto lastOffset = 0;
-    auto totalOffset = 0;
+    auto result = chunk_result {};
+    auto lastOffset = size_t { 0 };
+    auto totalOffset = size_t { 0 };
     auto utf8_state = unicode::utf8_decoder_state {};
     auto last_wc = char32_t {};
 
-    for (;;)
+    for (char const byte: chunk.text)
     {
-        uint8_t ch {};
-        in.read((char*) &ch, sizeof(ch));
-        if (!in.good())
-            break;
-
+        auto const ch = static_cast<uint8_t>(byte);
         totalOffset++;
 
         auto const convertResult = from_utf8(utf8_state, ch);
@@ -146,22 +144,23 @@ void codepoints(istream& in) // {{{
         if (holds_alternative<unicode::Success>(convertResult))
         {
             char32_t const wc = get<unicode::Success>(convertResult).value;
-            int const width = unicode::width(wc);
+            auto const width = static_cast<int>(unicode::width(wc));
             bool breakable = !last_wc || unicode::grapheme_segmenter::breakable(last_wc, wc);
             last_wc = wc;
+            ++result.codepoints;
             // TODO: breakable buggy lol what?
             if (width >= 0)
             {
                 string const u8 = escape(unicode::to_utf8(wc));
 
-                cout << fmt::format("{:>3}: U+{:08X} [{}] [{:<10}] {} width:{} UTF8:{}\n",
-                                    lastOffset,
-                                    static_cast<uint32_t>(wc),
-                                    isEmoji(wc) ? "EMOJI" : "TEXT ",
-                                    unicode::script(wc),
-                                    breakable ? "[breakable  ]" : "[unbreakable]",
-                                    width,
-                                    u8);
+                result.output.format("{:>3}: U+{:08X} [{}] [{:<10}] {} width:{} UTF8:{}\n",
+                                     chunk.byteOffset + lastOffset,
+                                     static_cast<uint32_t>(wc),
+                                     isEmoji(wc) ? "EMOJI" : "TEXT ",
+                                     fmt::format("{}", unicode::script(wc)),
+                                     breakable ? "[breakable  ]" : "[unbreakable]",
+                                     width,
+                                     u8);
             }
             lastOffset = totalOffset;
         }
@@ -170,6 +169,7 @@ void codepoints(istream& in) // {{{
             lastOffset = totalOffset;
         }
     }
+    return result;
 } // }}}
 
 using unicode::convert_to;
@@ -190,10 +190,29 @@ string scriptExtensionsString(char32_t codepoint)
     return sstr.str();
 }
 
-int scripts(istream& in) // {{{
+chunk_result graphemes(tools::chunk const& chunk) // {{{
+{
+    auto result = chunk_result {};
+    u32string const codepoints = convert_to<char32_t>(chunk.text);
+    result.codepoints = codepoints.size();
+
+    auto offset = size_t { 0 };
+    for (auto segmenter = unicode::grapheme_segmenter(codepoints); !(*segmenter).empty(); ++segmenter)
+    {
+        auto const cluster = *segmenter;
+        result.output.offset(offset, "{:>6}");
+        result.output.format(": width:{} UTF8:{}\n", unicode::grapheme_cluster_width(cluster), escape(convert_to<char>(cluster)));
+        offset += cluster.size();
+        ++result.segments;
+    }
+    return result;
+} // }}}
+
+chunk_result scripts(tools::chunk const& chunk) // {{{
 {
-    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-    u32string const codepoints = convert_to<char32_t>(string_view(bytes));
+    auto result = chunk_result {};
+    u32string const codepoints = convert_to<char32_t>(chunk.text);
+    result.codepoints = codepoints.size();
 
     unicode::script_segmenter segmenter(codepoints);
 
@@ -201,31 +220,36 @@ int scripts(istream& in) // {{{
     size_t nextPosition {};
     unicode::Script script {};
 
-    cout << "   INDEX     CODEPOINT    TEXT  WIDTH   SCRIPT          SCRIPT EXTS\n";
     while (segmenter.consume(out(nextPosition), out(script)))
     {
-        cout << fmt::format("{}-{}: {}\n", frontPosition, nextPosition - 1, script);
+        result.output.offset(frontPosition);
+        result.output.append("-");
+        result.output.offset(nextPosition - 1);
+        result.output.format(": {}\n", script);
         for (size_t i = frontPosition; i < nextPosition; ++i)
         {
             auto const cp = codepoints[i];
-            cout << fmt::format("    {:>04}:    U+{:08X}   {}\t∆ {}\t{:<12}\t({})\n",
-                                i,
-                                unsigned(cp),
-                                convert_to<char>(cp),
-                                unicode::width(cp),
-                                unicode::script(cp),
-                                scriptExtensionsString(cp));
+            result.output.append("    ");
+            result.output.offset(i, "{:>04}");
+            result.output.format(":    U+{:08X}   {}\t∆ {}\t{:<12}\t({})\n",
+                                 unsigned(cp),
+                                 convert_to<char>(cp),
+                                 unicode::width(cp),
+                                 fmt::format("{}", unicode::script(cp)),
+                                 scriptExtensionsString(cp));
         }
         frontPosition = nextPosition;
+        ++result.segments;
     }
 
-    return EXIT_SUCCESS;
+    return result;
 } // }}}
 
-int runs(istream& in) // {{{
+chunk_result runs(tools::chunk const& chunk) // {{{
 {
-    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-    u32string const codepoints = convert_to<char32_t>(string_view(bytes));
+    auto result = chunk_result {};
+    u32string const codepoints = convert_to<char32_t>(chunk.text);
+    result.codepoints = codepoints.size();
 
     run_segmenter rs(codepoints);
     run_segmenter::range run;
@@ -235,78 +259,420 @@ int runs(istream& in) // {{{
         auto const script = get<unicode::Script>(run.properties);
         auto const presentationStyle = get<unicode::PresentationStyle>(run.properties);
 
-        cout << fmt::format("{}-{} ({}): {} {}\n", run.start, run.end - 1, run.end - run.start, script, presentationStyle);
+        result.output.offset(run.start);
+        result.output.append("-");
+        result.output.offset(run.end - 1);
+        result.output.format(" ({}): {} {}\n", run.end - run.start, script, presentationStyle);
         auto const text32 = u32string_view(codepoints.data() + run.start, run.end - run.start);
         auto const text8 = convert_to<char>(text32);
         auto const textEscaped = replaceAll("\033"sv, "\\033"sv, string_view(text8));
-        cout << '"' << "\033[32m" << textEscaped << "\033[m"
-             << "\"\n\n";
+        result.output.format("\"\033[32m{}\033[m\"\n\n", textEscaped);
+        ++result.segments;
     }
 
-    return EXIT_SUCCESS;
+    return result;
 } // }}}
 
+// {{{ corpus statistics
+// Aggregate statistics of a whole input, as written by the stats command.
+struct corpus_stats
+{
+    size_t bytes = 0;
+    size_t asciiBytes = 0;
+    size_t asciiFastPathBytes = 0; // bytes scan_text() passed as ASCII sequences
+    size_t controlCharacters = 0;
+    size_t invalidSequences = 0; // as reported by scan_text()
+    size_t codepoints = 0;
+    size_t clusters = 0;
+    std::map<size_t, size_t> clusterLengths; // codepoints per grapheme cluster
+    std::map<size_t, size_t> clusterWidths;
+    std::map<unicode::Script, size_t> scripts; // codepoints per script run script
+    size_t emojiClusters = 0;
+    std::unordered_map<u32string, size_t> emoji; // emoji presentation grapheme clusters
+    std::unordered_map<char32_t, uint64_t> frequencies; // only if a frequency profile is requested
+
+    corpus_stats& operator+=(corpus_stats const& other)
+    {
+        bytes += other.bytes;
+        asciiBytes += other.asciiBytes;
+        asciiFastPathBytes += other.asciiFastPathBytes;
+        controlCharacters += other.controlCharacters;
+        invalidSequences += other.invalidSequences;
+        codepoints += other.codepoints;
+        clusters += other.clusters;
+        for (auto const& [length, count]: other.clusterLengths)
+            clusterLengths[length] += count;
+        for (auto const& [width, count]: other.clusterWidths)
+            clusterWidths[width] += count;
+        for (auto const& [script, count]: other.scripts)
+            scripts[script] += count;
+        emojiClusters += other.emojiClusters;
+        for (auto const& [cluster, count]: other.emoji)
+            emoji[cluster] += count;
+        for (auto const& [codepoint, count]: other.frequencies)
+            frequencies[codepoint] += count;
+        return *this;
+    }
+};
+
+// Counts what scan_text() sees. It returns early at control characters (and zero-width grapheme clusters),
+// so it is resumed until the whole text is processed.
+void scanStats(string_view text, corpus_stats& stats)
+{
+    struct counting_receiver final: public unicode::grapheme_cluster_receiver
+    {
+        corpus_stats& stats;
+
+        explicit counting_receiver(corpus_stats& s): stats { s } {}
+
+        void receiveAsciiSequence(string_view sequence) noexcept override { stats.asciiFastPathBytes += sequence.size(); }
+        void receiveGraphemeCluster(string_view, size_t) noexcept override {}
+        void receiveInvalidGraphemeCluster() noexcept override { ++stats.invalidSequences; }
+    };
+
+    auto receiver = counting_receiver { stats };
+    auto state = unicode::scan_state {};
+    auto const* const end = text.data() + text.size();
+    auto const* next = text.data();
+    while (next != end)
+    {
+        auto const remaining = string_view(next, static_cast<size_t>(end - next));
+        (void) unicode::scan_text(state, remaining, std::numeric_limits<size_t>::max(), receiver);
+        if (state.next == next)
+            ++state.next; // skips the control character scan_text() stopped at
+        next = state.next;
+    }
+    if (state.utf8.expectedLength)
+        ++stats.invalidSequences; // incomplete sequence at the end of the input
+}
+
+bool isEmojiPresentation(u32string_view cluster)
+{
+    return unicode::codepoint_properties::get(cluster.front()).emoji_presentation()
+           || cluster.find(char32_t { 0xFE0F }) != u32string_view::npos;
+}
+
+corpus_stats corpusStats(tools::chunk const& chunk, bool withFrequencies)
+{
+    auto stats = corpus_stats {};
+    stats.bytes = chunk.text.size();
+    for (char const ch: chunk.text)
+    {
+        stats.asciiBytes += static_cast<uint8_t>(ch) < 0x80;
+        stats.controlCharacters += static_cast<uint8_t>(ch) < 0x20;
+    }
+    scanStats(chunk.text, stats);
+
+    u32string const codepoints = convert_to<char32_t>(chunk.text);
+    stats.codepoints = codepoints.size();
+
+    for (auto segmenter = unicode::grapheme_segmenter(codepoints); !(*segmenter).empty(); ++segmenter)
+    {
+        auto const cluster = *segmenter;
+        ++stats.clusters;
+        ++stats.clusterLengths[cluster.size()];
+        ++stats.clusterWidths[unicode::grapheme_cluster_width(cluster)];
+        if (isEmojiPresentation(cluster))
+        {
+            ++stats.emojiClusters;
+            ++stats.emoji[u32string(cluster)];
+        }
+    }
+
+    auto segmenter = unicode::script_segmenter(codepoints);
+    auto start = size_t { 0 };
+    auto end = size_t { 0 };
+    auto script = unicode::Script {};
+    while (segmenter.consume(out(end), out(script)))
+    {
+        stats.scripts[script] += end - start;
+        start = end;
+    }
+
+    if (withFrequencies)
+        for (char32_t const codepoint: codepoints)
+            ++stats.frequencies[codepoint];
+
+    return stats;
+}
+
+string jsonString(string_view text)
+{
+    auto result = string { '"' };
+    for (char const ch: text)
+    {
+        if (ch == '"' || ch == '\\')
+            result += fmt::format("\\{}", ch);
+        else if (static_cast<uint8_t>(ch) < 0x20)
+            result += fmt::format("\\u{:04x}", static_cast<unsigned>(ch));
+        else
+            result += ch;
+    }
+    return result + '"';
+}
+
+double ratio(size_t count, size_t total)
+{
+    return total ? static_cast<double>(count) / static_cast<double>(total) : 0.0;
+}
+
+void writeJson(std::ostream& output, corpus_stats const& stats)
+{
+    auto constexpr TopEmojiCount = size_t { 20 };
+
+    auto const writeMap = [&](auto const& map) {
+        auto separator = "";
+        output << '{';
+        for (auto const& [key, count]: map)
+        {
+            output << fmt::format("{}\"{}\": {}", separator, key, count);
+            separator = ", ";
+        }
+        output << '}';
+    };
+
+    output << "{\n";
+    output << fmt::format("  \"bytes\": {},\n", stats.bytes);
+    output << fmt::format("  \"ascii_bytes\": {},\n", stats.asciiBytes);
+    output << fmt::format("  \"ascii_ratio\": {},\n", ratio(stats.asciiBytes, stats.bytes));
+    output << fmt::format("  \"ascii_fast_path_bytes\": {},\n", stats.asciiFastPathBytes);
+    output << fmt::format("  \"ascii_fast_path_ratio\": {},\n", ratio(stats.asciiFastPathBytes, stats.bytes));
+    output << fmt::format("  \"control_characters\": {},\n", stats.controlCharacters);
+    output << fmt::format("  \"invalid_sequences\": {},\n", stats.invalidSequences);
+    output << fmt::format("  \"invalid_sequences_per_mib\": {},\n", ratio(stats.invalidSequences, stats.bytes) * 1024 * 1024);
+    output << fmt::format("  \"codepoints\": {},\n", stats.codepoints);
+
+    output << "  \"grapheme_clusters\": {\n";
+    output << fmt::format("    \"count\": {},\n", stats.clusters);
+    output << fmt::format("    \"average_length\": {},\n", ratio(stats.codepoints, stats.clusters));
+    output << "    \"lengths\": ";
+    writeMap(stats.clusterLengths);
+    output << ",\n    \"widths\": ";
+    writeMap(stats.clusterWidths);
+    output << "\n  },\n";
+
+    auto scripts = std::vector<pair<size_t, string>> {};
+    for (auto const& [script, count]: stats.scripts)
+        scripts.emplace_back(count, fmt::format("{}", script));
+    std::sort(scripts.begin(), scripts.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    output << "  \"scripts\": {";
+    for (size_t i = 0; i < scripts.size(); ++i)
+        output << fmt::format("{}{}: {}", i ? ", " : "", jsonString(scripts[i].second), scripts[i].first);
+    output << "},\n";
+
+    auto emoji = std::vector<pair<size_t, u32string_view>> {};
+    for (auto const& [cluster, count]: stats.emoji)
+        emoji.emplace_back(count, cluster);
+    auto const topCount = std::min(TopEmojiCount, emoji.size());
+    std::partial_sort(emoji.begin(), emoji.begin() + static_cast<std::ptrdiff_t>(topCount), emoji.end(), [](auto a, auto b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    output << "  \"emoji\": {\n";
+    output << fmt::format("    \"clusters\": {},\n", stats.emojiClusters);
+    output << fmt::format("    \"distinct\": {},\n", stats.emoji.size());
+    output << "    \"top\": [";
+    for (size_t i = 0; i < topCount; ++i)
+    {
+        auto codepoints = string {};
+        for (char32_t const codepoint: emoji[i].second)
+            codepoints += fmt::format("{}U+{:04X}", codepoints.empty() ? "" : " ", static_cast<uint32_t>(codepoint));
+        output << fmt::format("{}\n      {{\"text\": {}, \"codepoints\": \"{}\", \"count\": {}}}",
+                              i ? "," : "",
+                              jsonString(convert_to<char>(emoji[i].second)),
+                              codepoints,
+                              emoji[i].first);
+    }
+    output << (topCount ? "\n    ]\n" : "]\n");
+    output << "  }\n";
+    output << "}\n";
+}
+
+// Writes the codepoint frequencies in the format of libunicode_benchmark --frequency-profile,
+// as read by unicode_tablegen --frequencies (LIBUNICODE_FREQUENCY_PROFILE).
+void writeFrequencyProfile(std::ostream& output, corpus_stats const& stats)
+{
+    auto const frequencies = std::map<char32_t, uint64_t>(stats.frequencies.begin(), stats.frequencies.end());
+    output << "# libunicode codepoint frequency profile\n";
+    for (auto const& [codepoint, count]: frequencies)
+        output << fmt::format("U+{:04X} {}\n", static_cast<uint32_t>(codepoint), count);
+}
+// }}}
+
 enum class Cmd
 {
     Codepoints,
+    Graphemes,
     Runs,
     Scripts,
+    Stats,
 };
 
-using InputStream = variant<istream*, unique_ptr<istream>>;
+struct Args
+{
+    Cmd cmd = Cmd::Codepoints;
+    string fileName; // standard input if empty
+    bool stats = false;
+    string frequencyProfileFileName; // stats command only
+    unsigned threadCount = tools::default_thread_count();
+};
 
-auto parseArgs(int argc, char const* argv[]) -> optional<pair<Cmd, InputStream>>
+auto parseArgs(int argc, char const* argv[]) -> optional<Args>
 {
-    auto constexpr DefaultCmd = Cmd::Codepoints;
+    auto args = Args {};
+    int i = 1;
+    for (; i < argc && string_view(argv[i]).starts_with("--"); ++i)
+    {
+        auto const arg = string_view(argv[i]);
+        if (arg == "--stats")
+            args.stats = true;
+        else if (arg.starts_with("--frequency-profile="))
+            args.frequencyProfileFileName = arg.substr("--frequency-profile="sv.size());
+        else if (arg.starts_with("--threads="))
+        {
+            auto const value = arg.substr("--threads="sv.size());
+            auto const [end, ec] = std::from_chars(value.data(), value.data() + value.size(), args.threadCount);
+            if (ec != std::errc {} || end != value.data() + value.size() || args.threadCount == 0)
+                return std::nullopt;
+        }
+        else
+            return std::nullopt;
+    }
 
-    if (argc != 3)
-        return { { DefaultCmd, &cin } };
+    static auto constexpr mappings = array<pair<string_view, Cmd>, 7> {
+        pair { "codepoints"sv, Cmd::Codepoints }, pair { "cp"sv, Cmd::Codepoints }, pair { "graphemes"sv, Cmd::Graphemes },
+        pair { "gc"sv, Cmd::Graphemes },          pair { "runs"sv, Cmd::Runs },     pair { "scripts"sv, Cmd::Scripts },
+        pair { "stats"sv, Cmd::Stats },
+    };
 
-    string_view const arg = argv[1];
+    if (i < argc)
+        for (auto const& mapping: mappings)
+            if (mapping.first == argv[i])
+            {
+                args.cmd = mapping.second;
+                ++i;
+                break;
+            }
 
-    static auto constexpr mappings = array<pair<string_view, Cmd>, 4> { pair { "codepoints"sv, Cmd::Codepoints },
-                                                                        pair { "cp"sv, Cmd::Codepoints },
-                                                                        pair { "runs"sv, Cmd::Runs },
-                                                                        pair { "scripts"sv, Cmd::Scripts } };
+    if (i < argc)
+        args.fileName = argv[i++];
 
-    for (auto const& mapping: mappings)
-        if (mapping.first == arg)
-            return { { mapping.second, make_unique<ifstream>(argv[2], ios::binary) } };
+    if (i < argc || (!args.frequencyProfileFileName.empty() && args.cmd != Cmd::Stats))
+        return std::nullopt;
 
-    return { { DefaultCmd, make_unique<ifstream>(argv[2], ios::binary) } };
+    return args;
 }
 
-int run(int argc, char const* argv[])
+int runStats(tools::input& input, Args const& args)
 {
-    // TODO: hb-inspect codepoints FILE           Inspects source by UTF-32 codepoints
-    // TODO: hb-inspect grapheme-clusters FILE    Inspects source by grapheme cluster
-    // TODO: hb-inspect script-clusters FILE      Inspects source by script cluster
+    auto const withFrequencies = !args.frequencyProfileFileName.empty();
+    auto throughput = tools::input_stats {};
+    auto stats = corpus_stats {};
+    tools::process_chunks(
+        input,
+        args.threadCount,
+        [&](tools::chunk const& chunk) { return corpusStats(chunk, withFrequencies); },
+        [&](corpus_stats const& chunkStats) {
+            stats += chunkStats;
+            ++throughput.chunks;
+        });
+
+    writeJson(cout, stats);
+
+    if (withFrequencies)
+    {
+        auto file = std::ofstream(args.frequencyProfileFileName);
+        if (!file)
+            throw std::runtime_error("Could not write frequency profile: " + args.frequencyProfileFileName);
+        writeFrequencyProfile(file, stats);
+    }
+
+    if (args.stats)
+    {
+        cout.flush();
+        throughput.bytes = input.bytes_read();
+        throughput.counts.emplace_back("codepoints", stats.codepoints);
+        throughput.counts.emplace_back("grapheme clusters", stats.clusters);
+        throughput.write(cerr, input.mapped(), args.threadCount);
+    }
 
+    return EXIT_SUCCESS;
+}
+
+int run(int argc, char const* argv[])
+{
     auto args = parseArgs(argc, argv);
     if (!args.has_value())
     {
         cerr << "Usage error.\n"
              << "Usage:\n"
-             << "    uc-inspect codepoints FILE\n"
-             << "    uc-inspect runs FILE\n"
-             << "    uc-inspect scripts FILE\n";
+             << "    uc-inspect [OPTIONS] codepoints [FILE]    Inspects source by UTF-32 codepoints\n"
+             << "    uc-inspect [OPTIONS] graphemes [FILE]     Inspects source by grapheme cluster\n"
+             << "    uc-inspect [OPTIONS] runs [FILE]          Inspects source by script and emoji presentation runs\n"
+             << "    uc-inspect [OPTIONS] scripts [FILE]       Inspects source by script runs\n"
+             << "    uc-inspect [OPTIONS] stats [FILE]         Writes statistics of the whole source as JSON\n"
+             << "\n"
+             << "Reads standard input if FILE is omitted or \"-\". The input is processed in chunks ending at\n"
+             << "line feeds, so runs do not extend across chunks (about every 256 KiB).\n"
+             << "\n"
+             << "Options:\n"
+             << "    --stats                     Prints the input size, throughput and segment counts to standard error.\n"
+             << "    --threads=N                 Processes the input on N threads (default: number of CPUs).\n"
+             << "    --frequency-profile=FILE    With stats, also writes a codepoint frequency profile to FILE,\n"
+             << "                                as used by unicode_tablegen --frequencies.\n";
         return EXIT_FAILURE;
     }
 
-    auto& [cmd, inputStreamVar] = *args;
-    istream& in =
-        holds_alternative<istream*>(inputStreamVar) ? *get<istream*>(inputStreamVar) : *get<unique_ptr<istream>>(inputStreamVar);
+    std::ios::sync_with_stdio(false);
+    auto input = tools::input(args->fileName);
+    if (args->cmd == Cmd::Stats)
+        return runStats(input, *args);
 
-    switch (cmd)
+    auto process = [&](tools::chunk const& chunk) {
+        switch (args->cmd)
+        {
+            case Cmd::Codepoints: return codepoints(chunk);
+            case Cmd::Graphemes: return graphemes(chunk);
+            case Cmd::Runs: return runs(chunk);
+            case Cmd::Scripts: return scripts(chunk);
+            case Cmd::Stats: break;
+        }
+        return chunk_result {};
+    };
+
+    if (args->cmd == Cmd::Scripts)
+        cout << "   INDEX     CODEPOINT    TEXT  WIDTH   SCRIPT          SCRIPT EXTS\n";
+
+    auto stats = tools::input_stats {};
+    auto codepointCount = size_t { 0 };
+    auto segmentCount = size_t { 0 };
+    tools::process_chunks(input, args->threadCount, process, [&](chunk_result const& result) {
+        result.output.write(cout, codepointCount);
+        codepointCount += result.codepoints;
+        segmentCount += result.segments;
+        ++stats.chunks;
+    });
+
+    if (args->stats)
     {
-        case Cmd::Codepoints: codepoints(in); break;
-        case Cmd::Runs: runs(in); break;
-        case Cmd::Scripts: scripts(in); break;
+        cout.flush();
+        stats.bytes = input.bytes_read();
+        stats.counts.emplace_back("codepoints", codepointCount);
+        switch (args->cmd)
+        {
+            case Cmd::Codepoints: break;
+            case Cmd::Graphemes: stats.counts.emplace_back("grapheme clusters", segmentCount); break;
+            case Cmd::Runs: stats.counts.emplace_back("runs", segmentCount); break;
+            case Cmd::Scripts: stats.counts.emplace_back("script runs", segmentCount); break;
+            case Cmd::Stats: break;
+        }
+        stats.write(cerr, input.mapped(), args->threadCount);
     }
 
     return EXIT_SUCCESS;
 }
 
+} // namespace
+
 int main(int argc, char const* argv[])
 {
     try
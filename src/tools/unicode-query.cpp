@@ -34,6 +34,8 @@
     #include <unistd.h>
 #endif
 
+#include "chunked_input.h"
+
 using namespace std;
 
 namespace
@@ -74,7 +76,8 @@ int printUsage(int exitCode)
 {
     cout << "unicode-query [properties] U+XXXX [...]\n"
          << "              gc [-e] [--] \"Text string\"\n"
-         << "              runs [-e] [--] \"Text string\"\n";
+         << "              runs [-e] [--stats] [--threads=N] [--] \"Text string\"\n"
+         << "              runs [-e] [--stats] [--threads=N] -f FILE    (FILE may be - for standard input)\n";
     return exitCode;
 }
 
@@ -142,7 +145,9 @@ void showCodepointProperties(char32_t codepoint)
     auto const properties = unicode::codepoint_properties::get(codepoint);
 
     // clang-format off
+#if !defined(LIBUNICODE_NO_NAMES)
     cout << "Name                        : " << unicode::codepoint_properties::name(codepoint) << '\n';
+#endif
     cout << "Unicode Version             : " << prettyAge(properties.age) << '\n';
     cout << "Codepoint                   : U+" << hex << uint32_t(codepoint) << '\n';
     cout << "UTF-8                       : " << quotedAndEscaped(unicode::convert_to<char>(codepoint)) << '\n';
@@ -213,10 +218,18 @@ int showGraphemeClusters(int argc, char const* argv[])
 // }}}
 
 // {{{ runs
-int showRuns(istream& in, bool escapeRunText)
+struct runs_result
+{
+    tools::chunk_output output; // with codepoint offsets relative to the chunk
+    size_t codepoints = 0;
+    size_t runs = 0;
+};
+
+runs_result showRuns(tools::chunk const& chunk, bool escapeRunText)
 {
-    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-    u32string const codepoints = unicode::convert_to<char32_t>(string_view(bytes));
+    auto result = runs_result {};
+    u32string const codepoints = unicode::convert_to<char32_t>(chunk.text);
+    result.codepoints = codepoints.size();
 
     unicode::run_segmenter rs(codepoints);
     unicode::run_segmenter::range run;
@@ -230,24 +243,67 @@ int showRuns(istream& in, bool escapeRunText)
         auto const text8 = unicode::convert_to<char>(text32);
         auto const textEscaped = escapeRunText ? escaped(text8) : escapeControlCodes(text8);
 
-        cout << run.start << "-" << run.end - 1 << " (" << run.end - run.start << "): " << script << " " << presentationStyle
-             << "\n"
-             << '"' << seq("\033[32m") << textEscaped << seq("\033[m") << "\"\n\n";
+        result.output.offset(run.start);
+        result.output.append("-");
+        result.output.offset(run.end - 1);
+        result.output.format(" ({}): {} {}\n", run.end - run.start, script, presentationStyle);
+        result.output.format("\"{}{}{}\"\n\n", seq("\033[32m"), textEscaped, seq("\033[m"));
+        ++result.runs;
     }
 
-    return EXIT_SUCCESS;
+    return result;
+}
+
+void showRuns(tools::input& in, bool escapeRunText, unsigned threadCount, bool showStats)
+{
+    auto stats = tools::input_stats {};
+    auto codepointCount = size_t { 0 };
+    auto runCount = size_t { 0 };
+    tools::process_chunks(
+        in,
+        threadCount,
+        [&](tools::chunk const& chunk) { return showRuns(chunk, escapeRunText); },
+        [&](runs_result const& result) {
+            result.output.write(cout, codepointCount);
+            codepointCount += result.codepoints;
+            runCount += result.runs;
+            ++stats.chunks;
+        });
+
+    if (showStats)
+    {
+        cout.flush();
+        stats.bytes = in.bytes_read();
+        stats.counts.emplace_back("codepoints", codepointCount);
+        stats.counts.emplace_back("runs", runCount);
+        stats.write(cerr, in.mapped(), threadCount);
+    }
 }
 
 int showRuns(int argc, char const* argv[])
 {
-    // [-e]
+    // [-e] [-f FILE] [--stats] [--threads=N]
     int i = 0;
     bool escaped = false;
+    bool showStats = false;
+    auto threadCount = tools::default_thread_count();
+    auto fileName = optional<string> {};
     for (; i < argc; ++i)
     {
         auto const arg = string_view(argv[i]);
         if (arg == "-e")
             escaped = true;
+        else if (arg == "-f" && i + 1 < argc)
+            fileName = argv[++i];
+        else if (arg == "--stats")
+            showStats = true;
+        else if (arg.starts_with("--threads="))
+        {
+            auto const value = arg.substr("--threads="sv.size());
+            auto const [end, ec] = std::from_chars(value.data(), value.data() + value.size(), threadCount);
+            if (ec != std::errc {} || end != value.data() + value.size() || threadCount == 0)
+                return printUsage(EXIT_FAILURE);
+        }
         else if (arg == "--")
         {
             ++i;
@@ -259,10 +315,18 @@ int showRuns(int argc, char const* argv[])
             break;
     }
 
+    if (fileName)
+    {
+        if (i != argc)
+            return printUsage(EXIT_FAILURE);
+        auto in = tools::input(*fileName);
+        showRuns(in, escaped, threadCount, showStats);
+    }
+
     for (; i < argc; ++i)
     {
-        auto in = std::istringstream(argv[i]);
-        showRuns(in, escaped);
+        auto in = tools::input::from_memory(argv[i]);
+        showRuns(in, escaped, threadCount, showStats);
     }
 
     return EXIT_SUCCESS;